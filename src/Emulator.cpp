@@ -1,15 +1,26 @@
 #include "Emulator.hpp"
+#include "core/PpuBandRenderer.hpp"
 #include <emscripten.h>
 #include <iostream>
+#include <algorithm>
 
 Emulator::Emulator()
     : shouldRun(false)
+    , presentRequired(true)
+    , dirtyRowTracker()
+    , outputFormat(PpuOutputFormat::Rgba32)
+    , ppuConfig()
+    , textureWidth(0)
+    , textureHeight(0)
+    , ntscFilter()
+    , filteredPixels()
+    , scaler()
+    , scaledPixels()
+    , channelTapSamples()
+    , audioDevice(0)
+    , lastAudioSample(0.0f)
 {
-    auto irqTriggerCallback = [this]() {
-        cpu->interrupt(InterruptType::IRQ);
-    };
-
-    apu = std::make_shared<Apu>(irqTriggerCallback);
+    apu = std::make_shared<Apu>();
     controllers = std::make_shared<Controllers>();
     cartridge = std::make_shared<Cartridge>();
     
@@ -17,8 +28,12 @@ Emulator::Emulator()
         cpu->interrupt(InterruptType::NMI);
     };
 
+    // Frames are taken from the PPU by the presenter in render().
+    // Output format is only switched between frames, so that a single frame is never mixed.
     auto vblankInterruptCallback = [this](){
-        updateScreen();
+        if (ppu->getOutputFormat() != outputFormat) {
+            ppu->setOutputFormat(outputFormat);
+        }
     };
 
     ppu = std::make_shared<Ppu>(cartridge, nmiTriggerCallback, vblankInterruptCallback);
@@ -35,79 +50,23 @@ Emulator::Emulator()
     SDL_RenderSetLogicalSize(renderer.get(), Ppu::SCREEN_WIDTH, Ppu::SCREEN_HEIGHT);
     currentViewport = SDL_Rect { 0, 0, Ppu::SCREEN_WIDTH, Ppu::SCREEN_HEIGHT };
 
-    texture = make_sdl_resource(SDL_CreateTexture, SDL_DestroyTexture, renderer.get(),
-        SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STREAMING, Ppu::SCREEN_WIDTH, Ppu::SCREEN_HEIGHT);
-
-    u32 format = 0;
-    SDL_QueryTexture(texture.get(), &format, nullptr, nullptr, nullptr);
-    auto pixelFormat = make_sdl_resource(SDL_AllocFormat, SDL_FreeFormat, format);
-
-    colors = {
-        SDL_MapRGB(pixelFormat.get(), 0x66, 0x66, 0x66), 
-        SDL_MapRGB(pixelFormat.get(), 0x00, 0x2A, 0x88), 
-        SDL_MapRGB(pixelFormat.get(), 0x14, 0x12, 0xA7), 
-        SDL_MapRGB(pixelFormat.get(), 0x3B, 0x00, 0xA4),
-        SDL_MapRGB(pixelFormat.get(), 0x5C, 0x00, 0x7E), 
-        SDL_MapRGB(pixelFormat.get(), 0x6E, 0x00, 0x40), 
-        SDL_MapRGB(pixelFormat.get(), 0x6C, 0x06, 0x00), 
-        SDL_MapRGB(pixelFormat.get(), 0x56, 0x1D, 0x00),
-        SDL_MapRGB(pixelFormat.get(), 0x33, 0x35, 0x00), 
-        SDL_MapRGB(pixelFormat.get(), 0x0B, 0x48, 0x00), 
-        SDL_MapRGB(pixelFormat.get(), 0x00, 0x52, 0x00), 
-        SDL_MapRGB(pixelFormat.get(), 0x00, 0x4F, 0x08),
-        SDL_MapRGB(pixelFormat.get(), 0x00, 0x40, 0x4D), 
-        SDL_MapRGB(pixelFormat.get(), 0x00, 0x00, 0x00), 
-        SDL_MapRGB(pixelFormat.get(), 0x00, 0x00, 0x00), 
-        SDL_MapRGB(pixelFormat.get(), 0x00, 0x00, 0x00),
-        SDL_MapRGB(pixelFormat.get(), 0xAD, 0xAD, 0xAD), 
-        SDL_MapRGB(pixelFormat.get(), 0x15, 0x5F, 0xD9), 
-        SDL_MapRGB(pixelFormat.get(), 0x42, 0x40, 0xFF), 
-        SDL_MapRGB(pixelFormat.get(), 0x75, 0x27, 0xFE),
-        SDL_MapRGB(pixelFormat.get(), 0xA0, 0x1A, 0xCC), 
-        SDL_MapRGB(pixelFormat.get(), 0xB7, 0x1E, 0x7B), 
-        SDL_MapRGB(pixelFormat.get(), 0xB5, 0x31, 0x20), 
-        SDL_MapRGB(pixelFormat.get(), 0x99, 0x3E, 0x00),
-        SDL_MapRGB(pixelFormat.get(), 0x6B, 0x6D, 0x00), 
-        SDL_MapRGB(pixelFormat.get(), 0x38, 0x87, 0x00), 
-        SDL_MapRGB(pixelFormat.get(), 0x0C, 0x93, 0x00), 
-        SDL_MapRGB(pixelFormat.get(), 0x00, 0x8F, 0x32),
-        SDL_MapRGB(pixelFormat.get(), 0x00, 0x7C, 0x8D), 
-        SDL_MapRGB(pixelFormat.get(), 0x00, 0x00, 0x00), 
-        SDL_MapRGB(pixelFormat.get(), 0x00, 0x00, 0x00), 
-        SDL_MapRGB(pixelFormat.get(), 0x00, 0x00, 0x00),
-        SDL_MapRGB(pixelFormat.get(), 0xFF, 0xFE, 0xFF), 
-        SDL_MapRGB(pixelFormat.get(), 0x64, 0xB0, 0xFF), 
-        SDL_MapRGB(pixelFormat.get(), 0x92, 0x90, 0xFF), 
-        SDL_MapRGB(pixelFormat.get(), 0xC6, 0x76, 0xFF),
-        SDL_MapRGB(pixelFormat.get(), 0xF3, 0x6A, 0xFF), 
-        SDL_MapRGB(pixelFormat.get(), 0xFE, 0x6E, 0xCC), 
-        SDL_MapRGB(pixelFormat.get(), 0xFE, 0x81, 0x70), 
-        SDL_MapRGB(pixelFormat.get(), 0xEA, 0x9E, 0x22),
-        SDL_MapRGB(pixelFormat.get(), 0xBC, 0xBE, 0x00), 
-        SDL_MapRGB(pixelFormat.get(), 0x88, 0xD8, 0x00), 
-        SDL_MapRGB(pixelFormat.get(), 0x5C, 0xE4, 0x30), 
-        SDL_MapRGB(pixelFormat.get(), 0x45, 0xE0, 0x82),
-        SDL_MapRGB(pixelFormat.get(), 0x48, 0xCD, 0xDE), 
-        SDL_MapRGB(pixelFormat.get(), 0x4F, 0x4F, 0x4F), 
-        SDL_MapRGB(pixelFormat.get(), 0x00, 0x00, 0x00), 
-        SDL_MapRGB(pixelFormat.get(), 0x00, 0x00, 0x00),
-        SDL_MapRGB(pixelFormat.get(), 0xFF, 0xFE, 0xFF), 
-        SDL_MapRGB(pixelFormat.get(), 0xC0, 0xDF, 0xFF), 
-        SDL_MapRGB(pixelFormat.get(), 0xD3, 0xD2, 0xFF), 
-        SDL_MapRGB(pixelFormat.get(), 0xE8, 0xC8, 0xFF),
-        SDL_MapRGB(pixelFormat.get(), 0xFB, 0xC2, 0xFF), 
-        SDL_MapRGB(pixelFormat.get(), 0xFE, 0xC4, 0xEA), 
-        SDL_MapRGB(pixelFormat.get(), 0xFE, 0xCC, 0xC5), 
-        SDL_MapRGB(pixelFormat.get(), 0xF7, 0xD8, 0xA5),
-        SDL_MapRGB(pixelFormat.get(), 0xE4, 0xE5, 0x94), 
-        SDL_MapRGB(pixelFormat.get(), 0xCF, 0xEF, 0x96), 
-        SDL_MapRGB(pixelFormat.get(), 0xBD, 0xF4, 0xAB), 
-        SDL_MapRGB(pixelFormat.get(), 0xB3, 0xF3, 0xCC),
-        SDL_MapRGB(pixelFormat.get(), 0xB5, 0xEB, 0xF2), 
-        SDL_MapRGB(pixelFormat.get(), 0xB8, 0xB8, 0xB8), 
-        SDL_MapRGB(pixelFormat.get(), 0x00, 0x00, 0x00), 
-        SDL_MapRGB(pixelFormat.get(), 0x00, 0x00, 0x00)
-    };
+    createTexture(Ppu::SCREEN_WIDTH, Ppu::SCREEN_HEIGHT);
+
+    // PPU writes colors directly in the texture pixel format,
+    // so there's no need for a separate conversion pass
+    ppu->setOutputFormat(outputFormat);
+
+    // When built with threads, pixels are rendered on worker threads and the emulation thread only keeps the timing
+    if (PpuBandRenderer::getDefaultThreadCount() > 0) {
+        ppu->setRenderMode(PpuRenderMode::Deferred);
+    }
+}
+
+Emulator::~Emulator()
+{
+    if (audioDevice != 0) {
+        SDL_CloseAudioDevice(audioDevice);
+    }
 }
 
 void Emulator::reset()
@@ -118,8 +77,11 @@ void Emulator::reset()
 
 void Emulator::loadRom(const std::string &filename)
 {
+    // Workers may still read CHR-ROM of the previous cartridge
+    ppu->flushRendering();
     auto file = std::ifstream(filename, std::ios::binary);
     cartridge->loadFromFile(std::move(file));
+    ppu->setConfig(ppuConfig);
     reset();
 }
 
@@ -155,12 +117,13 @@ void Emulator::handleWindowEvent(const SDL_WindowEvent& windowEvent)
         std::cout << "Wievport adjusted (W: " << newWidth << ", H: " << newHeight << ")" << std::endl;
         currentViewport = SDL_Rect { 0, 0, newWidth, newHeight };
         SDL_RenderSetLogicalSize(renderer.get(), newWidth, newHeight);
+        presentRequired = true;
     }
 }
 
 void Emulator::update(u32 millisElapsed)
 {
-    static constexpr unsigned const CYCLES_PER_MILLISECOND = CPU_CYCLES_PER_SECOND / 1000;
+    static constexpr unsigned const CYCLES_PER_MILLISECOND = Apu::CPU_CLOCK_RATE / 1000;
     unsigned cyclesToExecute = CYCLES_PER_MILLISECOND * millisElapsed;
     unsigned cyclesExecuted = 0;
     while(cyclesExecuted < cyclesToExecute) {
@@ -170,9 +133,150 @@ void Emulator::update(u32 millisElapsed)
 
 void Emulator::render()
 {
+    if(ppu->hasNewFrame() && updateScreen()) {
+        presentRequired = true;
+    }
+    // Presenting is skipped when nothing changed on the screen since the last time
+    if(!presentRequired) {
+        return;
+    }
     SDL_RenderClear(renderer.get());
     SDL_RenderCopy(renderer.get(), texture.get(), nullptr, &currentViewport);
     SDL_RenderPresent(renderer.get());
+    presentRequired = false;
+}
+
+/**
+ * Opens the audio device, that pulls samples produced by the APU from its audio buffer.
+ * Requires SDL audio subsystem to be initialized.
+ */
+void Emulator::startAudio()
+{
+    if (audioDevice != 0) {
+        return;
+    }
+    SDL_AudioSpec desired {};
+    desired.freq = static_cast<int>(apu->getSampleRate());
+    desired.format = AUDIO_F32;
+    desired.channels = 1;
+    desired.samples = AUDIO_CALLBACK_SAMPLES;
+    desired.callback = audioCallback;
+    desired.userdata = this;
+    audioDevice = SDL_OpenAudioDevice(nullptr, 0, &desired, nullptr, 0);
+    if (audioDevice == 0) {
+        std::cerr << "Failed to open audio device" << std::endl;
+        return;
+    }
+    // Emulation is paced by the display, so the APU follows the clock of the audio device by adjusting its sample rate
+    apu->setAudioBufferTarget(AUDIO_BUFFER_TARGET_SAMPLES);
+    SDL_PauseAudioDevice(audioDevice, 0);
+}
+
+/**
+ * Called by SDL whenever the audio device needs more samples, possibly from a separate thread.
+ * When APU didn't produce enough samples, the rest is filled with the last sample to avoid clicks.
+ */
+void Emulator::audioCallback(void* userdata, Uint8* stream, int length)
+{
+    auto* emulator = static_cast<Emulator*>(userdata);
+    auto* samples = reinterpret_cast<float*>(stream);
+    const auto count = static_cast<unsigned>(length) / sizeof(float);
+    const auto read = emulator->apu->getAudioBuffer().read(samples, count);
+    if (read > 0) {
+        emulator->lastAudioSample = samples[read - 1];
+    }
+    std::fill(samples + read, samples + count, emulator->lastAudioSample);
+}
+
+/**
+ * Amount of times APU produced samples that didn't fit into the audio buffer.
+ */
+u64 Emulator::getAudioOverrunCount() const
+{
+    return apu->getAudioBuffer().getOverrunCount();
+}
+
+/**
+ * Amount of times the audio device asked for more samples than APU has produced.
+ */
+u64 Emulator::getAudioUnderrunCount() const
+{
+    return apu->getAudioBuffer().getUnderrunCount();
+}
+
+/**
+ * Turns the sound on or off. Without sound APU only emulates what the game can observe,
+ * which is cheaper for fast forwarding. Audio device is paused meanwhile.
+ */
+void Emulator::setAudioEnabled(bool enabled)
+{
+    apu->setAudioEnabled(enabled);
+    if (audioDevice != 0) {
+        SDL_PauseAudioDevice(audioDevice, enabled ? 0 : 1);
+    }
+}
+
+/**
+ * Switches between the band-limited synthesis of the audio and sampling at the native rate of the APU,
+ * that is decimated to the rate of the audio device.
+ */
+void Emulator::setNativeRateAudio(bool enabled)
+{
+    apu->setSynthesisMode(enabled ? ApuSynthesisMode::NativeRate : ApuSynthesisMode::BandLimited);
+}
+
+/**
+ * Average time in milliseconds that decimation of a block of native rate samples takes.
+ */
+double Emulator::getAudioBlockTime() const
+{
+    return apu->getDecimator().getAverageBlockTime();
+}
+
+/**
+ * Silences the channels given by the mask, bits follow the order of the APU status register.
+ */
+void Emulator::setMutedChannels(u8 mask)
+{
+    apu->setMutedChannels(mask);
+}
+
+/**
+ * Plays only the channels given by the mask, empty mask plays all the channels that are not muted.
+ */
+void Emulator::setSoloChannels(u8 mask)
+{
+    apu->setSoloChannels(mask);
+}
+
+/**
+ * Starts recording the waveforms of the individual channels at the given rate, zero stops it.
+ */
+void Emulator::setChannelTapRate(unsigned rate)
+{
+    apu->setChannelTapRate(rate);
+    // Whole tap fits, so a single read drains it at any rate
+    channelTapSamples.resize(rate ? Apu::CHANNEL_TAP_CAPACITY : 0);
+}
+
+/**
+ * Takes the samples recorded for the given channel since the last read.
+ * Returns their amount, samples are then available through getChannelTapSamples().
+ */
+unsigned Emulator::readChannelTap(unsigned channel)
+{
+    auto* channelTaps = apu->getChannelTaps();
+    if (!channelTaps || channel >= Apu::CHANNEL_COUNT) {
+        return 0;
+    }
+    auto& buffer = channelTaps->getBuffer(channel);
+    const auto count = std::min<unsigned>(buffer.getSize(), channelTapSamples.size());
+    return buffer.read(channelTapSamples.data(), count);
+}
+
+const float* Emulator::getChannelTapSamples() const
+{
+    return channelTapSamples.data();
 }
 
 bool Emulator::shouldBeRunning() const
@@ -180,15 +284,127 @@ bool Emulator::shouldBeRunning() const
     return window && renderer && texture;
 }
 
-void Emulator::updateScreen()
+/**
+ * Returns the amount of frames which were identical to the presented one,
+ * thus texture upload and presenting was skipped for them.
+ */
+u64 Emulator::getSkippedFrameCount() const
+{
+    return dirtyRowTracker.getSkippedFrameCount();
+}
+
+/**
+ * Enables or disables NTSC composite video filter.
+ * When enabled, PPU outputs palette indices with emphasis bits that are the input of the filter.
+ */
+void Emulator::setNtscFilter(bool enabled)
+{
+    if (enabled && !ntscFilter) {
+        ntscFilter = std::make_unique<NtscFilter>();
+        filteredPixels.resize(NtscFilter::OUTPUT_WIDTH * Ppu::SCREEN_HEIGHT);
+    }
+    outputFormat = enabled ? PpuOutputFormat::Indexed9 : PpuOutputFormat::Rgba32;
+}
+
+/**
+ * Sets the sprite limit and the visible window of the PPU. 
+ * Takes effect from the next ROM load, so that no frame is rendered with the mixed configuration.
+ */
+void Emulator::setPpuConfig(const PpuConfig& config)
+{
+    ppuConfig = config;
+}
+
+/**
+ * Enables software scaling of the picture with the given filter. 
+ * Scaling is not applied when NTSC filter is enabled.
+ * Returns false when the filter is not known, scaling then stays as it was.
+ */
+bool Emulator::setScaler(ScalerFilter filter, unsigned factor)
 {
-    u32* renderBuffer = nullptr;
-    SDL_LockTexture(texture.get(), nullptr, reinterpret_cast<void**>(&renderBuffer), nullptr);
-    const auto framebuffer = ppu->getFramebuffer();
-    for(auto i = 0; i < framebuffer.size(); i++) {
-        renderBuffer[i] = colors[framebuffer[i]];
+    const bool created = !scaler;
+    if (created) {
+        scaler = std::make_unique<Scaler>();
+    }
+    if (!scaler->setFilter(filter, factor)) {
+        if (created) {
+            scaler.reset();
+        }
+        return false;
     }
-    SDL_UnlockTexture(texture.get());
+    dirtyRowTracker.invalidate();
+    return true;
+}
+
+/**
+ * Disables software scaling, picture is scaled by the renderer only.
+ */
+void Emulator::disableScaler()
+{
+    scaler.reset();
+    dirtyRowTracker.invalidate();
+}
+
+/**
+ * Average time in milliseconds that software scaling of the frame takes.
+ */
+double Emulator::getScalerFrameTime() const
+{
+    return scaler ? scaler->getAverageFrameTime() : 0.0;
+}
+
+/**
+ * Uploads rows of the latest frame, that differ from the presented frame, into the texture.
+ * Returns false when the frame is identical to the presented one.
+ */
+bool Emulator::updateScreen()
+{
+    const auto& frame = ppu->getFrame();
+    const auto filtered = frame.format == PpuOutputFormat::Indexed9;
+    const auto scaled = !filtered && scaler;
+    const auto factor = scaled ? scaler->getFactor() : 1;
+    const auto width = (filtered ? NtscFilter::OUTPUT_WIDTH : Ppu::SCREEN_WIDTH) * factor;
+    const auto height = Ppu::SCREEN_HEIGHT * factor;
+    if (width != textureWidth || height != textureHeight) {
+        createTexture(width, height);
+        dirtyRowTracker.invalidate();
+    }
+    // Scaled rows also depend on their neighbours
+    const auto dirtyRows = dirtyRowTracker.update(frame.rowHashes, scaled ? scaler->getMargin() : 0);
+    if (!dirtyRows) {
+        return false;
+    }
+
+    const auto firstDirtyRow = dirtyRows->first;
+    const auto dirtyRowCount = dirtyRows->count;
+    auto dirtyRect = SDL_Rect { 0, static_cast<int>(firstDirtyRow * factor), static_cast<int>(width), static_cast<int>(dirtyRowCount * factor) };
+    if (filtered) {
+        // Filter works on each row separately, so only dirty rows have to be filtered
+        auto* pixels = filteredPixels.data() + firstDirtyRow * width;
+        ntscFilter->apply(frame.pixels.data(), firstDirtyRow, dirtyRowCount, pixels);
+        SDL_UpdateTexture(texture.get(), &dirtyRect, pixels, width * sizeof(u32));
+    } else if (scaled) {
+        scaledPixels.resize(width * height);
+        scaler->scale(reinterpret_cast<const u32*>(frame.pixels.data()), Ppu::SCREEN_WIDTH, Ppu::SCREEN_HEIGHT,
+            firstDirtyRow, dirtyRowCount, scaledPixels.data());
+        SDL_UpdateTexture(texture.get(), &dirtyRect, scaledPixels.data() + dirtyRect.y * width, width * sizeof(u32));
+    } else {
+        auto pitch = width * Ppu::getBytesPerPixel(frame.format);
+        SDL_UpdateTexture(texture.get(), &dirtyRect, frame.pixels.data() + firstDirtyRow * pitch, pitch);
+    }
+    return true;
+}
+
+/**
+ * (Re)creates streaming texture frames are uploaded into. 
+ * Texture is always stretched over the whole viewport, so its size only depends on the active filter and scaler.
+ */
+void Emulator::createTexture(unsigned width, unsigned height)
+{
+    texture = make_sdl_resource(SDL_CreateTexture, SDL_DestroyTexture, renderer.get(),
+        SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STREAMING, width, height);
+    textureWidth = width;
+    textureHeight = height;
 }
 
 u8 Emulator::sdlKeyToNesIndex(SDL_Scancode scancode)
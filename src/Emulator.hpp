@@ -6,14 +6,19 @@
 #include "core/Cartridge.hpp"
 #include "core/Controllers.hpp"
 #include "core/Apu.hpp"
+#include "video/DirtyRowTracker.hpp"
+#include "video/NtscFilter.hpp"
+#include "video/Scaler.hpp"
 #include "SdlResource.hpp"
 
+#include <vector>
+
 class Emulator
 {
     public:
         Emulator();
 
-        ~Emulator() = default;
+        ~Emulator();
 
         void reset();
 
@@ -25,8 +30,42 @@ class Emulator
 
         void render();
 
+        void startAudio();
+
+        u64 getAudioOverrunCount() const;
+
+        u64 getAudioUnderrunCount() const;
+
+        void setAudioEnabled(bool enabled);
+
+        void setNativeRateAudio(bool enabled);
+
+        double getAudioBlockTime() const;
+
+        void setMutedChannels(u8 mask);
+
+        void setSoloChannels(u8 mask);
+
+        void setChannelTapRate(unsigned rate);
+
+        unsigned readChannelTap(unsigned channel);
+
+        const float* getChannelTapSamples() const;
+
         bool shouldBeRunning() const;
 
+        u64 getSkippedFrameCount() const;
+
+        void setNtscFilter(bool enabled);
+
+        void setPpuConfig(const PpuConfig& config);
+
+        bool setScaler(ScalerFilter filter, unsigned factor);
+
+        void disableScaler();
+
+        double getScalerFrameTime() const;
+
     private:
         std::shared_ptr<Cpu> cpu;
         std::shared_ptr<Mmu> mmu;
@@ -41,14 +80,34 @@ class Emulator
         SdlResource<SDL_Window> window;
         SdlResource<SDL_Renderer> renderer;
 
-        void updateScreen();
+        bool updateScreen();
+        void createTexture(unsigned width, unsigned height);
         u8 sdlKeyToNesIndex(SDL_Scancode scancode);
 
         void handleInputEvent(const SDL_Event& e);
         void handleWindowEvent(const SDL_WindowEvent& e);
 
-        std::array<u32, 64> colors;
-        SDL_Rect currentViewport;
+        static void audioCallback(void* userdata, Uint8* stream, int length);
 
-        static constexpr const unsigned CPU_CYCLES_PER_SECOND = 1790000;
+        SDL_Rect currentViewport;
+        SDL_AudioDeviceID audioDevice;
+        float lastAudioSample;
+
+        bool presentRequired;
+        DirtyRowTracker dirtyRowTracker;
+
+        PpuOutputFormat outputFormat;
+        PpuConfig ppuConfig;
+        unsigned textureWidth;
+        unsigned textureHeight;
+        std::unique_ptr<NtscFilter> ntscFilter;
+        std::vector<u32> filteredPixels;
+        std::unique_ptr<Scaler> scaler;
+        std::vector<u32> scaledPixels;
+        // Samples of the channel tap that was read last
+        std::vector<float> channelTapSamples;
+
+        // Latency of the audio is given by the samples queued in the device and in the audio buffer, at most about 35 ms
+        static constexpr const unsigned AUDIO_CALLBACK_SAMPLES = 512;
+        static constexpr const unsigned AUDIO_BUFFER_TARGET_SAMPLES = AUDIO_CALLBACK_SAMPLES * 3 / 2;
 };
\ No newline at end of file
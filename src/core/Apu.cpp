@@ -1,45 +1,86 @@
 #include "Apu.hpp"
 #include "apu/PulseChannel.hpp"
+#include "apu/TriangleChannel.hpp"
+#include "apu/NoiseChannel.hpp"
+#include <algorithm>
 #include <iostream>
+#include <limits>
 
-Apu::Apu(const std::function<void()> &irqTriggerCallback)
+Apu::Apu()
     : channels({
         std::make_unique<PulseChannel>(0),
-        std::make_unique<PulseChannel>(1)
+        std::make_unique<PulseChannel>(1),
+        std::make_unique<TriangleChannel>(),
+        std::make_unique<NoiseChannel>(),
+        std::make_unique<DmcChannel>()
     })
-    , irqTriggerCallback(irqTriggerCallback)
-    , registers()
-    , hz240counter(0)
-    , frameSequencerStep(0)
-    , periodicIrq(false)
+    , dmc(static_cast<DmcChannel*>(channels[DMC].get()))
+    , audioBuffer(AUDIO_BUFFER_CAPACITY)
+    , cycle(0)
+    , frameCounter()
+    , dmcIrqCycle(NO_IRQ)
+    , irqCycle(NO_IRQ)
+    , mixer()
+    , mutedChannels(0)
+    , soloChannels(0)
+    , channelMask(ALL_CHANNELS)
+    , audioEnabled(true)
+    , levels()
+    , output(0.0f)
+    , sampleRate(DEFAULT_SAMPLE_RATE)
+    , blipBuffer(CPU_CLOCK_RATE, DEFAULT_SAMPLE_RATE, DEFAULT_SAMPLE_RATE / 10)
+    , blipClock(0)
+    , samples(DEFAULT_SAMPLE_RATE / 10)
+    , rateControl()
+    , channelTaps()
+    , synthesisMode(ApuSynthesisMode::BandLimited)
+    , decimator(CPU_CLOCK_RATE / 2.0, DEFAULT_SAMPLE_RATE)
+    , nativeSamples(Decimator::BLOCK_SIZE)
+    , nativeSampleCount(0)
+    , oddCycle(false)
+    , oddCycleOutput(0.0f)
+    , pendingCycles(0)
+    , idleCycles(0)
+    , idleSkipping(true)
 {
+    output = mix();
+    idleCycles = getIdleCycles();
+    updateIrqCycle();
 }
 
 u8 Apu::read()
 {
+    catchUp();
     u8 result = 0;
-    for (auto i = 0; i < channels.size(); i++) {
-        result |= channels[i]->isEnabled() << i;
+    for (unsigned i = 0; i < channels.size(); i++) {
+        result |= channels[i]->isActive() << i;
     }
-    if (periodicIrq) {
+    // Reading the status acknowledges the frame interrupt
+    if (frameCounter.hasIrq()) {
         result |= 0x40;
-        periodicIrq = false;
+        frameCounter.clearIrq();
+        updateIrqCycle();
+    }
+    if (dmc->hasIrq()) {
+        result |= 0x80;
     }
-    // TODO: Add DMC interrupt
     return result;
 }
 
 void Apu::write(u8 addr, u8 value)
 {
+    catchUp();
     switch (addr) {
         case 0x15:
-            for (auto i = 0; i < channels.size(); i++) {
+            for (unsigned i = 0; i < channels.size(); i++) {
                 channels[i]->enable(value & 0x1);
                 value >>= 1;
             }
+            // Writes to the status register acknowledge DMC interrupt
+            dmc->clearIrq();
             break;
         case 0x17:
-            registers.frameCounterRegister = value;
+            frameCounter.write(value, cycle);
             break;
         default:
             if(addr > 0x13) {
@@ -47,73 +88,464 @@ void Apu::write(u8 addr, u8 value)
             }
             auto channelIndex = addr / 4;
             auto registerIndex = addr % 4;
-
-            // TODO: Remove later
-            if (channelIndex >= channels.size()) {
-                break;
-            }
-
             channels[channelIndex]->write(registerIndex, value);
             break;
     }
+    // Write can change the output of a channel, it is picked up by the following cycle
+    idleCycles = audioEnabled ? 0 : getIdleCycles();
+    updateDmcIrqCycle();
+    updateIrqCycle();
+}
+
+/**
+ * Emulates the pending cycles. Idle cycles are skipped at once, only the cycles in which something happens are stepped.
+ * Called whenever the pending cycles reach the end of the idle cycles, so that interrupts and DMC fetches happen on time,
+ * and before the registers are accessed.
+ */
+void Apu::catchUp()
+{
+    while (pendingCycles > idleCycles) {
+        skip(idleCycles);
+        pendingCycles -= idleCycles + 1;
+        step();
+        idleCycles = getIdleCycles();
+    }
+    skip(pendingCycles);
+    idleCycles -= pendingCycles;
+    pendingCycles = 0;
 }
 
-void Apu::tick()
+/**
+ * Single CPU cycle, in which all the channels are ticked. Output is only mixed when any of the channel levels changes.
+ * Band-limited synthesis adds the change into the blip buffer, native rate synthesis samples the output every cycle.
+ */
+void Apu::step()
 {
-    const auto& frameSequencerRegister = registers.frameCounterRegister;
-    hz240counter += 2;
-    if (hz240counter < HZ_240_COUNTER_THRESHOLD) {
+    if (++cycle == frameCounter.getNextEventCycle()) {
+        frameCounterClock();
+    }
+
+    if (!audioEnabled) {
+        for (auto& channel : channels) {
+            channel->tick();
+        }
+        return;
+    }
+
+    bool changed = false;
+    for (unsigned i = 0; i < channels.size(); i++) {
+        auto level = channels[i]->tick();
+        changed |= level != levels[i];
+        levels[i] = level;
+    }
+    if (changed) {
+        auto sample = mix();
+        if (synthesisMode == ApuSynthesisMode::BandLimited) {
+            blipBuffer.addDelta(blipClock, sample - output);
+        }
+        output = sample;
+    }
+    if (channelTaps) {
+        channelTaps->add(levels, 1);
+    }
+
+    if (synthesisMode == ApuSynthesisMode::NativeRate) {
+        addNativeSamples(1);
         return;
     }
+    if (++blipClock == BLIP_FRAME_CYCLES) {
+        endBlipFrame();
+    }
+}
 
-    hz240counter -= HZ_240_COUNTER_THRESHOLD;
-    frameSequencerStep++;
+/**
+ * Buffer of produced samples. APU is its producer and the audio output is its consumer,
+ * they can run on separate threads.
+ */
+RingBuffer<float>& Apu::getAudioBuffer()
+{
+    return audioBuffer;
+}
 
-    if (frameSequencerStep >= 4 + frameSequencerRegister.fiveStepSequencer) {
-        frameSequencerStep = 0;
+/**
+ * Moves all the samples from the audio buffer into the sink, returns their amount.
+ * Meant for consumers running without an audio device, on the same thread as the emulation.
+ */
+u64 Apu::writeAudio(AudioSink& sink)
+{
+    std::array<float, 1024> chunk;
+    // Only the stored samples are requested, so that reading them is not counted as an underrun
+    const u64 total = audioBuffer.getSize();
+    for (auto remaining = total; remaining > 0;) {
+        const auto count = audioBuffer.read(chunk.data(), static_cast<unsigned>(std::min<u64>(remaining, chunk.size())));
+        sink.write(chunk.data(), count);
+        remaining -= count;
     }
+    return total;
+}
 
-    if (!frameSequencerRegister.irqDisable && !frameSequencerRegister.fiveStepSequencer && frameSequencerStep == 0) {
-        periodicIrq = true;
-        irqTriggerCallback();
+/**
+ * Sets the rate of produced samples, samples that were not taken yet are dropped.
+ */
+void Apu::setSampleRate(unsigned sampleRate)
+{
+    catchUp();
+    this->sampleRate = sampleRate;
+    blipBuffer = BlipBuffer(CPU_CLOCK_RATE, sampleRate, sampleRate / 10);
+    decimator = Decimator(CPU_CLOCK_RATE / 2.0, sampleRate);
+    samples.resize(std::max(sampleRate / 10, decimator.getMaxOutputSize()));
+    restartOutput();
+    idleCycles = getIdleCycles();
+}
+
+unsigned Apu::getSampleRate() const
+{
+    return sampleRate;
+}
+
+/**
+ * Turns the production of samples on or off, can be done at any time.
+ * Without audio, only the behaviour visible to the CPU is emulated: status of the length counters,
+ * frame and DMC interrupts and DMC sample fetches. Channels are only stepped when any of these happens,
+ * their outputs are neither mixed nor synthesized.
+ */
+void Apu::setAudioEnabled(bool enabled)
+{
+    catchUp();
+    if (enabled && !audioEnabled) {
+        restartOutput();
     }
+    audioEnabled = enabled;
+    idleCycles = enabled ? 0 : getIdleCycles();
+}
 
-    bool halfFrame = (frameSequencerStep & 5) == 1;
-    bool quarterFrame = frameSequencerStep < 4;
+bool Apu::isAudioEnabled() const
+{
+    return audioEnabled;
+}
+
+/**
+ * Switches the way channels are mixed, the output changes immediately to the level given by the new mode.
+ */
+void Apu::setMixerMode(ApuMixerMode mode)
+{
+    catchUp();
+    mixer.setMode(mode);
+    updateOutput();
+}
+
+ApuMixerMode Apu::getMixerMode() const
+{
+    return mixer.getMode();
+}
+
+/**
+ * Switches the way samples are produced. Output continues from silence in the new mode,
+ * samples that were not produced yet are dropped.
+ */
+void Apu::setSynthesisMode(ApuSynthesisMode mode)
+{
+    catchUp();
+    synthesisMode = mode;
+    restartOutput();
+    idleCycles = audioEnabled ? 0 : getIdleCycles();
+}
+
+ApuSynthesisMode Apu::getSynthesisMode() const
+{
+    return synthesisMode;
+}
+
+/**
+ * Decimator used by the native rate synthesis, it reports the time that its blocks take.
+ */
+const Decimator& Apu::getDecimator() const
+{
+    return decimator;
+}
+
+/**
+ * Silences the channels given by the mask, bits follow the order of the status register.
+ * Solo channels take precedence over the muted ones.
+ */
+void Apu::setMutedChannels(u8 mask)
+{
+    catchUp();
+    mutedChannels = mask & ALL_CHANNELS;
+    channelMask = soloChannels != 0 ? soloChannels : ALL_CHANNELS & ~mutedChannels;
+    updateOutput();
+}
+
+u8 Apu::getMutedChannels() const
+{
+    return mutedChannels;
+}
+
+/**
+ * Mixes only the channels given by the mask into the output, bits follow the order of the status register.
+ * Empty mask mixes all the channels that are not muted.
+ */
+void Apu::setSoloChannels(u8 mask)
+{
+    catchUp();
+    soloChannels = mask & ALL_CHANNELS;
+    channelMask = soloChannels != 0 ? soloChannels : ALL_CHANNELS & ~mutedChannels;
+    updateOutput();
+}
+
+u8 Apu::getSoloChannels() const
+{
+    return soloChannels;
+}
+
+/**
+ * Starts filling the waveforms of the individual channels at the given rate, zero stops it.
+ * Taps are filled from the channel levels alongside the output, regardless of the muted and solo channels,
+ * only while the audio is enabled.
+ */
+void Apu::setChannelTapRate(unsigned rate)
+{
+    catchUp();
+    if (rate == 0) {
+        channelTaps.reset();
+    } else {
+        channelTaps = std::make_unique<ChannelTaps>(CPU_CLOCK_RATE, rate, CHANNEL_TAP_CAPACITY);
+    }
+}
 
-    for (auto i = 0; i < channels.size(); i++) {
-        auto channel = channels[i].get();
-        
-        if (halfFrame) {
+/**
+ * Waveforms of the individual channels, null when they are not enabled.
+ */
+ChannelTaps* Apu::getChannelTaps()
+{
+    return channelTaps.get();
+}
+
+/**
+ * Amount of samples that should be kept in the audio buffer. Rate of produced samples is then adjusted,
+ * so that it follows the rate at which the consumer takes them. Zero keeps the rate fixed.
+ */
+void Apu::setAudioBufferTarget(unsigned samples)
+{
+    rateControl.setTargetLevel(samples);
+    blipBuffer.setRates(CPU_CLOCK_RATE, sampleRate);
+    decimator.setOutputRate(sampleRate);
+}
+
+/**
+ * Ratio between the current and the nominal sample rate.
+ */
+double Apu::getAudioRateRatio() const
+{
+    return rateControl.getRatio();
+}
+
+/**
+ * Sets the function used by the DMC channel to fetch samples from the CPU memory.
+ */
+void Apu::setMemoryReader(const std::function<u8(u16)>& memoryReader)
+{
+    dmc->setMemoryReader(memoryReader);
+}
+
+/**
+ * Turns the skipping of the idle cycles on or off. Without it, every cycle is stepped,
+ * which serves as the reference the skipping is compared against.
+ */
+void Apu::setIdleSkipping(bool enabled)
+{
+    catchUp();
+    idleSkipping = enabled;
+    idleCycles = getIdleCycles();
+}
+
+/**
+ * Amount of cycles, for which the CPU has to be halted because of DMC sample fetches.
+ */
+unsigned Apu::takeDmcStallCycles()
+{
+    return dmc->takeStallCycles();
+}
+
+/**
+ * Advances the timers by the given amount of idle cycles.
+ */
+void Apu::skip(unsigned cycles)
+{
+    if (cycles == 0) {
+        return;
+    }
+    for (auto& channel : channels) {
+        channel->skip(cycles);
+    }
+    cycle += cycles;
+    if (!audioEnabled) {
+        return;
+    }
+    if (channelTaps) {
+        channelTaps->add(levels, cycles);
+    }
+    if (synthesisMode == ApuSynthesisMode::NativeRate) {
+        addNativeSamples(cycles);
+    } else {
+        blipClock += cycles;
+    }
+}
+
+/**
+ * Amount of cycles ahead, in which none of the channels changes its output or needs to fetch a sample,
+ * the frame counter has no event and the blip buffer frame does not end.
+ * Without audio, outputs of the channels and the blip buffer are not taken into account.
+ * Native rate synthesis samples the output while skipping, so it doesn't depend on the blip buffer either.
+ */
+unsigned Apu::getIdleCycles() const
+{
+    if (!idleSkipping) {
+        return 0;
+    }
+    auto cycles = static_cast<unsigned>(std::min<u64>(frameCounter.getNextEventCycle() - cycle - 1, std::numeric_limits<unsigned>::max()));
+    if (audioEnabled && synthesisMode == ApuSynthesisMode::BandLimited) {
+        cycles = std::min(cycles, BLIP_FRAME_CYCLES - blipClock - 1);
+    }
+    for (const auto& channel : channels) {
+        cycles = std::min(cycles, channel->getIdleCycles(audioEnabled));
+    }
+    return cycles;
+}
+
+/**
+ * Clocks the channels by the frame counter event of the current cycle. Frame interrupt might have been raised.
+ */
+void Apu::frameCounterClock()
+{
+    const auto event = frameCounter.clock(cycle);
+    for (auto& channel : channels) {
+        if (event.halfFrame) {
             channel->halfFrameTick();
         }
-        if (quarterFrame) {
+        if (event.quarterFrame) {
             channel->quarterFrameTick();
         }
     }
+    updateIrqCycle();
+}
 
-    auto pulse1 = channels[0]->tick();
-    auto pulse2 = channels[1]->tick();
-    // TODO: Replace with actual channel outputs
-    auto triangle = 0;
-    auto noise = 0;
-    auto dmc = 0;
+/**
+ * DMC interrupt is raised at the fetch of the last byte of the sample, so the cycle it is due at
+ * only changes when the registers of the channel are written.
+ */
+void Apu::updateDmcIrqCycle()
+{
+    if (dmc->hasIrq()) {
+        return;
+    }
+    const auto cycles = dmc->getIrqCycles();
+    dmcIrqCycle = cycles == DmcChannel::NO_IRQ ? NO_IRQ : cycle + cycles;
+}
 
-    auto safeDivide = [](float dividend, float divisor, float defaultOnDivByZero) {
-        if (divisor == 0.f) {
-            return defaultOnDivByZero;
-        }
-        return dividend / divisor;
+void Apu::updateIrqCycle()
+{
+    irqCycle = std::min(frameCounter.getIrqCycle(), dmcIrqCycle);
+}
+
+/**
+ * Mixes current channel levels into a single sample. Levels of the channels outside of the channel mask are left out.
+ */
+float Apu::mix() const
+{
+    if (channelMask == ALL_CHANNELS) {
+        return mixer.mix(levels[PULSE_1], levels[PULSE_2], levels[TRIANGLE], levels[NOISE], levels[DMC]);
+    }
+    const auto level = [this](unsigned channel) -> u8 {
+        return (channelMask >> channel) & 1 ? levels[channel] : 0;
     };
+    return mixer.mix(level(PULSE_1), level(PULSE_2), level(TRIANGLE), level(NOISE), level(DMC));
+}
 
-    auto pulseSample = safeDivide(95.88f, 100.f + safeDivide(8128.f, pulse1 + pulse2, -100.f), 0.f);
-    auto tndSample = safeDivide(159.79f, 100.f + safeDivide(1.0f, triangle / 8227.f + noise / 12241.f + dmc / 22638.f, -100.f), 0.f);
+/**
+ * Changes the output immediately to the current mix, after the mixing itself changed.
+ */
+void Apu::updateOutput()
+{
+    if (!audioEnabled) {
+        return;
+    }
+    const auto sample = mix();
+    if (synthesisMode == ApuSynthesisMode::BandLimited) {
+        blipBuffer.addDelta(blipClock, sample - output);
+    }
+    output = sample;
+}
+
+/**
+ * Makes the samples covered by the blip buffer frame available in the audio buffer.
+ * With the rate control enabled, the rate of samples in the next frame follows the level of the audio buffer.
+ */
+void Apu::endBlipFrame()
+{
+    blipBuffer.endFrame(blipClock);
+    blipClock = 0;
+    auto count = blipBuffer.readSamples(samples.data(), samples.size());
+    audioBuffer.write(samples.data(), count);
+    if (rateControl.getTargetLevel() != 0) {
+        blipBuffer.setRates(CPU_CLOCK_RATE, sampleRate * rateControl.update(audioBuffer.getSize()));
+    }
+}
+
+/**
+ * Samples the current output for the given amount of cycles. Odd cycle is kept until the next call,
+ * so that each native sample is the average of two cycles.
+ */
+void Apu::addNativeSamples(unsigned cycles)
+{
+    if (oddCycle && cycles > 0) {
+        oddCycle = false;
+        cycles--;
+        nativeSamples[nativeSampleCount] = (oddCycleOutput + output) * 0.5f;
+        if (++nativeSampleCount == Decimator::BLOCK_SIZE) {
+            endNativeBlock();
+        }
+    }
+    for (auto pairs = cycles / 2; pairs > 0;) {
+        const auto count = std::min(pairs, Decimator::BLOCK_SIZE - nativeSampleCount);
+        std::fill_n(nativeSamples.begin() + nativeSampleCount, count, output);
+        nativeSampleCount += count;
+        pairs -= count;
+        if (nativeSampleCount == Decimator::BLOCK_SIZE) {
+            endNativeBlock();
+        }
+    }
+    if (cycles % 2) {
+        oddCycle = true;
+        oddCycleOutput = output;
+    }
+}
 
-    auto sample = pulseSample + tndSample;
-    //audioQueue.push(sample);
+/**
+ * Decimates the full block of native samples into the audio buffer.
+ * With the rate control enabled, the rate of samples from the next block follows the level of the audio buffer.
+ */
+void Apu::endNativeBlock()
+{
+    nativeSampleCount = 0;
+    auto count = decimator.process(nativeSamples.data(), samples.data());
+    audioBuffer.write(samples.data(), count);
+    if (rateControl.getTargetLevel() != 0) {
+        decimator.setOutputRate(sampleRate * rateControl.update(audioBuffer.getSize()));
+    }
 }
 
-std::queue<float> Apu::getAudioQueue()
+/**
+ * Output continues from silence, samples that were not produced yet are dropped.
+ */
+void Apu::restartOutput()
 {
-    return audioQueue;
+    blipBuffer.clear();
+    blipClock = 0;
+    decimator.clear();
+    nativeSampleCount = 0;
+    oddCycle = false;
+    output = 0.0f;
+    levels.fill(0);
+    rateControl.reset();
 }
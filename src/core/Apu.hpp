@@ -2,17 +2,39 @@
 
 #include <array>
 #include <memory>
-#include <queue>
 #include <functional>
 
 #include "Types.hpp"
-#include "ApuRegisters.hpp"
+#include "RingBuffer.hpp"
 #include "apu/AudioChannel.hpp"
+#include "apu/DmcChannel.hpp"
+#include "apu/FrameCounter.hpp"
+#include "apu/BlipBuffer.hpp"
+#include "apu/ApuMixer.hpp"
+#include "apu/ApuSynthesisMode.hpp"
+#include "apu/Decimator.hpp"
+#include "apu/AudioRateControl.hpp"
+#include "apu/AudioSink.hpp"
+#include "apu/ChannelTaps.hpp"
 
 class Apu
 {
     public:
-        Apu(const std::function<void()>& irqTriggerCallback);
+        static constexpr const unsigned CPU_CLOCK_RATE = 1789773;
+        static constexpr const unsigned DEFAULT_SAMPLE_RATE = 44100;
+        // Channels in the order of the status register, each of them has a bit in the channel masks
+        static constexpr const unsigned PULSE_1 = 0;
+        static constexpr const unsigned PULSE_2 = 1;
+        static constexpr const unsigned TRIANGLE = 2;
+        static constexpr const unsigned NOISE = 3;
+        static constexpr const unsigned DMC = 4;
+        static constexpr const unsigned CHANNEL_COUNT = 5;
+        static constexpr const u8 ALL_CHANNELS = 0x1F;
+        static constexpr const u64 NO_IRQ = FrameCounter::NEVER;
+        // Samples kept by each channel tap until they are read, the ones that don't fit are dropped
+        static constexpr const unsigned CHANNEL_TAP_CAPACITY = 8192;
+
+        Apu();
 
         ~Apu() = default;
 
@@ -20,20 +42,141 @@ class Apu
 
         void write(u8 addr, u8 value);
 
-        void tick();
+        /**
+         * Single CPU cycle. Cycles are only counted until something happens in the APU, then it catches up at once.
+         */
+        void tick()
+        {
+            if (++pendingCycles > idleCycles) {
+                catchUp();
+            }
+        }
+
+        void catchUp();
+
+        /**
+         * Amount of CPU cycles since the power-up, including the pending ones.
+         */
+        u64 getCycle() const
+        {
+            return cycle + pendingCycles;
+        }
+
+        /**
+         * Cycle since which the IRQ line is asserted by the frame counter or the DMC, or the cycle at which it will be,
+         * unless the registers are written before. NO_IRQ when no interrupt is due.
+         */
+        u64 getIrqCycle() const
+        {
+            return irqCycle;
+        }
+
+        bool isIrqAsserted() const
+        {
+            return irqCycle <= getCycle();
+        }
+
+        RingBuffer<float>& getAudioBuffer();
+
+        u64 writeAudio(AudioSink& sink);
+
+        void setSampleRate(unsigned sampleRate);
+
+        unsigned getSampleRate() const;
+
+        void setAudioEnabled(bool enabled);
+
+        bool isAudioEnabled() const;
+
+        void setMixerMode(ApuMixerMode mode);
+
+        ApuMixerMode getMixerMode() const;
+
+        void setSynthesisMode(ApuSynthesisMode mode);
 
-        std::queue<float> getAudioQueue();
+        ApuSynthesisMode getSynthesisMode() const;
+
+        const Decimator& getDecimator() const;
+
+        void setMutedChannels(u8 mask);
+
+        u8 getMutedChannels() const;
+
+        void setSoloChannels(u8 mask);
+
+        u8 getSoloChannels() const;
+
+        void setChannelTapRate(unsigned rate);
+
+        ChannelTaps* getChannelTaps();
+
+        void setAudioBufferTarget(unsigned samples);
+
+        double getAudioRateRatio() const;
+
+        void setMemoryReader(const std::function<u8(u16)>& memoryReader);
+
+        void setIdleSkipping(bool enabled);
+
+        unsigned takeDmcStallCycles();
 
     private:
-        std::array<std::unique_ptr<AudioChannel>, 2> channels;
-        std::function<void()> irqTriggerCallback;
-        std::queue<float> audioQueue;
+        std::array<std::unique_ptr<AudioChannel>, CHANNEL_COUNT> channels;
+        DmcChannel* dmc;
+        RingBuffer<float> audioBuffer;
+
+        // Cycles emulated since the power-up, pending cycles are not included
+        u64 cycle;
+        FrameCounter frameCounter;
+        // Cycle of the DMC interrupt, either the one that is asserted or the one that is due
+        u64 dmcIrqCycle;
+        u64 irqCycle;
+
+        ApuMixer mixer;
+        u8 mutedChannels;
+        u8 soloChannels;
+        // Channels that are mixed into the output, given by the muted and solo channels
+        u8 channelMask;
+        bool audioEnabled;
+        // Output levels of the channels and the mix of them that was last added to the blip buffer
+        std::array<u8, CHANNEL_COUNT> levels;
+        float output;
+        unsigned sampleRate;
+        BlipBuffer blipBuffer;
+        unsigned blipClock;
+        std::vector<float> samples;
+        AudioRateControl rateControl;
+        // Present only while the channel taps are enabled
+        std::unique_ptr<ChannelTaps> channelTaps;
+        ApuSynthesisMode synthesisMode;
+        // Output sampled at half of the CPU clock, each sample is the average of two cycles
+        Decimator decimator;
+        std::vector<float> nativeSamples;
+        unsigned nativeSampleCount;
+        bool oddCycle;
+        float oddCycleOutput;
 
-        ApuRegisters registers;
+        // CPU cycles that were not emulated yet and the amount of cycles ahead, in which nothing but the timers change
+        unsigned pendingCycles;
+        unsigned idleCycles;
+        // Only turned off by the tests, which compare skipping against stepping every cycle
+        bool idleSkipping;
 
-        u16 hz240counter;
-        u8 frameSequencerStep;
-        bool periodicIrq;
+        void step();
+        void skip(unsigned cycles);
+        unsigned getIdleCycles() const;
+        void frameCounterClock();
+        void updateDmcIrqCycle();
+        void updateIrqCycle();
+        float mix() const;
+        void updateOutput();
+        void endBlipFrame();
+        void addNativeSamples(unsigned cycles);
+        void endNativeBlock();
+        void restartOutput();
 
-        static const constexpr u16 HZ_240_COUNTER_THRESHOLD = 14915;
-};
\ No newline at end of file
+        // Blip buffer frame is ended 240 times per second, so that samples are produced in small chunks
+        static const constexpr unsigned BLIP_FRAME_CYCLES = 7457;
+        // Samples that don't fit into the audio buffer are dropped
+        static const constexpr unsigned AUDIO_BUFFER_CAPACITY = 8192;
+};
@@ -11,9 +11,4 @@ union FrameCounterRegister
     operator u8&() { return raw; }
 
     FrameCounterRegister& operator=(u8 value) { raw = value; return *this; }
-};
-
-struct ApuRegisters
-{
-    FrameCounterRegister frameCounterRegister;
 };
\ No newline at end of file
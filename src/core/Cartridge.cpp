@@ -53,9 +53,48 @@ u8 Cartridge::read(u16 addr)
 
 MirroringType Cartridge::getMirroringType() const
 {
+    if(!mapper) {
+        return MirroringType::Horizontal;
+    }
     return mapper->getMirroringType();
 }
 
+u64 Cartridge::getChrGeneration() const
+{
+    if(!mapper) {
+        return 0;
+    }
+    return mapper->getChrGeneration();
+}
+
+/**
+ * CHR memory and its mapping into pattern tables, for the consumers that keep their own copy of pattern tables.
+ * Without a cartridge there's no CHR memory at all.
+ */
+std::span<const u8> Cartridge::getChrMemory() const
+{
+    if(!mapper) {
+        return {};
+    }
+    return mapper->getChrMemory();
+}
+
+unsigned Cartridge::getChrPageOffset(unsigned page) const
+{
+    if(!mapper) {
+        return 0;
+    }
+    return mapper->getChrPageOffset(page);
+}
+
+u8 Cartridge::getChrWriteMask() const
+{
+    if(!mapper) {
+        return 0;
+    }
+    return mapper->getChrWriteMask();
+}
+
 std::unique_ptr<Cartridge::NesHeaderData> Cartridge::parseNesHeader(const NesHeader &nesHeader)
 {
     using enum MirroringType;
@@ -4,6 +4,7 @@
 #include <vector>
 #include <memory>
 #include <array>
+#include <span>
 
 #include "Types.hpp"
 #include "MirroringType.hpp"
@@ -20,8 +21,20 @@ class Cartridge
 
         u8 read(u16 addr);
 
+        u8 readChr(u16 addr) const;
+
+        void writeChr(u16 addr, u8 value);
+
         MirroringType getMirroringType() const;
 
+        u64 getChrGeneration() const;
+
+        std::span<const u8> getChrMemory() const;
+
+        unsigned getChrPageOffset(unsigned page) const;
+
+        u8 getChrWriteMask() const;
+
     private:
         std::unique_ptr<Mapper> mapper;
 
@@ -41,4 +54,23 @@ class Cartridge
         bool isValidNesHeader(const NesHeader& nesHeader);
 
         bool assignMapper(unsigned mapperNo, std::vector<u8>&& prgRom, std::vector<u8>&& chrRom, MirroringType mirroringType);
-};
\ No newline at end of file
+};
+
+/**
+ * Reads from pattern tables, called by the PPU for every tile fetch, hence inlined.
+ */
+inline u8 Cartridge::readChr(u16 addr) const
+{
+    if(!mapper) {
+        return 0;
+    }
+    return mapper->readChr(addr);
+}
+
+inline void Cartridge::writeChr(u16 addr, u8 value)
+{
+    if(!mapper) {
+        return;
+    }
+    mapper->writeChr(addr, value);
+}
@@ -42,8 +42,13 @@ unsigned Cpu::step()
     //
     // 1 CPU cycle which is taken to read opcode from memory 
     // is generally considered part of the instruction "cost" measured in CPU cycles
+    const bool interruptDisable = registers.p.interruptDisable != 0;
     auto opcode = fetchOpcode();
     executeInstruction(opcode);
+    // CLI, SEI and PLP change the interrupt disable flag after interrupts are polled,
+    // so the change only takes effect after the following instruction
+    const bool delayedFlag = opcode == 0x58 || opcode == 0x78 || opcode == 0x28;
+    pollIrq(delayedFlag ? interruptDisable : registers.p.interruptDisable != 0);
     return mmu->getAndResetTickCounterValue();
 }
 
@@ -348,18 +353,26 @@ void Cpu::executeInstruction(u8 opcode)
     }
 }
 
+/**
+ * Polls the IRQ line at the end of the instruction, the interrupt is then serviced before the next instruction.
+ * Line is sampled in the penultimate cycle of the instruction, IRQ asserted in the last cycle waits for the next poll.
+ */
+void Cpu::pollIrq(bool interruptDisable)
+{
+    irqPending = !interruptDisable && mmu->pollIrq();
+}
+
 /**
  * Tells the CPU that an external interrupt is being requested.
  * External interrupt can be requested in the middle of instruction execution,
  * however it should not be serviced immediately, 
  * but rather before attempting to fetch and execute next instruction.
+ * Only NMI is requested this way. IRQ is the level of a line, which is polled through the MMU,
+ * so its sources (currently only the APU, none of the supported mappers raise IRQ) are routed there.
  */
 void Cpu::interrupt(InterruptType type)
 {
     switch(type) {
-        case InterruptType::IRQ:
-            irqPending = true;
-            break;
         case InterruptType::NMI:
             nmiPending = true;
             break;
@@ -384,12 +397,6 @@ CpuRegisters &Cpu::getRegisters()
  */
 void Cpu::handleInterrupt(InterruptType type)
 {
-    // If IRQ is handled but it's servicing is disabled 
-    // then stop further execution of this method.
-    if(registers.p.interruptDisable && type == InterruptType::IRQ) {
-        return;
-    }
-
     // BRK and RESET are performing additional dummy read from memory.
     // Also special "Break flag" (Bit 4 of Processor Status) is set,
     // before pushing Processor Status register value to the stack.
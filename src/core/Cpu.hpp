@@ -38,6 +38,7 @@ class Cpu
         bool irqPending;
         bool nmiPending;
 
+        void pollIrq(bool interruptDisable);
         void handleInterrupt(InterruptType type);
 
         u16 wrapAddress(u16 oldAddress, u16 newAddress);
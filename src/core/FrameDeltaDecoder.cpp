@@ -0,0 +1,95 @@
+#include "FrameDeltaDecoder.hpp"
+#include "FrameDeltaEncoder.hpp"
+
+FrameDeltaDecoder::FrameDeltaDecoder()
+    : frame(FrameDeltaEncoder::WIDTH * FrameDeltaEncoder::HEIGHT, 0)
+    , keyframeReceived(false)
+{
+}
+
+/**
+ * Applies the packet onto the reconstructed frame.
+ * Returns false when the packet is malformed, in which case the frame might be partially updated,
+ * or when it is a delta frame received before any keyframe.
+ */
+bool FrameDeltaDecoder::decode(const u8* packet, std::size_t size)
+{
+    const u8* data = packet;
+    const u8* end = packet + size;
+    if (data == end) {
+        return false;
+    }
+
+    const auto type = *data++;
+    if (type == FrameDeltaEncoder::KEYFRAME) {
+        for (unsigned tile = 0; tile < FrameDeltaEncoder::TILE_COUNT; tile++) {
+            if (!decodeTile(data, end, tile)) {
+                return false;
+            }
+        }
+        keyframeReceived = true;
+    } else if (type == FrameDeltaEncoder::DELTA_FRAME) {
+        // Changes can only be applied on top of the frame that was already received in full
+        if (!keyframeReceived || end - data < 2) {
+            return false;
+        }
+        const unsigned count = data[0] | (data[1] << 8);
+        data += 2;
+        for (unsigned i = 0; i < count; i++) {
+            if (end - data < 2) {
+                return false;
+            }
+            const unsigned tile = data[0] | (data[1] << 8);
+            data += 2;
+            if (tile >= FrameDeltaEncoder::TILE_COUNT || !decodeTile(data, end, tile)) {
+                return false;
+            }
+        }
+    } else {
+        return false;
+    }
+    return data == end;
+}
+
+/**
+ * Reconstructed frame in Indexed8 format.
+ */
+const u8* FrameDeltaDecoder::getFrame() const
+{
+    return frame.data();
+}
+
+/**
+ * Tells whether the frame is complete, which is after the first keyframe.
+ */
+bool FrameDeltaDecoder::hasFrame() const
+{
+    return keyframeReceived;
+}
+
+bool FrameDeltaDecoder::decodeTile(const u8*& data, const u8* end, unsigned tile)
+{
+    using Encoder = FrameDeltaEncoder;
+    const auto tileSize = Encoder::TILE_SIZE;
+    auto* origin = frame.data() + (tile / Encoder::TILES_PER_ROW) * tileSize * Encoder::WIDTH
+        + (tile % Encoder::TILES_PER_ROW) * tileSize;
+
+    unsigned position = 0;
+    while (position < tileSize * tileSize) {
+        if (data == end) {
+            return false;
+        }
+        unsigned length = 1;
+        if (*data & Encoder::RUN_FLAG) {
+            length = (*data++ & ~Encoder::RUN_FLAG) + 2;
+            if (data == end || position + length > tileSize * tileSize) {
+                return false;
+            }
+        }
+        const auto color = *data++;
+        for (; length > 0; length--, position++) {
+            origin[(position / tileSize) * Encoder::WIDTH + position % tileSize] = color;
+        }
+    }
+    return true;
+}
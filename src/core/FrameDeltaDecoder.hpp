@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "Types.hpp"
+
+/**
+ * Decoder of the packets produced by FrameDeltaEncoder.
+ * Keeps the reconstructed frame in Indexed8 format, that is updated by every decoded packet.
+ */
+class FrameDeltaDecoder
+{
+    public:
+        FrameDeltaDecoder();
+
+        ~FrameDeltaDecoder() = default;
+
+        bool decode(const u8* packet, std::size_t size);
+
+        const u8* getFrame() const;
+
+        bool hasFrame() const;
+
+    private:
+        std::vector<u8> frame;
+        bool keyframeReceived;
+
+        bool decodeTile(const u8*& data, const u8* end, unsigned tile);
+};
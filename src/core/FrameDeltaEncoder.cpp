@@ -0,0 +1,183 @@
+#include "FrameDeltaEncoder.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+#endif
+
+namespace
+{
+    /**
+     * Compares 16 pixels, which are rows of 2 neighbouring tiles.
+     * Bit is set in the result for every pixel that differs.
+     */
+    unsigned compareTileRows(const u8* a, const u8* b)
+    {
+#if defined(__SSE2__)
+        const auto equal = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a)),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(b)));
+        return static_cast<unsigned>(_mm_movemask_epi8(equal)) ^ 0xFFFF;
+#elif defined(__wasm_simd128__)
+        return static_cast<unsigned>(wasm_i8x16_bitmask(wasm_i8x16_ne(wasm_v128_load(a), wasm_v128_load(b))));
+#else
+        u64 rows[4];
+        std::memcpy(rows, a, 16);
+        std::memcpy(rows + 2, b, 16);
+        return (rows[0] != rows[2] ? 0x00FF : 0) | (rows[1] != rows[3] ? 0xFF00 : 0);
+#endif
+    }
+}
+
+FrameDeltaEncoder::FrameDeltaEncoder(unsigned keyframeInterval)
+    : keyframeInterval(std::max(keyframeInterval, 1u))
+    , framesSinceKeyframe(0)
+    , keyframeRequested(true)
+    , previousFrame(WIDTH * HEIGHT, 0)
+    , packet()
+    , changedTiles()
+    , averagePacketSize(0.0)
+    , lastEncodeTime(0.0)
+    , averageEncodeTime(0.0)
+{
+    // Keyframe has 3 bytes of header at most, and each pixel takes 2 bytes at most
+    packet.reserve(3 + WIDTH * HEIGHT * 2);
+}
+
+/**
+ * Encodes the frame in Indexed8 format, consisting of 256x240 color indices.
+ * Returned packet stays valid until the next call.
+ */
+const std::vector<u8>& FrameDeltaEncoder::encode(const u8* frame)
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    const bool keyframe = keyframeRequested || framesSinceKeyframe + 1 >= keyframeInterval;
+    packet.clear();
+    if (keyframe) {
+        changedTiles.set();
+        packet.push_back(KEYFRAME);
+        for (unsigned tile = 0; tile < TILE_COUNT; tile++) {
+            encodeTile(frame, tile);
+        }
+        keyframeRequested = false;
+        framesSinceKeyframe = 0;
+    } else {
+        findChangedTiles(frame);
+        const auto count = changedTiles.count();
+        packet.push_back(DELTA_FRAME);
+        packet.push_back(count & 0xFF);
+        packet.push_back(count >> 8);
+        for (unsigned tile = 0; tile < TILE_COUNT && count > 0; tile++) {
+            if (changedTiles[tile]) {
+                packet.push_back(tile & 0xFF);
+                packet.push_back(tile >> 8);
+                encodeTile(frame, tile);
+            }
+        }
+        framesSinceKeyframe++;
+    }
+    std::memcpy(previousFrame.data(), frame, previousFrame.size());
+
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    lastEncodeTime = elapsed.count();
+    averageEncodeTime = averageEncodeTime == 0.0
+        ? lastEncodeTime
+        : averageEncodeTime + (lastEncodeTime - averageEncodeTime) * AVERAGE_WEIGHT;
+    averagePacketSize = averagePacketSize == 0.0
+        ? packet.size()
+        : averagePacketSize + (packet.size() - averagePacketSize) * AVERAGE_WEIGHT;
+    return packet;
+}
+
+/**
+ * Makes the next encoded frame a keyframe, for example when a new client joins the stream.
+ */
+void FrameDeltaEncoder::requestKeyframe()
+{
+    keyframeRequested = true;
+}
+
+/**
+ * Number of tiles sent in the last packet.
+ */
+unsigned FrameDeltaEncoder::getChangedTileCount() const
+{
+    return changedTiles.count();
+}
+
+std::size_t FrameDeltaEncoder::getLastPacketSize() const
+{
+    return packet.size();
+}
+
+double FrameDeltaEncoder::getAveragePacketSize() const
+{
+    return averagePacketSize;
+}
+
+/**
+ * Time in milliseconds it took to encode the last frame.
+ */
+double FrameDeltaEncoder::getLastEncodeTime() const
+{
+    return lastEncodeTime;
+}
+
+/**
+ * Exponential moving average of the encoding times in milliseconds.
+ */
+double FrameDeltaEncoder::getAverageEncodeTime() const
+{
+    return averageEncodeTime;
+}
+
+void FrameDeltaEncoder::findChangedTiles(const u8* frame)
+{
+    changedTiles.reset();
+    for (unsigned y = 0; y < HEIGHT; y++) {
+        const auto rowOffset = y * WIDTH;
+        const auto firstTile = (y / TILE_SIZE) * TILES_PER_ROW;
+        for (unsigned x = 0; x < WIDTH; x += 2 * TILE_SIZE) {
+            const auto difference = compareTileRows(frame + rowOffset + x, previousFrame.data() + rowOffset + x);
+            if (difference) {
+                const auto tile = firstTile + x / TILE_SIZE;
+                changedTiles[tile] = changedTiles[tile] || (difference & 0x00FF);
+                changedTiles[tile + 1] = changedTiles[tile + 1] || (difference & 0xFF00);
+            }
+        }
+    }
+}
+
+void FrameDeltaEncoder::encodeTile(const u8* frame, unsigned tile)
+{
+    const auto* origin = frame + (tile / TILES_PER_ROW) * TILE_SIZE * WIDTH + (tile % TILES_PER_ROW) * TILE_SIZE;
+    auto flush = [this](u8 color, unsigned length) {
+        if (length == 1) {
+            packet.push_back(color);
+        } else {
+            packet.push_back(RUN_FLAG | (length - 2));
+            packet.push_back(color);
+        }
+    };
+
+    // Indexed8 pixels are 6 bit color indices, so the highest bit is always free for the run flag
+    u8 color = origin[0] & 0x3F;
+    unsigned length = 0;
+    for (unsigned y = 0; y < TILE_SIZE; y++) {
+        for (unsigned x = 0; x < TILE_SIZE; x++) {
+            const u8 pixel = origin[y * WIDTH + x] & 0x3F;
+            if (pixel != color) {
+                flush(color, length);
+                color = pixel;
+                length = 0;
+            }
+            length++;
+        }
+    }
+    flush(color, length);
+}
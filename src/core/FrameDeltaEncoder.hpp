@@ -0,0 +1,71 @@
+#pragma once
+
+#include <bitset>
+#include <vector>
+
+#include "Types.hpp"
+
+/**
+ * Encoder of the frames in Indexed8 format into compact packets, meant for streaming and recording.
+ *
+ * Frame is divided into 8x8 tiles and only the tiles that differ from the previous frame are sent.
+ * Pixels of every sent tile are run-length encoded. Every keyframeInterval frames all tiles are sent,
+ * so that decoder can join the stream at that point.
+ *
+ * Packet layout:
+ * - Keyframe: 0x01, followed by all 960 tiles in row-major order.
+ * - Delta frame: 0x00, count of tiles (16 bit little endian), followed by
+ *   index of each tile (16 bit little endian) and its pixels.
+ *
+ * Pixels of the tile are encoded row by row as a sequence of runs.
+ * Byte with the highest bit cleared is a single pixel with that color index.
+ * Byte with the highest bit set is a run of (byte & 0x7F) + 2 pixels with the color index from the following byte.
+ */
+class FrameDeltaEncoder
+{
+    public:
+        static constexpr const unsigned WIDTH = 256;
+        static constexpr const unsigned HEIGHT = 240;
+        static constexpr const unsigned TILE_SIZE = 8;
+        static constexpr const unsigned TILES_PER_ROW = WIDTH / TILE_SIZE;
+        static constexpr const unsigned TILE_COUNT = TILES_PER_ROW * (HEIGHT / TILE_SIZE);
+        static constexpr const unsigned DEFAULT_KEYFRAME_INTERVAL = 60;
+
+        static constexpr const u8 DELTA_FRAME = 0x00;
+        static constexpr const u8 KEYFRAME = 0x01;
+        static constexpr const u8 RUN_FLAG = 0x80;
+
+        explicit FrameDeltaEncoder(unsigned keyframeInterval = DEFAULT_KEYFRAME_INTERVAL);
+
+        ~FrameDeltaEncoder() = default;
+
+        const std::vector<u8>& encode(const u8* frame);
+
+        void requestKeyframe();
+
+        unsigned getChangedTileCount() const;
+
+        std::size_t getLastPacketSize() const;
+
+        double getAveragePacketSize() const;
+
+        double getLastEncodeTime() const;
+
+        double getAverageEncodeTime() const;
+
+    private:
+        unsigned keyframeInterval;
+        unsigned framesSinceKeyframe;
+        bool keyframeRequested;
+        std::vector<u8> previousFrame;
+        std::vector<u8> packet;
+        std::bitset<TILE_COUNT> changedTiles;
+        double averagePacketSize;
+        double lastEncodeTime;
+        double averageEncodeTime;
+
+        void findChangedTiles(const u8* frame);
+        void encodeTile(const u8* frame, unsigned tile);
+
+        static constexpr const double AVERAGE_WEIGHT = 0.05;
+};
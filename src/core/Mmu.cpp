@@ -2,6 +2,7 @@
 
 Mmu::Mmu()
     : resetSignalled(false)
+    , cycle(0)
 {
 }
 
@@ -16,7 +17,16 @@ Mmu::Mmu(const std::shared_ptr<Ppu> &ppu,
     , internalRam()
     , resetSignalled(false)
     , tickCounter(0)
+    , cycle(0)
 {
+    // DMC channel fetches samples from the upper half of the address space, which belongs to the cartridge
+    apu->setMemoryReader([this](u16 addr) {
+        return this->cartridge->read(addr);
+    });
+    // Timeline events are stamped with the cycle of the CPU that caused them
+    ppu->setCpuCycleCounter([this]() {
+        return cycle;
+    });
 }
 
 /**
@@ -50,9 +60,11 @@ u8 Mmu::readFromMemory(u16 addr)
         switch(mmioAddr) {
             case 0x15:
                 result = apu->read();
+                break;
             case 0x16:
             case 0x17:
                 result = controllers->read(mmioAddr & 0x1);
+                break;
             default:
                 break;
         }
@@ -122,6 +134,7 @@ void Mmu::writeIntoMemory(u16 addr, u8 value)
     } else {
         // The rest of the address space belongs to the cartridge, but some of it is unused
         cartridge->write(addr, value);
+        ppu->notifyCartridgeWrite(addr, value);
     }
 }
 
@@ -145,6 +158,23 @@ unsigned Mmu::getAndResetTickCounterValue()
     return old;
 }
 
+/**
+ * Amount of CPU cycles since the power-up, including the ones CPU was halted for.
+ */
+u64 Mmu::getCycle() const
+{
+    return cycle;
+}
+
+/**
+ * State of the IRQ line as the CPU sees it when polling interrupts, in the penultimate cycle of an instruction.
+ * APU knows the cycle since which it asserts the line, so the line doesn't have to be followed every cycle.
+ */
+bool Mmu::pollIrq() const
+{
+    return apu && apu->getIrqCycle() < apu->getCycle();
+}
+
 /**
  * Triggers a tick of the CPU peripherials.
  * This is a cheap way of synchronizing things. 
@@ -156,8 +186,13 @@ unsigned Mmu::getAndResetTickCounterValue()
 void Mmu::tick()
 {
     tickCounter++;
+    cycle++;
     for(auto i = 0; i < 3; i++) {
         ppu->tick();
     }
     apu->tick();
+    // CPU is halted while DMC fetches a byte of the sample, the rest of the system keeps running
+    for (auto stallCycles = apu->takeDmcStallCycles(); stallCycles > 0; stallCycles--) {
+        tick();
+    }
 }
@@ -32,6 +32,10 @@ class Mmu
 
         unsigned getAndResetTickCounterValue();
 
+        u64 getCycle() const;
+
+        bool pollIrq() const;
+
     private:
         std::shared_ptr<Ppu> ppu;
         std::shared_ptr<Apu> apu;
@@ -43,4 +47,5 @@ class Mmu
         void tick();
 
         unsigned tickCounter;
+        u64 cycle;
 };
\ No newline at end of file
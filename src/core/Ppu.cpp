@@ -1,10 +1,46 @@
 #include "Ppu.hpp"
 #include "Cpu.hpp"
+#include "PpuPalette.hpp"
+#include "PpuPredictor.hpp"
+#include "PpuBandRenderer.hpp"
+#include "PpuChrSnapshot.hpp"
+
+#include <algorithm>
+#include <cstring>
 
 Ppu::Ppu(const std::shared_ptr<Cartridge>& cartridge,
     const std::function<void()>& nmiTriggerCallback,
     const std::function<void()>& vblankCallback)
+    : Ppu(cartridge, nmiTriggerCallback, vblankCallback, std::make_unique<TripleBuffer<Frame>>())
+{
+}
+
+/**
+ * PPU that renders bands of the frames of another PPU. 
+ * It has no frames of its own and nothing is signalled from it.
+ */
+Ppu::Ppu(const std::shared_ptr<Cartridge>& cartridge)
+    : Ppu(cartridge, []() {}, []() {}, nullptr)
+{
+}
+
+Ppu::Ppu(const std::shared_ptr<Cartridge>& cartridge,
+    const std::function<void()>& nmiTriggerCallback,
+    const std::function<void()>& vblankCallback,
+    std::unique_ptr<TripleBuffer<Frame>> frames)
     : cartridge(cartridge)
+    , frames(std::move(frames))
+    , frame(this->frames ? &this->frames->back() : nullptr)
+    , bandRenderer()
+    , chrSnapshot(nullptr)
+    , frameNumber(0)
+    , renderMode(PpuRenderMode::Full)
+    , scanlineRenderMode(PpuRenderMode::Full)
+    , config()
+    , staleCroppedFrames()
+    , spriteZeroOnScanline(false)
+    , spriteZeroSlot(0)
+    , outputFormat(PpuOutputFormat::Indexed8)
     , registers()
     , openBusDecayTimer(0)
     , openBusContents(0)
@@ -22,15 +58,33 @@ Ppu::Ppu(const std::shared_ptr<Cartridge>& cartridge,
     , bgShiftPattern(0)
     , bgShiftAttributes(0)
     , vram()
+    , dirtyChrTiles()
+    , dirtyVram()
     , oam()
     , oam2()
+    , oam3()
     , palette()
+    , paletteCache()
+    , observation()
+    , observationLuma()
+    , timeline()
+    , tickCount(0)
+    , timelineChrGeneration(0)
+    , timelineMirroringType(MirroringType::Horizontal)
+    , predictionCheck(false)
+    , previousSpriteZeroHit(false)
+    , predictedSpriteZeroHit()
+    , predictedVblank(0)
+    , predictionCheckCount(0)
+    , predictionMismatchCount(0)
     , oamTempData(0)
     , spritePrimaryOamPosition(0)
     , spriteSecondaryOamPosition(0)
     , spriteRenderingPosition(0)
     , nmiTriggerCallback(nmiTriggerCallback)
     , vblankCallback(vblankCallback)
+    , scanlineCallback()
+    , cpuCycleCounter()
 {
     registers.ppuCtrl = 0x00;
     registers.ppuMask = 0x00;
@@ -39,15 +93,60 @@ Ppu::Ppu(const std::shared_ptr<Cartridge>& cartridge,
     registers.taddr = 0x0000;
     registers.vaddr = 0x0000;
     vramReadBuffer = 0x00;
+    updatePaletteCache();
+}
+
+Ppu::~Ppu() = default;
+
+/**
+ * Copies the state that affects rendering from the PPU whose band is rendered by this one.
+ * Band is always rendered in full, with the palette cache built for the output format of the source.
+ */
+void Ppu::copyRenderState(const Ppu& source)
+{
+    config = source.config;
+    outputFormat = source.outputFormat;
+    registers = source.registers;
+    openBusDecayTimer = source.openBusDecayTimer;
+    openBusContents = source.openBusContents;
+    vramReadBuffer = source.vramReadBuffer;
+    scanline = source.scanline;
+    scanlineEndPosition = source.scanlineEndPosition;
+    renderingPositionX = source.renderingPositionX;
+    offsetToggleLatch = source.offsetToggleLatch;
+    evenOddFrameToggle = source.evenOddFrameToggle;
+    patternTableAddress = source.patternTableAddress;
+    attributeTableAddress = source.attributeTableAddress;
+    nametableAddress = source.nametableAddress;
+    tilePattern = source.tilePattern;
+    tileAttributes = source.tileAttributes;
+    bgShiftPattern = source.bgShiftPattern;
+    bgShiftAttributes = source.bgShiftAttributes;
+    vram = source.vram;
+    oam = source.oam;
+    oam2 = source.oam2;
+    oam3 = source.oam3;
+    palette = source.palette;
+    oamTempData = source.oamTempData;
+    spritePrimaryOamPosition = source.spritePrimaryOamPosition;
+    spriteSecondaryOamPosition = source.spriteSecondaryOamPosition;
+    spriteRenderingPosition = source.spriteRenderingPosition;
+    renderMode = PpuRenderMode::Full;
+    updateScanlineRenderMode();
+    updatePaletteCache();
 }
 
 void Ppu::reset()
 {
+    if (renderMode == PpuRenderMode::Deferred) {
+        bandRenderer->record(PpuBandRenderer::EventType::Reset, scanline, renderingPositionX);
+    }
     registers.ppuCtrl = 0x00;
     registers.ppuMask = 0x00;
     registers.ppuStatus = registers.ppuStatus & 0x80;
     offsetToggleLatch = false;
     evenOddFrameToggle = false;
+    updatePaletteCache();
 }
 
 /**
@@ -55,6 +154,10 @@ void Ppu::reset()
  */
 u8 Ppu::read(u8 index)
 {
+    // Reads of PPUSTATUS and PPUDATA change the state that rendering depends on
+    if (renderMode == PpuRenderMode::Deferred && (index == 2 || index == 7)) {
+        bandRenderer->record(PpuBandRenderer::EventType::RegisterRead, scanline, renderingPositionX, index);
+    }
     // Reads from non-read registers are returning open bus contents
     u8 result = openBusContents;
     if(index == 2) { // 0x2002 PPUSTATUS - Ppu status register
@@ -98,6 +201,9 @@ u8 Ppu::read(u8 index)
             increment = 32;    
         }
         registers.vaddr.vramAddress = registers.vaddr.vramAddress + increment;
+        if (predictionCheck) {
+            updatePredictions();
+        }
     }
     return result;
 }
@@ -107,6 +213,12 @@ u8 Ppu::read(u8 index)
  */
 void Ppu::write(u8 index, u8 data)
 {
+    if (timeline) {
+        recordTimelineEvent(PpuTimelineEventType::RegisterWrite, 0x2000 | index, data);
+    }
+    if (renderMode == PpuRenderMode::Deferred) {
+        bandRenderer->record(PpuBandRenderer::EventType::RegisterWrite, scanline, renderingPositionX, index, data);
+    }
     refreshOpenBus(data);
     if(index == 0) { // 0x2000 PPUCTRL - Ppu control register
         auto oldVBlankNmi = registers.ppuCtrl.VBlankNmi;
@@ -119,7 +231,12 @@ void Ppu::write(u8 index, u8 data)
             nmiTriggerCallback();
         }
     } else if (index == 1) { // 0x2001 PPUMASK - Ppu mask register
+        auto oldPpuMask = registers.ppuMask.raw;
         registers.ppuMask = data;
+        // Greyscale and emphasis bits are affecting all of the palette colors
+        if ((oldPpuMask ^ data) & 0xE1) {
+            updatePaletteCache();
+        }
     } else if (index == 3) { // 0x2003 OAMADDR - OAM address port
         registers.oamAddr = data;
     } else if (index == 4) { // 0x2004 OAMDATA - OAM data port
@@ -147,7 +264,8 @@ void Ppu::write(u8 index, u8 data)
             // Second write to PPUADDR updates lower bits of internal T register. 
             registers.taddr.vramAddressLow = data;
             // After an update, value of T is copied into V.
-            registers.vaddr.raw = registers.taddr.raw;
+            // Value is converted first, as copying the whole RegisterBit would overwrite fine X as well.
+            registers.vaddr.raw = static_cast<u16>(registers.taddr.raw);
         } else {
             // First write to PPUADDR updates higher bits of internal T register.
             // 14th bit of T register is not updated
@@ -169,6 +287,10 @@ void Ppu::write(u8 index, u8 data)
         }
         vramAddress = vramAddress + increment;
     }
+
+    if (predictionCheck) {
+        updatePredictions();
+    }
 }
 
 /**
@@ -197,6 +319,8 @@ void Ppu::tick()
     auto& ppuCtrl = registers.ppuCtrl;
     auto& ppuStatus = registers.ppuStatus;
 
+    tickCount++;
+
     // Progress decay of open bus contents
     decayOpenBus();
 
@@ -238,13 +362,40 @@ void Ppu::tick()
         }
         // While processing visible scanlines but not during HBLANK
         if(scanline != 261 && renderingPositionX < 256) {
-            // Render processed pixel into the framebuffer
-            renderPixel();
+            if(scanlineRenderMode == PpuRenderMode::Full) {
+                // Render processed pixel into the framebuffer
+                renderPixel();
+                if(renderingPositionX == 255) {
+                    finishScanline();
+                }
+            } else {
+                // Pixels are not rendered, only sprite 0 hit is evaluated here.
+                if(renderingPositionX == 0) {
+                    beginScanline();
+                }
+                // Sprite 0 hit is only evaluated for the pixels that sprite 0 covers.
+                // Sprites after sprite 0 in OAM3 have lower priority, so they don't affect the result.
+                const auto& spriteZero = oam3[spriteZeroSlot];
+                if(observation) {
+                    // Observation needs every pixel composed, sprite 0 hit is evaluated along the way.
+                    observePixel();
+                } else if(spriteZeroOnScanline && unsigned(renderingPositionX - spriteZero.positionX) < 8) {
+                    bool spriteZeroHit = false;
+                    composePixel(renderingPositionX, registers.ppuMask, registers.vaddr.fineX,
+                        bgShiftPattern, bgShiftAttributes, oam3.data(), spriteZeroSlot + 1, spriteZeroHit);
+                    if(spriteZeroHit) {
+                        registers.ppuStatus.spriteZeroHit = 1;
+                    }
+                }
+            }
         }
     }
 
     // At the beginning of scanline 241 PPU enters VBlank
     if(scanline == 241 && renderingPositionX == 1) {
+        // All visible pixels of the frame are rendered at this point,
+        // so the frame can be handed over to the presenter
+        finishFrame();
         ppuStatus.inVBlank = 1;
         if (ppuCtrl.VBlankNmi) {
             // Callback called whenever NMI is triggered by PPU
@@ -271,15 +422,325 @@ void Ppu::tick()
     if(renderingPositionX == 0) {
         scanlineEndPosition = 341;
         scanline = ((scanline + 1) % 262);
+        updateScanlineRenderMode();
+        if (renderMode == PpuRenderMode::Deferred && scanline <= SCREEN_HEIGHT) {
+            bandRenderer->beginScanline(*this, *frame);
+        }
+    }
+
+    if (predictionCheck) {
+        checkPredictions();
     }
 }
 
 /**
- * Return internal framebuffer. Such framebuffer was non-existent of a real PPU. 
+ * Return the latest complete frame. Such framebuffer was non-existent of a real PPU.
+ * Frames are triple buffered, so the returned frame is not modified by the PPU,
+ * until the next call of this method.
+ * 
+ * This method is meant to be called only by a single consumer (presenter).
  */
 const Ppu::Framebuffer& Ppu::getFramebuffer()
 {
-    return framebuffer;
+    return frames->acquire().pixels;
+}
+
+/**
+ * Return the latest complete frame along with row hashes. 
+ * Same rules as for getFramebuffer apply.
+ */
+const Ppu::Frame& Ppu::getFrame()
+{
+    return frames->acquire();
+}
+
+/**
+ * Checks whether PPU has completed a frame that was not yet taken by getFramebuffer.
+ */
+bool Ppu::hasNewFrame() const
+{
+    return frames->hasFresh();
+}
+
+/**
+ * Selects format of the pixels written into the framebuffer.
+ */
+void Ppu::setOutputFormat(PpuOutputFormat format)
+{
+    if (format != outputFormat) {
+        // Band workers might still be writing rows of the current frame in the previous format
+        flushRendering();
+        outputFormat = format;
+        // Cropped rows were cleared in the layout of the previous format
+        invalidateCroppedRows();
+    }
+    updatePaletteCache();
+}
+
+PpuOutputFormat Ppu::getOutputFormat() const
+{
+    return outputFormat;
+}
+
+/**
+ * Returns the size of single framebuffer pixel in bytes in the current output format. 
+ */
+unsigned Ppu::getBytesPerPixel() const
+{
+    return getBytesPerPixel(outputFormat);
+}
+
+unsigned Ppu::getBytesPerPixel(PpuOutputFormat format)
+{
+    using enum PpuOutputFormat;
+    switch (format) {
+        case Indexed8:
+            return 1;
+        case Rgba32:
+            return 4;
+        default: // Indexed9 and Rgb565
+            return 2;
+    }
+}
+
+/**
+ * Sets the callback called right after each visible scanline is rendered, 
+ * with the number of the scanline and pointer to its pixels in the current output format.
+ * Scanlines are reported in order and their pixels remain valid until the frame is published.
+ * Callback is called from the emulation thread, only for the rows that are rendered,
+ * so it is never called in the deferred mode, where rows are rendered by the band renderer.
+ */
+void Ppu::setScanlineCallback(const std::function<void(unsigned, const u8*)>& scanlineCallback)
+{
+    this->scanlineCallback = scanlineCallback;
+}
+
+/**
+ * Selects whether the PPU renders pixels itself, leaves them to the band renderer,
+ * or only keeps the timing visible behaviour.
+ */
+void Ppu::setRenderMode(PpuRenderMode mode)
+{
+    if (mode == PpuRenderMode::Deferred && !bandRenderer) {
+        bandRenderer = std::make_unique<PpuBandRenderer>(cartridge, PpuBandRenderer::getDefaultThreadCount());
+    } else if (mode != PpuRenderMode::Deferred) {
+        // Rows that are left are rendered by the PPU itself from now on
+        flushRendering();
+    }
+    renderMode = mode;
+    updateScanlineRenderMode();
+    // Palette cache is only maintained while PPU renders pixels itself
+    updatePaletteCache();
+}
+
+PpuRenderMode Ppu::getRenderMode() const
+{
+    return renderMode;
+}
+
+/**
+ * Waits for the bands of the deferred frame that are rendered on worker threads,
+ * and drops the band that is still being emulated, so its rows are left unchanged.
+ * Workers read CHR-ROM straight from the cartridge, so this has to be called before another ROM is loaded.
+ */
+void Ppu::flushRendering()
+{
+    if (bandRenderer) {
+        bandRenderer->stop();
+    }
+}
+
+/**
+ * Sets the amount of worker threads that render bands in the deferred mode, by default it depends on the host.
+ * With no threads, bands are rendered on the emulation thread.
+ */
+void Ppu::setRenderThreadCount(unsigned count)
+{
+    flushRendering();
+    bandRenderer = std::make_unique<PpuBandRenderer>(cartridge, count);
+}
+
+/**
+ * Applies options that go beyond the real hardware, values out of range are clamped.
+ * Rows that become cropped are cleared in each of the frames before it is rendered again,
+ * so that no frame published from now on shows stale pixels.
+ */
+void Ppu::setConfig(const PpuConfig& config)
+{
+    // Band workers might still be writing rows of the current frame
+    flushRendering();
+    this->config.spriteLimit = std::clamp(config.spriteLimit, HARDWARE_SPRITE_LIMIT, MAX_SPRITES_PER_SCANLINE);
+    this->config.firstVisibleRow = std::min(config.firstVisibleRow, SCREEN_HEIGHT);
+    this->config.visibleRowCount = std::min(config.visibleRowCount, SCREEN_HEIGHT - this->config.firstVisibleRow);
+    invalidateCroppedRows();
+    updateScanlineRenderMode();
+}
+
+const PpuConfig& Ppu::getConfig() const
+{
+    return config;
+}
+
+/**
+ * Attaches downsampled grayscale observation, that is fed with pixels as they are rendered.
+ * Observation is fed in every render mode. When the PPU doesn't render the pixels,
+ * they are composed only for the observation.
+ * Passing nullptr detaches the observation.
+ */
+void Ppu::setObservation(const std::shared_ptr<PpuObservation>& observation)
+{
+    this->observation = observation;
+    updatePaletteCache();
+}
+
+/**
+ * Attaches timeline that logs writes affecting rendering, or detaches it when null is given.
+ */
+void Ppu::setTimeline(const std::shared_ptr<PpuTimeline>& timeline)
+{
+    this->timeline = timeline;
+    timelineChrGeneration = cartridge->getChrGeneration();
+    timelineMirroringType = cartridge->getMirroringType();
+}
+
+/**
+ * Sets the function returning the amount of CPU cycles since the power-up, which timestamps the timeline events.
+ * Without it, PPU doesn't know about any CPU and events are logged with cycle 0.
+ */
+void Ppu::setCpuCycleCounter(const std::function<u64()>& cpuCycleCounter)
+{
+    this->cpuCycleCounter = cpuCycleCounter;
+}
+
+/**
+ * Called by the MMU after CPU has written into the cartridge address space.
+ * Mapper registers are not visible to the PPU, so bank switches and mirroring changes are found
+ * by comparing the state of the cartridge with the one seen after previous write.
+ */
+void Ppu::notifyCartridgeWrite(u16 addr, u8 value)
+{
+    if (renderMode == PpuRenderMode::Deferred) {
+        bandRenderer->record(PpuBandRenderer::EventType::CartridgeWrite, scanline, renderingPositionX);
+    }
+    // Bank switches change patterns that sprite 0 hit depends on
+    if (predictionCheck) {
+        updatePredictions();
+    }
+    if (!timeline) {
+        return;
+    }
+    const auto chrGeneration = cartridge->getChrGeneration();
+    if (chrGeneration != timelineChrGeneration) {
+        timelineChrGeneration = chrGeneration;
+        recordTimelineEvent(PpuTimelineEventType::ChrBankSwitch, addr, value);
+    }
+    const auto mirroringType = cartridge->getMirroringType();
+    if (mirroringType != timelineMirroringType) {
+        timelineMirroringType = mirroringType;
+        recordTimelineEvent(PpuTimelineEventType::MirroringChange, addr, value);
+    }
+}
+
+/**
+ * Master clock cycle of the last processed dot. Each PPU dot takes 4 master clock cycles.
+ */
+u64 Ppu::getMasterClock() const
+{
+    return tickCount * MASTER_CLOCKS_PER_DOT;
+}
+
+/**
+ * Master clock cycle at which VBlank flag will be set next.
+ */
+u64 Ppu::predictVblank()
+{
+    return PpuPredictor(*this).predictVblank();
+}
+
+/**
+ * Master clock cycle at which sprite 0 hit flag will be set next, NO_SPRITE_ZERO_HIT when it won't be set 
+ * in the upcoming frame, or nothing when it can't be predicted at the moment.
+ * Prediction holds as long as nothing that affects rendering is written in the meantime.
+ */
+std::optional<u64> Ppu::predictSpriteZeroHit()
+{
+    return PpuPredictor(*this).predictSpriteZeroHit();
+}
+
+/**
+ * Debug mode, in which predictions are made after every change to PPU state
+ * and then compared with the dots the flags are actually set at.
+ */
+void Ppu::setPredictionCheck(bool enabled)
+{
+    predictionCheck = enabled;
+    predictionCheckCount = 0;
+    predictionMismatchCount = 0;
+    previousSpriteZeroHit = registers.ppuStatus.spriteZeroHit;
+    if (predictionCheck) {
+        updatePredictions();
+    }
+}
+
+u64 Ppu::getPredictionCheckCount() const
+{
+    return predictionCheckCount;
+}
+
+u64 Ppu::getPredictionMismatchCount() const
+{
+    return predictionMismatchCount;
+}
+
+void Ppu::updatePredictions()
+{
+    PpuPredictor predictor(*this);
+    predictedVblank = predictor.predictVblank();
+    predictedSpriteZeroHit = predictor.predictSpriteZeroHit();
+}
+
+/**
+ * Called after every dot in prediction check mode, when the position already points to the next dot.
+ * Sprite 0 hit is checked when the flag gets set, or when it was predicted to be set by now, but it wasn't.
+ */
+void Ppu::checkPredictions()
+{
+    if (scanline == 241 && renderingPositionX == 2) {
+        checkPrediction(predictedVblank);
+    }
+    const bool spriteZeroHit = registers.ppuStatus.spriteZeroHit;
+    if (spriteZeroHit && !previousSpriteZeroHit) {
+        checkPrediction(predictedSpriteZeroHit);
+    } else if (!spriteZeroHit && predictedSpriteZeroHit && *predictedSpriteZeroHit <= getMasterClock()) {
+        checkPrediction(predictedSpriteZeroHit);
+    } else if (!predictedSpriteZeroHit && renderingPositionX == 0) {
+        // Prediction might become possible on the next scanline
+        predictedSpriteZeroHit = PpuPredictor(*this).predictSpriteZeroHit();
+    }
+    previousSpriteZeroHit = spriteZeroHit;
+}
+
+/**
+ * Compares the prediction with the current dot, and makes new predictions.
+ */
+void Ppu::checkPrediction(std::optional<u64> predicted)
+{
+    if (predicted) {
+        predictionCheckCount++;
+        if (*predicted != getMasterClock()) {
+            predictionMismatchCount++;
+        }
+    }
+    updatePredictions();
+}
+
+/**
+ * Records event at the current position of the PPU, together with the cycle of the CPU that caused it.
+ */
+void Ppu::recordTimelineEvent(PpuTimelineEventType type, u16 address, u8 value)
+{
+    const u64 cpuCycle = cpuCycleCounter ? cpuCycleCounter() : 0;
+    timeline->record(type, scanline, renderingPositionX, cpuCycle, address, value);
 }
 
 /**
@@ -450,6 +911,10 @@ void Ppu::decodeTiles()
             // Fetch nametable address into internal register.
             // Low 12 bits of internal V register are ORed with 2 most significant bits set to 0x2.
             nametableAddress = 0x2000 + (vaddr.raw & 0xFFF);
+            // Sprites past the hardware limit are fetched right after the regular sprite fetches
+            if (renderingPositionX == 320 && spriteRenderingPosition < spriteSecondaryOamPosition) {
+                fetchExtraSprites();
+            }
             break;
 
         case 1: // Nametable access
@@ -498,18 +963,7 @@ void Ppu::decodeTiles()
                 // similar structure has been introduced to contain sprites to be rendered in the current scanline
                 auto& currentSprite = oam3[spriteRenderingPosition];
                 currentSprite = oam2[spriteRenderingPosition];
-                unsigned y = scanline - currentSprite.positionY;
-                if(currentSprite.attributes.verticalFlip) {
-                    y ^= (ppuCtrl.spriteSize ? 15 : 7);
-                }
-                // Pattern table for the sprite pattern is chosen either based on PPUCTRL bit
-                // or from sprite attributes if we're dealing with 8x16 sprites
-                patternTableAddress = 0x1000 * (ppuCtrl.spriteSize ? currentSprite.tileIndexNumber.bank : ppuCtrl.spritePatternTableAddress);
-                // Least significant bit is not taken into account while dealing with large sprites,
-                // because their pattern is contained within 2 bytes
-                patternTableAddress += 0x10 * (ppuCtrl.spriteSize ? currentSprite.tileIndexNumber.tileNumber : currentSprite.tileIndexNumber.raw);
-                // Choose appropriate row based on previously calculated position that accounts for vertical flip
-                patternTableAddress += (y & 7) + (y & 8) * 2;
+                patternTableAddress = spritePatternAddress(currentSprite);
             }
             break;
 
@@ -557,7 +1011,9 @@ void Ppu::evaluateSprites()
         // Sprite evaluation does not take place before dot 64
         return;
     } else if (renderingPositionX == 64) {
-        for(auto& sprite : oam2) {
+        // Only slots of the real secondary OAM are cleared, the rest is only read after being filled
+        for(unsigned i = 0; i < HARDWARE_SPRITE_LIMIT; i++) {
+            auto& sprite = oam2[i];
             sprite.raw[0] = sprite.raw[1] = sprite.raw[2] = sprite.raw[3] = 0xFF;
         }
         oamTempData = oam[oamAddr];
@@ -575,12 +1031,15 @@ void Ppu::evaluateSprites()
         }
 
         // When secondary OAM hasn't been populated yet, transfer the data from primary OAM
-        if (spriteSecondaryOamPosition < 8) {
+        const bool secondaryOamFull = spriteSecondaryOamPosition >= HARDWARE_SPRITE_LIMIT;
+        if (!secondaryOamFull) {
             oam2[spriteSecondaryOamPosition].raw[spriteEvaluationPhase] = oamTempData;
         }
 
         if (spriteEvaluationPhase == 0) {
-            oam2[spriteSecondaryOamPosition].spriteIndex = oamAddr.spriteIndex;
+            if (!secondaryOamFull) {
+                oam2[spriteSecondaryOamPosition].spriteIndex = oamAddr.spriteIndex;
+            }
             // Check whether sprite vertical position overlaps currently rendered scanline
             u8 top = oamTempData;
             u8 bottom = top + (ppuCtrl.spriteSize ? 16 : 8);
@@ -592,7 +1051,7 @@ void Ppu::evaluateSprites()
 
         if (spriteEvaluationPhase == 3) {
             // TODO: Implement sprite overflow bug
-            if (spriteSecondaryOamPosition < 8) {
+            if (!secondaryOamFull) {
                 spriteSecondaryOamPosition++;
             } else {
                 // Update overflow flag in PPUSTATUS
@@ -600,23 +1059,120 @@ void Ppu::evaluateSprites()
             }
         }
     } else {
+        // Once the evaluation is over, sprites that didn't fit into secondary OAM are added if configured so
+        if (renderingPositionX == 256 && spriteSecondaryOamPosition == HARDWARE_SPRITE_LIMIT
+            && config.spriteLimit > HARDWARE_SPRITE_LIMIT) {
+            evaluateExtraSprites();
+        }
         oamTempData = oam[oamAddr];
     }
 }
 
+/**
+ * Finds sprites that are in range of the scanline, but didn't fit into secondary OAM.
+ * They are placed after the first 8 sprites, up to the configured sprite limit.
+ * Evaluation itself is left untouched, so that sprite overflow flag behaves exactly like on the hardware.
+ */
+void Ppu::evaluateExtraSprites()
+{
+    const unsigned spriteHeight = registers.ppuCtrl.spriteSize ? 16 : 8;
+    unsigned spriteIndex = oam2[HARDWARE_SPRITE_LIMIT - 1].spriteIndex + 1;
+    for (; spriteIndex < 64 && spriteSecondaryOamPosition < config.spriteLimit; spriteIndex++) {
+        // Same 8 bit comparison as during the evaluation
+        u8 top = oam[spriteIndex * 4];
+        u8 bottom = top + spriteHeight;
+        if (scanline >= top && scanline < bottom) {
+            auto& sprite = oam2[spriteSecondaryOamPosition++];
+            std::copy_n(oam.begin() + spriteIndex * 4, 4, sprite.raw);
+            sprite.spriteIndex = spriteIndex;
+        }
+    }
+}
+
+/**
+ * Fetch patterns of the sprites past the hardware limit. 
+ * There are only 8 sprite fetch slots on the real PPU, so they are all fetched at once.
+ */
+void Ppu::fetchExtraSprites()
+{
+    for (; spriteRenderingPosition < spriteSecondaryOamPosition; spriteRenderingPosition++) {
+        auto& sprite = oam3[spriteRenderingPosition];
+        sprite = oam2[spriteRenderingPosition];
+        const auto address = spritePatternAddress(sprite);
+        sprite.pattern = interleavePatternBytes(ppuRead(address), ppuRead(address | 8));
+    }
+}
+
+/**
+ * Address of the pattern row of the sprite that is rendered on the next scanline.
+ */
+u16 Ppu::spritePatternAddress(const OamData& sprite) const
+{
+    const auto& ppuCtrl = registers.ppuCtrl;
+    unsigned y = scanline - sprite.positionY;
+    if(sprite.attributes.verticalFlip) {
+        y ^= (ppuCtrl.spriteSize ? 15 : 7);
+    }
+    // Pattern table for the sprite pattern is chosen either based on PPUCTRL bit
+    // or from sprite attributes if we're dealing with 8x16 sprites
+    u16 address = 0x1000 * (ppuCtrl.spriteSize ? sprite.tileIndexNumber.bank : ppuCtrl.spritePatternTableAddress);
+    // Least significant bit is not taken into account while dealing with large sprites,
+    // because their pattern is contained within 2 bytes
+    address += 0x10 * (ppuCtrl.spriteSize ? sprite.tileIndexNumber.tileNumber : sprite.tileIndexNumber.raw);
+    // Choose appropriate row based on previously calculated position that accounts for vertical flip
+    address += (y & 7) + (y & 8) * 2;
+    return address;
+}
+
 /**
  * Render pixel based on data fetched into internal shift registers,
  * and internal PPU configuration. 
  */
 void Ppu::renderPixel()
 {
-    bool isOnEdge = renderingPositionX < 8 || renderingPositionX >= 248;
-    bool showSprites = registers.ppuMask.showSp && (!isOnEdge || registers.ppuMask.showSp8);
-    bool showBackground = registers.ppuMask.showBg && (!isOnEdge || registers.ppuMask.showBg8);
+    bool spriteZeroHit = false;
+    auto paletteIndex = composePixel(renderingPositionX, registers.ppuMask, registers.vaddr.fineX,
+        bgShiftPattern, bgShiftAttributes, oam3.data(), spriteRenderingPosition, spriteZeroHit);
+    if (spriteZeroHit) {
+        registers.ppuStatus.spriteZeroHit = 1;
+    }
+    // Choose pixel color from the palette that is initialized by the executed program.
+    writePixel(scanline * SCREEN_WIDTH + renderingPositionX, paletteIndex);
+    if (observation) {
+        observation->addPixel(renderingPositionX, scanline, observationLuma[paletteIndex]);
+    }
+}
+
+/**
+ * Compose pixel only to feed it into the observation, without writing it into the framebuffer.
+ */
+void Ppu::observePixel()
+{
+    bool spriteZeroHit = false;
+    auto paletteIndex = composePixel(renderingPositionX, registers.ppuMask, registers.vaddr.fineX,
+        bgShiftPattern, bgShiftAttributes, oam3.data(), spriteRenderingPosition, spriteZeroHit);
+    if (spriteZeroHit) {
+        registers.ppuStatus.spriteZeroHit = 1;
+    }
+    observation->addPixel(renderingPositionX, scanline, observationLuma[paletteIndex]);
+}
 
-    unsigned fx = registers.vaddr.fineX;
-    bool xDivisibleBy8 = (renderingPositionX & 7) == 0;
-    unsigned patternPosition = 15 - (((renderingPositionX & 7) + fx + 8 * !xDivisibleBy8) & 15);
+/**
+ * Compose pixel at given horizontal position out of background shift registers and sprites 
+ * that are rendered on the current scanline. Returns index of the color in palette memory.
+ * 
+ * State is passed in explicitly, so that only a part of the sprites can be composed,
+ * which is enough to evaluate sprite 0 hit when pixels are not rendered.
+ */
+u8 Ppu::composePixel(unsigned x, const PpuMaskRegister& ppuMask, unsigned fineX,
+    u32 bgShiftPattern, u32 bgShiftAttributes, const OamData* sprites, unsigned spriteCount, bool& spriteZeroHit)
+{
+    bool isOnEdge = x < 8 || x >= 248;
+    bool showSprites = ppuMask.showSp && (!isOnEdge || ppuMask.showSp8);
+    bool showBackground = ppuMask.showBg && (!isOnEdge || ppuMask.showBg8);
+
+    bool xDivisibleBy8 = (x & 7) == 0;
+    unsigned patternPosition = 15 - (((x & 7) + fineX + 8 * !xDivisibleBy8) & 15);
     unsigned pixel = 0;
     unsigned attributes = 0;
     // If we have to render background pixel
@@ -631,9 +1187,9 @@ void Ppu::renderPixel()
     // If we have to render sprite pixel
     if(showSprites) {
         // Get sprites that have to be rendered in the current scanline from OAM3
-        for(unsigned spriteNumber = 0; spriteNumber < spriteRenderingPosition; spriteNumber++) {
-            const auto& sprite = oam3[spriteNumber];
-            unsigned xDiff = renderingPositionX - sprite.positionX;
+        for(unsigned spriteNumber = 0; spriteNumber < spriteCount; spriteNumber++) {
+            const auto& sprite = sprites[spriteNumber];
+            unsigned xDiff = x - sprite.positionX;
             // Assert whether sprite's horizontal position overlaps position of currently rendered pixel
             if(xDiff >= 8) {
                 continue;
@@ -651,8 +1207,8 @@ void Ppu::renderPixel()
             // Check for sprite 0 hit when opaque background pixel overlaps or is overlapped by opaque sprite pixel.
             // In real world, use case for using Sprite 0 Hit flag is to check whether PPU,
             // has reached certain Y position, given by the Y position of sprite with index 0.
-            if(renderingPositionX < 255 && pixel > 0 && sprite.spriteIndex == 0) {
-                registers.ppuStatus.spriteZeroHit = 1;
+            if(x < 255 && pixel > 0 && sprite.spriteIndex == 0) {
+                spriteZeroHit = true;
             }
             // If sprite's priority is set to 0, that means that sprite should be in front of background.
             // Or background pixel is transparent, render sprites pixel.
@@ -665,12 +1221,175 @@ void Ppu::renderPixel()
         }
     }
 
-    // Choose pixel color from the palette that is initialized by the executed program.
-    // Apply greyscale if enabled in PPUMASK register
-    pixel = palette[(attributes * 4 + pixel) & 0x1F] & (registers.ppuMask.greyscale ? 0x30 : 0x3F);
-    // Update internal framebuffer
-    // Internal framebuffer holds palette color indexes that can be translated later to RGB colors
-    framebuffer[scanline * SCREEN_WIDTH + renderingPositionX] = pixel;
+    return (attributes * 4 + pixel) & 0x1F;
+}
+
+/**
+ * Write pixel into the internal framebuffer.
+ * Pixel value is taken from the palette cache, 
+ * which already holds colors converted into the current output format.
+ */
+void Ppu::writePixel(unsigned position, u8 paletteIndex)
+{
+    using enum PpuOutputFormat;
+    auto color = paletteCache[paletteIndex];
+    switch (outputFormat) {
+        case Indexed8:
+            frame->pixels[position] = static_cast<u8>(color);
+            break;
+
+        case Rgba32: {
+            u32 rgba = color;
+            std::memcpy(frame->pixels.data() + position * 4, &rgba, 4);
+            break;
+        }
+
+        default: { // Indexed9 and Rgb565
+            u16 word = static_cast<u16>(color);
+            std::memcpy(frame->pixels.data() + position * 2, &word, 2);
+            break;
+        }
+    }
+}
+
+/**
+ * Called after the last pixel of the visible scanline is rendered.
+ * Computes hash of the rendered row, so that the presenter can skip rows and frames
+ * that did not change.
+ */
+void Ppu::finishScanline()
+{
+    const auto rowSize = SCREEN_WIDTH * getBytesPerPixel();
+    const auto* row = frame->pixels.data() + scanline * rowSize;
+    frame->rowHashes[scanline] = hashRow(row, rowSize);
+    // Row is complete, so it can be streamed to the display before the frame is finished
+    if (scanlineCallback) {
+        scanlineCallback(scanline, row);
+    }
+}
+
+/**
+ * Computes hash of a single framebuffer row.
+ * Row is hashed in 4 independent 32 bit lanes. 
+ * Lanes don't depend on each other, so compiler is free to vectorize the loop.
+ */
+u32 Ppu::hashRow(const u8* row, unsigned rowSize)
+{
+    static constexpr const unsigned LANES = 4;
+    static constexpr const u32 PRIME = 0x9E3779B1u;
+
+    std::array<u32, LANES> lanes = { 0x811C9DC5u, 0x01000193u, 0x6A09E667u, 0xBB67AE85u };
+    for (unsigned i = 0; i < rowSize; i += sizeof(u32) * LANES) {
+        std::array<u32, LANES> words;
+        std::memcpy(words.data(), row + i, sizeof(words));
+        for (unsigned lane = 0; lane < LANES; lane++) {
+            lanes[lane] = (lanes[lane] ^ words[lane]) * PRIME;
+        }
+    }
+
+    u32 hash = 0;
+    for (auto lane : lanes) {
+        hash = (hash ^ lane ^ (lane >> 15)) * PRIME;
+    }
+    return hash;
+}
+
+/**
+ * Called when all of the visible scanlines are rendered.
+ * Hands the frame over to the presenter.
+ */
+void Ppu::finishFrame()
+{
+    // Deferred frame is complete once all of its bands are rendered
+    if (renderMode == PpuRenderMode::Deferred) {
+        bandRenderer->finishFrame();
+    }
+    // Nothing is presented in the timing only mode, as nothing was rendered
+    if (renderMode != PpuRenderMode::TimingOnly) {
+        frame->format = outputFormat;
+        frame->number = frameNumber++;
+        frames->publish();
+        frame = &frames->back();
+        clearCroppedRows();
+    }
+    if (observation) {
+        observation->finishFrame();
+    }
+    if (timeline) {
+        timeline->finishFrame();
+    }
+}
+
+/**
+ * Marks rows outside of the visible window as stale in all three frames, as such rows are never rendered again.
+ * Only the frame that is currently rendered is cleared right away, the presenter might be reading the others.
+ */
+void Ppu::invalidateCroppedRows()
+{
+    if (!frames) {
+        return;
+    }
+    staleCroppedFrames.clear();
+    frames->forEach([&](const Frame& frame) {
+        staleCroppedFrames.push_back(&frame);
+    });
+    clearCroppedRows();
+}
+
+/**
+ * Fills rows outside of the visible window of the frame that is currently rendered with zeros,
+ * including their row hashes, unless they were cleared already. Rows are laid out in the current output format.
+ */
+void Ppu::clearCroppedRows()
+{
+    const auto stale = std::find(staleCroppedFrames.begin(), staleCroppedFrames.end(), frame);
+    if (stale == staleCroppedFrames.end()) {
+        return;
+    }
+    staleCroppedFrames.erase(stale);
+    const auto rowSize = SCREEN_WIDTH * getBytesPerPixel();
+    const std::array<u8, SCREEN_WIDTH * MAX_BYTES_PER_PIXEL> blankRow = {};
+    const auto blankHash = hashRow(blankRow.data(), rowSize);
+    const auto lastVisibleRow = config.firstVisibleRow + config.visibleRowCount;
+    for (unsigned row = 0; row < SCREEN_HEIGHT; row++) {
+        if (row < config.firstVisibleRow || row >= lastVisibleRow) {
+            std::fill_n(frame->pixels.begin() + row * rowSize, rowSize, 0);
+            frame->rowHashes[row] = blankHash;
+        }
+    }
+}
+
+/**
+ * Resolves how the pixels of the scanline that is about to be processed are produced.
+ * Rows outside of the visible window are processed the same way as in the timing only mode,
+ * so the choice is made once per scanline instead of for every pixel.
+ * In the deferred mode all of the rows are processed that way, they are rendered by the band renderer.
+ */
+void Ppu::updateScanlineRenderMode()
+{
+    const bool visible = scanline - config.firstVisibleRow < config.visibleRowCount;
+    if (renderMode == PpuRenderMode::Full && !visible) {
+        scanlineRenderMode = PpuRenderMode::TimingOnly;
+    } else {
+        scanlineRenderMode = renderMode;
+    }
+}
+
+/**
+ * Called at the beginning of the visible scanline when pixels are not rendered by the PPU.
+ * Checks whether sprite 0 is rendered on this scanline, 
+ * so that sprite 0 hit is evaluated only on the scanlines it is needed.
+ */
+void Ppu::beginScanline()
+{
+    spriteZeroOnScanline = false;
+    for (unsigned i = 0; i < spriteRenderingPosition; i++) {
+        if (oam3[i].spriteIndex == 0) {
+            spriteZeroOnScanline = true;
+            spriteZeroSlot = i;
+            break;
+        }
+    }
 }
 
 /**
@@ -712,13 +1431,15 @@ u8 Ppu::ppuRead(u16 addr)
         if (addr >= 0x3000) {
             addr -= 0x1000;
         }
-        auto mirroringType = cartridge->getMirroringType();
-        addr = resolveNametableAddress(addr, mirroringType);
+        addr = resolveNametableAddress(addr, getMirroringType());
         return vram[addr];
     } 
 
-    // Read something from cartridge.
-    return cartridge->read(addr);
+    // Addresses between 0x0000 - 0x1FFF are occupied by pattern tables in CHR memory of the cartridge.
+    if (chrSnapshot) {
+        return chrSnapshot->read(addr);
+    }
+    return cartridge->readChr(addr);
 }
 
 /**
@@ -729,21 +1450,29 @@ void Ppu::ppuWrite(u16 addr, u8 value)
     addr &= 0x3FFF;
     if(addr >= 0x3F00) {
         // Addresses between 0x3F00 - 0x3FFF are occupied by a palette.
-        auto& palette = paletteRef(addr & 0xFF);
-        palette = value;
+        auto& paletteEntry = paletteRef(addr & 0xFF);
+        paletteEntry = value;
+        // Keep the cached color of the modified entry up to date
+        updatePaletteCache(static_cast<u8>(&paletteEntry - palette.data()));
         return;
     } else if (addr >= 0x2000) {
         // Addresses between 0x2000 - 0x3EFF are occupied by a VRAM
         if (addr >= 0x3000) {
             addr -= 0x1000;
         }
-        auto mirroringType = cartridge->getMirroringType();
-        addr = resolveNametableAddress(addr, mirroringType);
+        addr = resolveNametableAddress(addr, getMirroringType());
         vram[addr] = value;
+        dirtyVram.set(addr);
+        return;
     }
 
-    // Read something from cartridge.
-    cartridge->write(addr, value);
+    // Addresses between 0x0000 - 0x1FFF are occupied by pattern tables in CHR memory of the cartridge.
+    dirtyChrTiles.set(addr >> 4);
+    if (chrSnapshot) {
+        chrSnapshot->write(addr, value);
+        return;
+    }
+    cartridge->writeChr(addr, value);
 }
 
 /**
@@ -758,6 +1487,14 @@ void Ppu::ppuWrite(u16 addr, u8 value)
  * or is unused.
  */
 u8& Ppu::paletteRef(u8 addr)
+{
+    return palette[paletteIndex(addr)];
+}
+
+/**
+ * Resolves index of palette memory entry, accounting for the mirrored entries.
+ */
+u8 Ppu::paletteIndex(u8 addr)
 {
     if (addr % 4 == 0) {
         addr &= 0xF;
@@ -765,7 +1502,47 @@ u8& Ppu::paletteRef(u8 addr)
         addr &= 0x1F;
     }
 
-    return palette[addr];
+    return addr;
+}
+
+/**
+ * Update single entry of the palette cache.
+ * Palette cache holds the colors from palette memory converted into current output format,
+ * with greyscale and emphasis bits from PPUMASK already applied.
+ * Thanks to that, rendering a pixel is a single lookup no matter what the output format is.
+ * Luma of the colors is cached the same way when observation is attached.
+ */
+void Ppu::updatePaletteCache(u8 index)
+{
+    if (observation) {
+        auto color = PpuPalette::outputColor(palette[index], registers.ppuMask.raw, PpuOutputFormat::Indexed9);
+        observationLuma[index] = PpuPalette::luma()[color];
+    }
+    if (renderMode != PpuRenderMode::Full) {
+        return;
+    }
+    paletteCache[index] = PpuPalette::outputColor(palette[index], registers.ppuMask.raw, outputFormat);
+}
+
+/**
+ * Update whole palette cache.
+ */
+void Ppu::updatePaletteCache()
+{
+    for (u8 index = 0; index < paletteCache.size(); index++) {
+        updatePaletteCache(index);
+    }
+}
+
+/**
+ * Nametable mirroring of the cartridge, or the one captured with the pattern tables when PPU renders a band.
+ */
+MirroringType Ppu::getMirroringType() const
+{
+    if (chrSnapshot) {
+        return chrSnapshot->getMirroringType();
+    }
+    return cartridge->getMirroringType();
 }
 
 u16 Ppu::resolveNametableAddress(u16 addr, MirroringType mirroringType)
@@ -2,12 +2,24 @@
 
 #include <memory>
 #include <array>
+#include <bitset>
 #include <functional>
+#include <optional>
+#include <vector>
 
 #include "OamData.hpp"
 #include "Cartridge.hpp"
 #include "PpuRegisters.hpp"
 #include "MirroringType.hpp"
+#include "PpuOutputFormat.hpp"
+#include "TripleBuffer.hpp"
+#include "PpuRenderMode.hpp"
+#include "PpuConfig.hpp"
+#include "PpuObservation.hpp"
+#include "PpuTimeline.hpp"
+
+class PpuBandRenderer;
+class PpuChrSnapshot;
 
 /**
  * PPU - Picture Processing Unit
@@ -19,14 +31,34 @@ class Ppu
         static constexpr const unsigned SCREEN_WIDTH = 256;
         static constexpr const unsigned SCREEN_HEIGHT = 240;
         static constexpr const unsigned BUFFER_SIZE = SCREEN_WIDTH * SCREEN_HEIGHT;
-
-        using Framebuffer = std::array<u8, BUFFER_SIZE>;
+        static constexpr const unsigned MAX_BYTES_PER_PIXEL = 4;
+        static constexpr const unsigned MASTER_CLOCKS_PER_DOT = 4;
+        static constexpr const u64 NO_SPRITE_ZERO_HIT = ~u64(0);
+        static constexpr const unsigned HARDWARE_SPRITE_LIMIT = 8;
+        static constexpr const unsigned MAX_SPRITES_PER_SCANLINE = 64;
+
+        using Framebuffer = std::array<u8, BUFFER_SIZE * MAX_BYTES_PER_PIXEL>;
+
+        /**
+         * Complete frame handed over to the presenter.
+         * Apart from the pixels it contains hashes of each of the rows,
+         * that allow presenter to find rows that differ from the previously presented frame.
+         * Hashes are 32 bit, so a changed row can rarely keep its hash. Presenter has to upload
+         * the whole frame from time to time, so that such row doesn't stay stale on the screen.
+         */
+        struct Frame
+        {
+            Framebuffer pixels;
+            PpuOutputFormat format;
+            std::array<u32, SCREEN_HEIGHT> rowHashes;
+            u64 number;
+        };
 
         Ppu(const std::shared_ptr<Cartridge>& cartridge,
             const std::function<void()>& nmiTriggerCallback,
             const std::function<void()>& vblankCallback);
 
-        ~Ppu() = default;
+        ~Ppu();
 
         void reset();
 
@@ -38,9 +70,76 @@ class Ppu
 
         const Framebuffer& getFramebuffer();
 
+        const Frame& getFrame();
+
+        bool hasNewFrame() const;
+
+        void setOutputFormat(PpuOutputFormat format);
+
+        PpuOutputFormat getOutputFormat() const;
+
+        unsigned getBytesPerPixel() const;
+
+        static unsigned getBytesPerPixel(PpuOutputFormat format);
+
+        void setRenderMode(PpuRenderMode mode);
+
+        PpuRenderMode getRenderMode() const;
+
+        void flushRendering();
+
+        void setRenderThreadCount(unsigned count);
+
+        void setConfig(const PpuConfig& config);
+
+        const PpuConfig& getConfig() const;
+
+        void setObservation(const std::shared_ptr<PpuObservation>& observation);
+
+        void setScanlineCallback(const std::function<void(unsigned, const u8*)>& scanlineCallback);
+
+        void setTimeline(const std::shared_ptr<PpuTimeline>& timeline);
+
+        void setCpuCycleCounter(const std::function<u64()>& cpuCycleCounter);
+
+        void notifyCartridgeWrite(u16 addr, u8 value);
+
+        u64 getMasterClock() const;
+
+        u64 predictVblank();
+
+        std::optional<u64> predictSpriteZeroHit();
+
+        void setPredictionCheck(bool enabled);
+
+        u64 getPredictionCheckCount() const;
+
+        u64 getPredictionMismatchCount() const;
+
     private:
+        friend class PpuViewer;
+        friend class PpuPredictor;
+        friend class PpuBandRenderer;
+
         std::shared_ptr<Cartridge> cartridge;
-        std::array<u8, BUFFER_SIZE> framebuffer;
+        // Frames handed over to the presenter, PPU that renders bands for another PPU has none of its own
+        std::unique_ptr<TripleBuffer<Frame>> frames;
+        // Frame that is currently rendered
+        Frame* frame;
+        // Renders the frames in the deferred render mode, created when the mode is selected for the first time
+        std::unique_ptr<PpuBandRenderer> bandRenderer;
+        // Pattern tables and mirroring used instead of the cartridge, when PPU renders a band for another PPU
+        PpuChrSnapshot* chrSnapshot;
+        u64 frameNumber;
+        PpuRenderMode renderMode;
+        // Render mode of the current scanline, rows outside of the visible window are not rendered
+        PpuRenderMode scanlineRenderMode;
+        PpuConfig config;
+        // Frames whose rows outside of the visible window still have to be cleared before they are rendered
+        std::vector<const Frame*> staleCroppedFrames;
+        bool spriteZeroOnScanline;
+        u8 spriteZeroSlot;
+        PpuOutputFormat outputFormat;
 
         PpuRegisters registers;
 
@@ -64,10 +163,26 @@ class Ppu
         u32 bgShiftAttributes;
 
         std::array<u8, 0x800> vram;
+        // Tiles of pattern tables and bytes of VRAM modified since the debug viewer last looked at them
+        std::bitset<0x200> dirtyChrTiles;
+        std::bitset<0x800> dirtyVram;
         std::array<u8, 256> oam;
-        std::array<OamData, 8> oam2;
-        std::array<OamData, 8> oam3;
+        std::array<OamData, MAX_SPRITES_PER_SCANLINE> oam2;
+        std::array<OamData, MAX_SPRITES_PER_SCANLINE> oam3;
         std::array<u8, 32> palette;
+        std::array<u32, 32> paletteCache;
+        std::shared_ptr<PpuObservation> observation;
+        std::array<u8, 32> observationLuma;
+        std::shared_ptr<PpuTimeline> timeline;
+        u64 tickCount;
+        u64 timelineChrGeneration;
+        MirroringType timelineMirroringType;
+        bool predictionCheck;
+        bool previousSpriteZeroHit;
+        std::optional<u64> predictedSpriteZeroHit;
+        u64 predictedVblank;
+        u64 predictionCheckCount;
+        u64 predictionMismatchCount;
 
         u8 oamTempData;
         u8 spritePrimaryOamPosition;
@@ -76,6 +191,17 @@ class Ppu
 
         std::function<void()> nmiTriggerCallback;
         std::function<void()> vblankCallback;
+        std::function<void(unsigned, const u8*)> scanlineCallback;
+        std::function<u64()> cpuCycleCounter;
+
+        explicit Ppu(const std::shared_ptr<Cartridge>& cartridge);
+
+        Ppu(const std::shared_ptr<Cartridge>& cartridge,
+            const std::function<void()>& nmiTriggerCallback,
+            const std::function<void()>& vblankCallback,
+            std::unique_ptr<TripleBuffer<Frame>> frames);
+
+        void copyRenderState(const Ppu& source);
 
         u16 interleavePatternBytes(u8 lsb, u8 msb);
 
@@ -86,7 +212,28 @@ class Ppu
 
         void decodeTiles();
         void evaluateSprites();
+        void evaluateExtraSprites();
+        void fetchExtraSprites();
+        u16 spritePatternAddress(const OamData& sprite) const;
         void renderPixel();
+        void observePixel();
+        void writePixel(unsigned position, u8 paletteIndex);
+        void finishScanline();
+        void finishFrame();
+        void invalidateCroppedRows();
+        void clearCroppedRows();
+
+        void updateScanlineRenderMode();
+        void beginScanline();
+        void recordTimelineEvent(PpuTimelineEventType type, u16 address, u8 value);
+
+        void updatePredictions();
+        void checkPredictions();
+        void checkPrediction(std::optional<u64> predicted);
+
+        static u8 composePixel(unsigned x, const PpuMaskRegister& ppuMask, unsigned fineX,
+            u32 bgShiftPattern, u32 bgShiftAttributes, const OamData* sprites, unsigned spriteCount, bool& spriteZeroHit);
+        static u32 hashRow(const u8* row, unsigned rowSize);
 
         void refreshOpenBus(u8 value);
         void decayOpenBus();
@@ -95,6 +242,10 @@ class Ppu
         void ppuWrite(u16 addr, u8 value);
 
         u8& paletteRef(u8 addr);
+        static u8 paletteIndex(u8 addr);
+        void updatePaletteCache(u8 index);
+        void updatePaletteCache();
+        MirroringType getMirroringType() const;
         u16 resolveNametableAddress(u16 addr, MirroringType mirroring);
 
         static constexpr const unsigned OPEN_BUS_DECAY_TICKS = 77777;
@@ -0,0 +1,213 @@
+#include "PpuBandRenderer.hpp"
+#include "ThreadSupport.hpp"
+
+#include <algorithm>
+
+PpuBandRenderer::PpuBandRenderer(const std::shared_ptr<Cartridge>& cartridge, unsigned threadCount)
+    : cartridge(cartridge)
+    , bands()
+    , currentBand(BAND_COUNT)
+    , workers()
+    , mutex()
+    , workAvailable()
+    , workFinished()
+    , queuedBands()
+    , unfinishedBands(0)
+    , stopping(false)
+{
+    for (auto& band : bands) {
+        band.ppu = std::unique_ptr<Ppu>(new Ppu(cartridge));
+        band.ppu->chrSnapshot = &band.chr;
+        // Events of a band usually fit, unless OAM DMA happens in the middle of the frame
+        band.events.reserve(1024);
+    }
+    for (unsigned i = 0; i < threadCount; i++) {
+        workers.emplace_back([this]() {
+            work();
+        });
+    }
+}
+
+PpuBandRenderer::~PpuBandRenderer()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    workAvailable.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+/**
+ * Called by the PPU at the beginning of every visible scanline, and of the first scanline after them.
+ * When a band is left, it is handed over to the workers. When a band is entered, state of the PPU is captured for it.
+ */
+void PpuBandRenderer::beginScanline(const Ppu& ppu, Ppu::Frame& frame)
+{
+    if (ppu.scanline % BAND_HEIGHT != 0) {
+        return;
+    }
+    if (currentBand < BAND_COUNT) {
+        submit(currentBand);
+        currentBand = BAND_COUNT;
+    }
+    if (ppu.scanline >= Ppu::SCREEN_HEIGHT) {
+        return;
+    }
+    currentBand = ppu.scanline / BAND_HEIGHT;
+    auto& band = bands[currentBand];
+    band.ppu->copyRenderState(ppu);
+    band.ppu->frame = &frame;
+    band.chr.capture(*cartridge);
+    band.events.clear();
+    band.banks.clear();
+}
+
+/**
+ * Logs access to the PPU at the given position. Only accesses during the bands are needed,
+ * the ones in between are already a part of the state captured at the beginning of the next band.
+ */
+void PpuBandRenderer::record(EventType type, unsigned scanline, unsigned dot, u8 index, u8 value)
+{
+    if (currentBand >= BAND_COUNT) {
+        return;
+    }
+    auto& band = bands[currentBand];
+    u16 banks = 0;
+    if (type == EventType::CartridgeWrite) {
+        banks = static_cast<u16>(band.banks.size());
+        band.banks.push_back(PpuChrSnapshot::captureBanks(*cartridge));
+    }
+    band.events.push_back(Event { static_cast<u16>(scanline), static_cast<u16>(dot), type, index, value, banks });
+}
+
+/**
+ * Called when the visible part of the frame is emulated. Returns once all of the bands are rendered.
+ */
+void PpuBandRenderer::finishFrame()
+{
+    if (currentBand < BAND_COUNT) {
+        submit(currentBand);
+        currentBand = BAND_COUNT;
+    }
+    wait();
+}
+
+/**
+ * Waits for the bands handed over to the workers and drops the one that is being emulated.
+ */
+void PpuBandRenderer::stop()
+{
+    currentBand = BAND_COUNT;
+    wait();
+}
+
+unsigned PpuBandRenderer::getThreadCount() const
+{
+    return static_cast<unsigned>(workers.size());
+}
+
+/**
+ * Amount of workers worth having on this host. One of the cores is left for the emulation thread,
+ * without threads or spare cores bands are rendered on the emulation thread.
+ */
+unsigned PpuBandRenderer::getDefaultThreadCount()
+{
+    if (!WASM_NES_THREADS) {
+        return 0;
+    }
+    const unsigned hardwareThreads = std::thread::hardware_concurrency();
+    return std::min(BAND_COUNT, hardwareThreads > 1 ? hardwareThreads - 1 : 0);
+}
+
+void PpuBandRenderer::submit(unsigned bandIndex)
+{
+    if (workers.empty()) {
+        render(bands[bandIndex]);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queuedBands.push_back(bandIndex);
+        unfinishedBands++;
+    }
+    workAvailable.notify_one();
+}
+
+void PpuBandRenderer::wait()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    workFinished.wait(lock, [this]() {
+        return unfinishedBands == 0;
+    });
+}
+
+/**
+ * Loop of the worker thread, renders bands as they are handed over, until the renderer is destroyed.
+ */
+void PpuBandRenderer::work()
+{
+    while (true) {
+        unsigned bandIndex;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            workAvailable.wait(lock, [this]() {
+                return stopping || !queuedBands.empty();
+            });
+            if (queuedBands.empty()) {
+                return;
+            }
+            bandIndex = queuedBands.front();
+            queuedBands.pop_front();
+        }
+        render(bands[bandIndex]);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            unfinishedBands--;
+        }
+        workFinished.notify_all();
+    }
+}
+
+/**
+ * Renders the band dot by dot from the captured state.
+ * Logged accesses are replayed right before the dot they happened at is processed, same as during the emulation.
+ */
+void PpuBandRenderer::render(Band& band)
+{
+    auto& ppu = *band.ppu;
+    const unsigned endScanline = (ppu.scanline / BAND_HEIGHT + 1) * BAND_HEIGHT;
+    auto event = band.events.begin();
+    while (ppu.scanline < endScanline) {
+        while (event != band.events.end() && (event->scanline < ppu.scanline
+            || (event->scanline == ppu.scanline && event->dot <= ppu.renderingPositionX))) {
+            replay(band, *event++);
+        }
+        ppu.tick();
+    }
+}
+
+void PpuBandRenderer::replay(Band& band, const Event& event)
+{
+    auto& ppu = *band.ppu;
+    using enum EventType;
+    switch (event.type) {
+        case RegisterRead:
+            ppu.read(event.index);
+            break;
+
+        case RegisterWrite:
+            ppu.write(event.index, event.value);
+            break;
+
+        case CartridgeWrite:
+            band.chr.setBanks(band.banks[event.banks]);
+            break;
+
+        case Reset:
+            ppu.reset();
+            break;
+    }
+}
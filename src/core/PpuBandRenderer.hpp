@@ -0,0 +1,98 @@
+#pragma once
+
+#include <array>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Ppu.hpp"
+#include "PpuChrSnapshot.hpp"
+
+/**
+ * Renders pixels of the frame for the PPU running in the deferred render mode.
+ *
+ * Visible part of the frame is split into bands of scanlines. At the beginning of each band,
+ * the emulation thread captures the state of the PPU that affects rendering, and while the band is emulated,
+ * it logs every access to the PPU that affects rendering, timestamped with the scanline and dot it happened at.
+ * Once the emulation leaves the band, it is rebuilt by a copy of the PPU, that starts from the captured state
+ * and replays the log at the same dots, so the pixels are identical to the ones rendered dot by dot.
+ *
+ * Bands are rendered on worker threads while the emulation carries on, and frame is complete once
+ * all of them are finished. Without threads (wasm build without pthreads) bands are rendered
+ * on the emulation thread as soon as they are complete.
+ */
+class PpuBandRenderer
+{
+    public:
+        static constexpr const unsigned BAND_COUNT = 8;
+        static constexpr const unsigned BAND_HEIGHT = Ppu::SCREEN_HEIGHT / BAND_COUNT;
+
+        enum class EventType : u8
+        {
+            // Read of PPUSTATUS or PPUDATA, which changes the write latch or VRAM address
+            RegisterRead,
+            RegisterWrite,
+            // Write to the cartridge, which might have switched CHR banks or changed the mirroring
+            CartridgeWrite,
+            Reset
+        };
+
+        PpuBandRenderer(const std::shared_ptr<Cartridge>& cartridge, unsigned threadCount);
+
+        ~PpuBandRenderer();
+
+        void beginScanline(const Ppu& ppu, Ppu::Frame& frame);
+
+        void record(EventType type, unsigned scanline, unsigned dot, u8 index = 0, u8 value = 0);
+
+        void finishFrame();
+
+        void stop();
+
+        unsigned getThreadCount() const;
+
+        static unsigned getDefaultThreadCount();
+
+    private:
+        struct Event
+        {
+            u16 scanline;
+            u16 dot;
+            EventType type;
+            u8 index;
+            u8 value;
+            // Index of the bank configuration captured after the cartridge write
+            u16 banks;
+        };
+
+        struct Band
+        {
+            // Copy of the PPU that renders the band, starting from the state captured at its beginning
+            std::unique_ptr<Ppu> ppu;
+            PpuChrSnapshot chr;
+            std::vector<Event> events;
+            std::vector<PpuChrSnapshot::Banks> banks;
+        };
+
+        std::shared_ptr<Cartridge> cartridge;
+        std::array<Band, BAND_COUNT> bands;
+        // Band that is currently emulated, BAND_COUNT when the emulation is outside of the visible scanlines
+        unsigned currentBand;
+
+        std::vector<std::thread> workers;
+        std::mutex mutex;
+        std::condition_variable workAvailable;
+        std::condition_variable workFinished;
+        std::deque<unsigned> queuedBands;
+        unsigned unfinishedBands;
+        bool stopping;
+
+        void submit(unsigned bandIndex);
+        void wait();
+        void work();
+        void render(Band& band);
+        void replay(Band& band, const Event& event);
+};
@@ -0,0 +1,48 @@
+#include "PpuChrSnapshot.hpp"
+#include "Cartridge.hpp"
+
+PpuChrSnapshot::PpuChrSnapshot()
+    : memory(nullptr)
+    , ram()
+    , banks()
+    , writeMask(0)
+{
+}
+
+/**
+ * Captures current contents of the pattern tables. Copy of CHR-RAM reuses the memory of the previous one.
+ */
+void PpuChrSnapshot::capture(const Cartridge& cartridge)
+{
+    const auto chrMemory = cartridge.getChrMemory();
+    writeMask = cartridge.getChrWriteMask();
+    if (chrMemory.empty()) {
+        // Without a cartridge pattern tables read as zeros, same as through the cartridge
+        ram.assign(PAGE_COUNT * PAGE_SIZE, 0);
+        memory = ram.data();
+    } else if (writeMask) {
+        ram.assign(chrMemory.begin(), chrMemory.end());
+        memory = ram.data();
+    } else {
+        memory = chrMemory.data();
+    }
+    banks = captureBanks(cartridge);
+}
+
+/**
+ * Captures current bank configuration, which is enough to follow bank switches after the contents are captured.
+ */
+PpuChrSnapshot::Banks PpuChrSnapshot::captureBanks(const Cartridge& cartridge)
+{
+    Banks banks;
+    for (unsigned page = 0; page < PAGE_COUNT; page++) {
+        banks.pageOffsets[page] = cartridge.getChrPageOffset(page);
+    }
+    banks.mirroring = cartridge.getMirroringType();
+    return banks;
+}
+
+void PpuChrSnapshot::setBanks(const Banks& banks)
+{
+    this->banks = banks;
+}
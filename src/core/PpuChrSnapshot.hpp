@@ -0,0 +1,75 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include "Types.hpp"
+#include "MirroringType.hpp"
+
+class Cartridge;
+
+/**
+ * Copy of the pattern tables and nametable mirroring of the cartridge, 
+ * that doesn't change while the emulation carries on.
+ * 
+ * CHR-ROM never changes, so it is only referenced. CHR-RAM is copied, and writes are applied to the copy.
+ * Because of that snapshot can't outlive the ROM that was loaded when it was captured.
+ */
+class PpuChrSnapshot
+{
+    public:
+        static constexpr const unsigned PAGE_COUNT = 8;
+        static constexpr const unsigned PAGE_SIZE = 0x400;
+
+        /**
+         * Bank configuration of the cartridge, offsets of 1KB pattern table pages in CHR memory and the mirroring.
+         */
+        struct Banks
+        {
+            std::array<unsigned, PAGE_COUNT> pageOffsets;
+            MirroringType mirroring;
+        };
+
+        PpuChrSnapshot();
+
+        ~PpuChrSnapshot() = default;
+
+        void capture(const Cartridge& cartridge);
+
+        static Banks captureBanks(const Cartridge& cartridge);
+
+        void setBanks(const Banks& banks);
+
+        u8 read(u16 addr) const;
+
+        void write(u16 addr, u8 value);
+
+        MirroringType getMirroringType() const;
+
+    private:
+        const u8* memory;
+        std::vector<u8> ram;
+        Banks banks;
+        u8 writeMask;
+};
+
+inline u8 PpuChrSnapshot::read(u16 addr) const
+{
+    return memory[banks.pageOffsets[(addr >> 10) & 7] + (addr & (PAGE_SIZE - 1))];
+}
+
+/**
+ * Writes into the copy of CHR-RAM, writes into CHR-ROM are ignored.
+ */
+inline void PpuChrSnapshot::write(u16 addr, u8 value)
+{
+    const auto page = (addr >> 10) & 7;
+    if (writeMask & (1 << page)) {
+        ram[banks.pageOffsets[page] + (addr & (PAGE_SIZE - 1))] = value;
+    }
+}
+
+inline MirroringType PpuChrSnapshot::getMirroringType() const
+{
+    return banks.mirroring;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+/**
+ * Options of the PPU that go beyond the behaviour of the real hardware.
+ * They are meant to be chosen once at setup, the PPU resolves them per scanline,
+ * so that the pixels are composed without checking them.
+ */
+struct PpuConfig
+{
+    // Maximum amount of sprites rendered on a single scanline, between 8 (the hardware limit) and 64.
+    // Sprites above the hardware limit are found after the regular sprite evaluation,
+    // so sprite overflow flag still reports more than 8 sprites on a scanline as games expect.
+    unsigned spriteLimit = 8;
+    // Rows of the picture that are rendered. Rows outside of this window are never written into the framebuffer,
+    // only sprite 0 hit is evaluated for them. Typically used to crop the overscan area hidden by TVs.
+    unsigned firstVisibleRow = 0;
+    unsigned visibleRowCount = 240;
+};
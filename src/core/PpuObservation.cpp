@@ -0,0 +1,64 @@
+#include "PpuObservation.hpp"
+
+#include <algorithm>
+
+PpuObservation::PpuObservation(u8* buffer, unsigned width, unsigned height, PpuObservationMode mode, bool maxPooling)
+    : buffer(buffer)
+    , width(std::clamp(width, 1u, PICTURE_WIDTH))
+    , height(std::clamp(height, 1u, PICTURE_HEIGHT))
+    , mode(mode)
+    , maxPooling(maxPooling)
+    , columnOffsets()
+    , rowOffsets()
+    , sums(this->width * this->height, 0)
+    , counts(this->width * this->height, 0)
+    , previousFrame(this->width * this->height, 0)
+{
+    // Picture pixel belongs to the observation pixel that covers its position.
+    // In strided mode only the pixel in the middle of the covered area is sampled.
+    for (unsigned x = 0; x < columnOffsets.size(); x++) {
+        const auto column = x * this->width / columnOffsets.size();
+        const auto sampled = (2 * column + 1) * columnOffsets.size() / (2 * this->width);
+        columnOffsets[x] = mode == PpuObservationMode::Strided && x != sampled ? SKIPPED : column;
+    }
+    for (unsigned y = 0; y < rowOffsets.size(); y++) {
+        const auto row = y * this->height / rowOffsets.size();
+        const auto sampled = (2 * row + 1) * rowOffsets.size() / (2 * this->height);
+        rowOffsets[y] = mode == PpuObservationMode::Strided && y != sampled ? SKIPPED : row * this->width;
+    }
+    for (unsigned y = 0; y < rowOffsets.size(); y++) {
+        for (unsigned x = 0; x < columnOffsets.size(); x++) {
+            if (rowOffsets[y] != SKIPPED && columnOffsets[x] != SKIPPED) {
+                counts[rowOffsets[y] + columnOffsets[x]]++;
+            }
+        }
+    }
+}
+
+/**
+ * Called when all of the visible pixels of the frame are rendered.
+ * Writes the observation into the buffer and starts accumulating the next frame.
+ */
+void PpuObservation::finishFrame()
+{
+    for (unsigned i = 0; i < sums.size(); i++) {
+        auto value = static_cast<u8>(sums[i] / std::max(counts[i], 1u));
+        if (maxPooling) {
+            buffer[i] = std::max(value, previousFrame[i]);
+            previousFrame[i] = value;
+        } else {
+            buffer[i] = value;
+        }
+    }
+    std::fill(sums.begin(), sums.end(), 0);
+}
+
+unsigned PpuObservation::getWidth() const
+{
+    return width;
+}
+
+unsigned PpuObservation::getHeight() const
+{
+    return height;
+}
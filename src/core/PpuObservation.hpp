@@ -0,0 +1,65 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include "Types.hpp"
+#include "PpuObservationMode.hpp"
+
+/**
+ * Downsampled grayscale view of the picture, meant for reinforcement learning workloads.
+ *
+ * PPU feeds the luma of every rendered pixel directly into the observation,
+ * so that there's no need to convert and resize the full resolution framebuffer afterwards.
+ * Result is written into the caller supplied buffer of width * height bytes when the frame is finished.
+ * Optionally each observation pixel is the maximum of the last two frames, 
+ * which removes flickering of objects that are drawn every other frame.
+ */
+class PpuObservation
+{
+    public:
+        PpuObservation(u8* buffer, unsigned width, unsigned height, 
+            PpuObservationMode mode = PpuObservationMode::AreaAverage, bool maxPooling = false);
+
+        ~PpuObservation() = default;
+
+        void addPixel(unsigned x, unsigned y, u8 luma);
+
+        void finishFrame();
+
+        unsigned getWidth() const;
+
+        unsigned getHeight() const;
+
+    private:
+        static constexpr const unsigned PICTURE_WIDTH = 256;
+        static constexpr const unsigned PICTURE_HEIGHT = 240;
+
+        u8* buffer;
+        unsigned width;
+        unsigned height;
+        PpuObservationMode mode;
+        bool maxPooling;
+
+        // Offsets of observation pixels covering each picture column and row
+        std::array<u32, PICTURE_WIDTH> columnOffsets;
+        std::array<u32, PICTURE_HEIGHT> rowOffsets;
+        std::vector<u32> sums;
+        std::vector<u32> counts;
+        std::vector<u8> previousFrame;
+
+        static constexpr const u32 SKIPPED = 0xFFFFFFFF;
+};
+
+/**
+ * Called for every rendered pixel of the visible picture.
+ */
+inline void PpuObservation::addPixel(unsigned x, unsigned y, u8 luma)
+{
+    const auto column = columnOffsets[x];
+    const auto row = rowOffsets[y];
+    if (column == SKIPPED || row == SKIPPED) {
+        return;
+    }
+    sums[row + column] += luma;
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+/**
+ * Method of downsampling the picture into the observation buffer.
+ */
+enum class PpuObservationMode
+{
+    // Every observation pixel is the average of all of the picture pixels it covers.
+    AreaAverage,
+    // Every observation pixel is a single picture pixel, taken at regular intervals.
+    Strided
+};
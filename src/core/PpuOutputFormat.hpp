@@ -0,0 +1,16 @@
+#pragma once
+
+/**
+ * Pixel format of the framebuffer produced by the PPU.
+ */
+enum class PpuOutputFormat
+{
+    // 1 byte per pixel. 6 bit palette color index.
+    Indexed8,
+    // 2 bytes per pixel. 6 bit palette color index with 3 emphasis bits (from PPUMASK) on top of it.
+    Indexed9,
+    // 4 bytes per pixel. 8 bits per channel, stored in R, G, B, A byte order.
+    Rgba32,
+    // 2 bytes per pixel. 5 bits of red, 6 bits of green and 5 bits of blue packed into 16 bit word.
+    Rgb565
+};
@@ -0,0 +1,138 @@
+#include "PpuPalette.hpp"
+
+namespace
+{
+    struct Rgb
+    {
+        u8 r;
+        u8 g;
+        u8 b;
+    };
+
+    const std::array<Rgb, PpuPalette::BASE_COLOR_COUNT> BASE_COLORS = {{
+        { 0x66, 0x66, 0x66 }, { 0x00, 0x2A, 0x88 }, { 0x14, 0x12, 0xA7 }, { 0x3B, 0x00, 0xA4 },
+        { 0x5C, 0x00, 0x7E }, { 0x6E, 0x00, 0x40 }, { 0x6C, 0x06, 0x00 }, { 0x56, 0x1D, 0x00 },
+        { 0x33, 0x35, 0x00 }, { 0x0B, 0x48, 0x00 }, { 0x00, 0x52, 0x00 }, { 0x00, 0x4F, 0x08 },
+        { 0x00, 0x40, 0x4D }, { 0x00, 0x00, 0x00 }, { 0x00, 0x00, 0x00 }, { 0x00, 0x00, 0x00 },
+        { 0xAD, 0xAD, 0xAD }, { 0x15, 0x5F, 0xD9 }, { 0x42, 0x40, 0xFF }, { 0x75, 0x27, 0xFE },
+        { 0xA0, 0x1A, 0xCC }, { 0xB7, 0x1E, 0x7B }, { 0xB5, 0x31, 0x20 }, { 0x99, 0x3E, 0x00 },
+        { 0x6B, 0x6D, 0x00 }, { 0x38, 0x87, 0x00 }, { 0x0C, 0x93, 0x00 }, { 0x00, 0x8F, 0x32 },
+        { 0x00, 0x7C, 0x8D }, { 0x00, 0x00, 0x00 }, { 0x00, 0x00, 0x00 }, { 0x00, 0x00, 0x00 },
+        { 0xFF, 0xFE, 0xFF }, { 0x64, 0xB0, 0xFF }, { 0x92, 0x90, 0xFF }, { 0xC6, 0x76, 0xFF },
+        { 0xF3, 0x6A, 0xFF }, { 0xFE, 0x6E, 0xCC }, { 0xFE, 0x81, 0x70 }, { 0xEA, 0x9E, 0x22 },
+        { 0xBC, 0xBE, 0x00 }, { 0x88, 0xD8, 0x00 }, { 0x5C, 0xE4, 0x30 }, { 0x45, 0xE0, 0x82 },
+        { 0x48, 0xCD, 0xDE }, { 0x4F, 0x4F, 0x4F }, { 0x00, 0x00, 0x00 }, { 0x00, 0x00, 0x00 },
+        { 0xFF, 0xFE, 0xFF }, { 0xC0, 0xDF, 0xFF }, { 0xD3, 0xD2, 0xFF }, { 0xE8, 0xC8, 0xFF },
+        { 0xFB, 0xC2, 0xFF }, { 0xFE, 0xC4, 0xEA }, { 0xFE, 0xCC, 0xC5 }, { 0xF7, 0xD8, 0xA5 },
+        { 0xE4, 0xE5, 0x94 }, { 0xCF, 0xEF, 0x96 }, { 0xBD, 0xF4, 0xAB }, { 0xB3, 0xF3, 0xCC },
+        { 0xB5, 0xEB, 0xF2 }, { 0xB8, 0xB8, 0xB8 }, { 0x00, 0x00, 0x00 }, { 0x00, 0x00, 0x00 }
+    }};
+
+    /**
+     * Applies color emphasis to the base color.
+     * Every emphasis bit darkens two color channels that are not emphasized.
+     * Attenuation factor is an approximation of the one measured on a real 2C02.
+     */
+    Rgb emphasize(Rgb color, unsigned emphasis)
+    {
+        static constexpr const unsigned ATTENUATION = 209; // ~0.816 in 8.8 fixed point
+        unsigned r = color.r;
+        unsigned g = color.g;
+        unsigned b = color.b;
+        if (emphasis & 1) { // Red
+            g = g * ATTENUATION >> 8;
+            b = b * ATTENUATION >> 8;
+        }
+        if (emphasis & 2) { // Green
+            r = r * ATTENUATION >> 8;
+            b = b * ATTENUATION >> 8;
+        }
+        if (emphasis & 4) { // Blue
+            r = r * ATTENUATION >> 8;
+            g = g * ATTENUATION >> 8;
+        }
+        return Rgb { static_cast<u8>(r), static_cast<u8>(g), static_cast<u8>(b) };
+    }
+}
+
+/**
+ * Lookup table of 32 bit colors. Each color is stored in R, G, B, A byte order.
+ */
+const std::array<u32, PpuPalette::COLOR_COUNT>& PpuPalette::rgba32()
+{
+    static const auto table = buildRgba32();
+    return table;
+}
+
+/**
+ * Lookup table of 16 bit colors in RGB565 format.
+ */
+const std::array<u16, PpuPalette::COLOR_COUNT>& PpuPalette::rgb565()
+{
+    static const auto table = buildRgb565();
+    return table;
+}
+
+/**
+ * Lookup table of 8 bit grayscale intensities (BT.601 luma) of the colors.
+ */
+const std::array<u8, PpuPalette::COLOR_COUNT>& PpuPalette::luma()
+{
+    static const auto table = buildLuma();
+    return table;
+}
+
+/**
+ * Converts value from palette memory into the color in given output format,
+ * applying greyscale and emphasis bits of PPUMASK register.
+ */
+u32 PpuPalette::outputColor(u8 paletteValue, u8 ppuMask, PpuOutputFormat format)
+{
+    using enum PpuOutputFormat;
+    // Apply greyscale if enabled in PPUMASK register
+    u16 color = paletteValue & (ppuMask & 0x01 ? 0x30 : 0x3F);
+    // Emphasis bits are placed directly above 6 bit color index
+    color |= (ppuMask & 0xE0) << 1;
+    switch (format) {
+        case Indexed8:
+            return color & 0x3F;
+        case Indexed9:
+            return color;
+        case Rgba32:
+            return rgba32()[color];
+        case Rgb565:
+            return rgb565()[color];
+    }
+    return color;
+}
+
+std::array<u32, PpuPalette::COLOR_COUNT> PpuPalette::buildRgba32()
+{
+    std::array<u32, COLOR_COUNT> table;
+    for (unsigned i = 0; i < COLOR_COUNT; i++) {
+        auto color = emphasize(BASE_COLORS[i % BASE_COLOR_COUNT], i / BASE_COLOR_COUNT);
+        // Bytes are laid out in memory as R, G, B, A (little endian host is assumed)
+        table[i] = u32(color.r) | u32(color.g) << 8 | u32(color.b) << 16 | 0xFF000000u;
+    }
+    return table;
+}
+
+std::array<u16, PpuPalette::COLOR_COUNT> PpuPalette::buildRgb565()
+{
+    std::array<u16, COLOR_COUNT> table;
+    for (unsigned i = 0; i < COLOR_COUNT; i++) {
+        auto color = emphasize(BASE_COLORS[i % BASE_COLOR_COUNT], i / BASE_COLOR_COUNT);
+        table[i] = static_cast<u16>((color.r >> 3) << 11 | (color.g >> 2) << 5 | (color.b >> 3));
+    }
+    return table;
+}
+
+std::array<u8, PpuPalette::COLOR_COUNT> PpuPalette::buildLuma()
+{
+    std::array<u8, COLOR_COUNT> table;
+    for (unsigned i = 0; i < COLOR_COUNT; i++) {
+        auto color = emphasize(BASE_COLORS[i % BASE_COLOR_COUNT], i / BASE_COLOR_COUNT);
+        table[i] = static_cast<u8>((299 * color.r + 587 * color.g + 114 * color.b + 500) / 1000);
+    }
+    return table;
+}
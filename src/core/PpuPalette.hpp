@@ -0,0 +1,42 @@
+#pragma once
+
+#include <array>
+
+#include "Types.hpp"
+#include "PpuOutputFormat.hpp"
+
+/**
+ * System palette of the 2C02 PPU.
+ * 
+ * PPU does not output RGB colors, but a composite video signal.
+ * Each of 64 colors that are addressable by palette memory, can be additionaly
+ * modified by 3 emphasis bits from PPUMASK register, which gives 512 possible colors in total.
+ * 
+ * Index of the color used to address the lookup tables is a 9 bit value:
+ * 
+ * 876543210
+ * |||||||||
+ * |||++++++-- Palette color index
+ * ||+-------- Emphasize red
+ * |+--------- Emphasize green
+ * +---------- Emphasize blue
+ */
+class PpuPalette
+{
+    public:
+        static constexpr const unsigned BASE_COLOR_COUNT = 64;
+        static constexpr const unsigned COLOR_COUNT = BASE_COLOR_COUNT * 8;
+
+        static const std::array<u32, COLOR_COUNT>& rgba32();
+
+        static const std::array<u16, COLOR_COUNT>& rgb565();
+
+        static const std::array<u8, COLOR_COUNT>& luma();
+
+        static u32 outputColor(u8 paletteValue, u8 ppuMask, PpuOutputFormat format);
+
+    private:
+        static std::array<u32, COLOR_COUNT> buildRgba32();
+        static std::array<u16, COLOR_COUNT> buildRgb565();
+        static std::array<u8, COLOR_COUNT> buildLuma();
+};
@@ -0,0 +1,180 @@
+#include "PpuPredictor.hpp"
+#include "Ppu.hpp"
+
+#include <algorithm>
+
+PpuPredictor::PpuPredictor(Ppu& ppu)
+    : ppu(ppu)
+{
+}
+
+/**
+ * Timestamp of the dot at which VBlank flag will be set next (dot 1 of scanline 241).
+ */
+u64 PpuPredictor::predictVblank() const
+{
+    return timestampAt(241, 1, false);
+}
+
+/**
+ * Timestamp of the dot at which sprite 0 hit flag will be set next.
+ * Ppu::NO_SPRITE_ZERO_HIT is returned when sprite 0 doesn't overlap the background in the upcoming frame.
+ *
+ * Position of sprite 0, its pattern, nametables and scroll are used to find the first pixel
+ * where opaque pixels of sprite 0 and background overlap, following the same rules as rendering.
+ * Data of the scanline is fetched during the previous scanline, starting with sprite evaluation at dot 64.
+ * When the hit could happen on a scanline that is already being fetched, it can't be predicted
+ * from the current state and no value is returned.
+ */
+std::optional<u64> PpuPredictor::predictSpriteZeroHit() const
+{
+    const auto& registers = ppu.registers;
+    const auto& ppuCtrl = registers.ppuCtrl;
+    const auto& ppuMask = registers.ppuMask;
+    if (!ppuMask.showBg || !ppuMask.showSp) {
+        return Ppu::NO_SPRITE_ZERO_HIT;
+    }
+
+    // Hit is set once per frame, so if it is already set, the next one will happen in the next frame.
+    // Next frame starts with vertical scroll copied from T register at dot 304 of pre-render scanline.
+    const bool nextFrame = ppu.scanline >= Ppu::SCREEN_HEIGHT || registers.ppuStatus.spriteZeroHit;
+    const bool scrollCopied = ppu.scanline == 261 && ppu.renderingPositionX > 304;
+    PpuInternalRegister vaddr = nextFrame && !scrollCopied ? registers.taddr : registers.vaddr;
+    unsigned line = 0;
+    unsigned firstPredictedLine = 0;
+    if (!nextFrame) {
+        // Vertical scroll is incremented at dot 251
+        line = ppu.renderingPositionX <= 251 ? ppu.scanline : ppu.scanline + 1;
+        firstPredictedLine = ppu.renderingPositionX <= 64 ? ppu.scanline + 1 : ppu.scanline + 2;
+    }
+
+    const u8 spriteY = ppu.oam[0];
+    const u8 tileIndex = ppu.oam[1];
+    const u8 attributes = ppu.oam[2];
+    const u8 spriteX = ppu.oam[3];
+    const unsigned spriteHeight = ppuCtrl.spriteSize ? 16 : 8;
+    // Sprite evaluation compares 8 bit positions, so sprites that would reach past scanline 255 are never rendered.
+    // Sprite is visible on the scanlines following the ones it was found on by the evaluation.
+    if (spriteY + spriteHeight > 255) {
+        return Ppu::NO_SPRITE_ZERO_HIT;
+    }
+    const unsigned firstSpriteLine = spriteY + 1;
+    const unsigned lastSpriteLine = std::min(spriteY + spriteHeight, Ppu::SCREEN_HEIGHT - 1);
+    if (!nextFrame) {
+        // Scanlines which still have pixels to render, but which data is already being fetched
+        const unsigned firstRemainingLine = ppu.renderingPositionX < 255 ? ppu.scanline : ppu.scanline + 1;
+        const unsigned lastFetchedLine = firstPredictedLine - 1;
+        if (firstRemainingLine <= lastFetchedLine && firstRemainingLine <= lastSpriteLine && firstSpriteLine <= lastFetchedLine) {
+            return std::nullopt;
+        }
+    }
+
+    for (; line < firstPredictedLine; line++) {
+        incrementScrollY(vaddr);
+    }
+    for (; line <= lastSpriteLine; line++, incrementScrollY(vaddr)) {
+        if (line < firstSpriteLine) {
+            continue;
+        }
+        // Sprite row is chosen the same way as it is during sprite fetches on the previous scanline
+        unsigned row = line - 1 - spriteY;
+        if (attributes & 0x80) {
+            row ^= spriteHeight - 1;
+        }
+        u16 patternAddress = ppuCtrl.spriteSize 
+            ? 0x1000 * (tileIndex & 1) + 0x10 * (tileIndex & 0xFE)
+            : 0x1000 * ppuCtrl.spritePatternTableAddress + 0x10 * tileIndex;
+        patternAddress += (row & 7) + (row & 8) * 2;
+        const u8 lsb = ppu.ppuRead(patternAddress);
+        const u8 msb = ppu.ppuRead(patternAddress | 8);
+
+        for (unsigned i = 0; i < 8; i++) {
+            const unsigned x = spriteX + i;
+            // Hit is never detected at the last pixel
+            if (x >= 255) {
+                break;
+            }
+            const bool isOnEdge = x < 8 || x >= 248;
+            if (isOnEdge && (!ppuMask.showBg8 || !ppuMask.showSp8)) {
+                continue;
+            }
+            const unsigned bit = (attributes & 0x40) ? i : 7 - i;
+            if (!(((lsb | msb) >> bit) & 1)) {
+                continue;
+            }
+            if (isBackgroundOpaque(vaddr, x)) {
+                return timestampAt(line, x, nextFrame);
+            }
+        }
+    }
+    return Ppu::NO_SPRITE_ZERO_HIT;
+}
+
+/**
+ * Master clock at which given dot will be processed, either in the current or in the next frame.
+ * Pre-render scanline of the odd frames is one dot shorter when background rendering is enabled.
+ */
+u64 PpuPredictor::timestampAt(unsigned targetScanline, unsigned targetDot, bool nextFrame) const
+{
+    u64 dots = 0;
+    unsigned scanline = ppu.scanline;
+    unsigned dot = ppu.renderingPositionX;
+    bool oddFrame = ppu.evenOddFrameToggle;
+    // Dot in the next frame can only be reached after the pre-render scanline is finished
+    bool frameStarted = !nextFrame;
+    while (!frameStarted || scanline != targetScanline || dot > targetDot) {
+        unsigned length = 341;
+        if (scanline == 261) {
+            frameStarted = true;
+            length = dot > 337 ? ppu.scanlineEndPosition : (oddFrame && ppu.registers.ppuMask.showBg ? 340 : 341);
+        } else if (scanline == 260) {
+            // Frame parity is toggled at the last dot of scanline 260
+            oddFrame = !oddFrame;
+        }
+        dots += length - dot;
+        scanline = (scanline + 1) % 262;
+        dot = 0;
+    }
+    dots += targetDot - dot;
+    // Position of the PPU is the dot that will be processed by the next tick
+    return (ppu.tickCount + dots + 1) * Ppu::MASTER_CLOCKS_PER_DOT;
+}
+
+/**
+ * Checks background pixel at given position of the scanline, which vertical scroll is given.
+ * Horizontal scroll is copied from T register before the scanline is fetched.
+ */
+bool PpuPredictor::isBackgroundOpaque(const PpuInternalRegister& vaddr, unsigned x) const
+{
+    const auto& registers = ppu.registers;
+    const auto& taddr = registers.taddr;
+    const unsigned scrolledX = registers.vaddr.fineX + x;
+    const unsigned column = taddr.coarseX + scrolledX / 8;
+    // Crossing the right edge of the nametable switches to the horizontally adjacent one
+    const unsigned horizontalNametable = taddr.baseHorizontalNametable ^ (column >= 32 ? 1 : 0);
+    const u16 nametableAddress = 0x2000
+        | (vaddr.baseVerticalNametable << 11)
+        | (horizontalNametable << 10)
+        | (vaddr.coarseY << 5)
+        | (column & 31);
+    const u8 tile = ppu.ppuRead(nametableAddress);
+    const u16 patternAddress = (registers.ppuCtrl.backgroundPatternTableAddress << 12) + (tile << 4) + vaddr.fineY;
+    const unsigned bit = 7 - scrolledX % 8;
+    return ((ppu.ppuRead(patternAddress) | ppu.ppuRead(patternAddress | 8)) >> bit) & 1;
+}
+
+/**
+ * Same as Ppu::incrementScrollY, but operating on a copy of V register.
+ */
+void PpuPredictor::incrementScrollY(PpuInternalRegister& vaddr)
+{
+    vaddr.fineY++;
+    if (vaddr.fineY == 0) {
+        if (vaddr.coarseY == 29) {
+            vaddr.coarseY = 0;
+            vaddr.baseVerticalNametable = ~vaddr.baseVerticalNametable;
+        } else {
+            vaddr.coarseY++;
+        }
+    }
+}
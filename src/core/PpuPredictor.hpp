@@ -0,0 +1,36 @@
+#pragma once
+
+#include <optional>
+
+#include "Types.hpp"
+#include "PpuRegisters.hpp"
+
+class Ppu;
+
+/**
+ * Predicts when VBlank and sprite 0 hit flags of PPUSTATUS are going to be set next,
+ * assuming that the state of the PPU and the cartridge doesn't change in the meantime.
+ *
+ * Games usually wait for these flags by polling PPUSTATUS in a loop. Knowing the exact time
+ * the flag is set allows to skip such loop altogether.
+ * Timestamps are expressed in master clock cycles, comparable with Ppu::getMasterClock().
+ */
+class PpuPredictor
+{
+    public:
+        PpuPredictor(Ppu& ppu);
+
+        ~PpuPredictor() = default;
+
+        u64 predictVblank() const;
+
+        std::optional<u64> predictSpriteZeroHit() const;
+
+    private:
+        Ppu& ppu;
+
+        u64 timestampAt(unsigned targetScanline, unsigned targetDot, bool nextFrame) const;
+        bool isBackgroundOpaque(const PpuInternalRegister& vaddr, unsigned x) const;
+
+        static void incrementScrollY(PpuInternalRegister& vaddr);
+};
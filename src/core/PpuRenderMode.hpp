@@ -0,0 +1,17 @@
+#pragma once
+
+/**
+ * Mode in which PPU produces the picture.
+ */
+enum class PpuRenderMode
+{
+    // Pixels are rendered by the PPU dot by dot, as the emulation progresses.
+    Full,
+    // PPU only keeps the timing visible behaviour (VBlank, NMI, sprite 0 hit, sprite overflow),
+    // nothing is rendered.
+    // Meant for headless runs, where nobody looks at the picture.
+    TimingOnly,
+    // PPU keeps the timing visible behaviour like in the timing only mode, and logs everything that affects rendering.
+    // Pixels are rendered from that log in bands of scanlines on worker threads, off the emulation thread.
+    Deferred
+};
@@ -0,0 +1,94 @@
+#include "PpuTimeline.hpp"
+
+#include <sstream>
+
+namespace
+{
+    const char* eventTypeName(PpuTimelineEventType type)
+    {
+        using enum PpuTimelineEventType;
+        switch (type) {
+            case RegisterWrite:
+                return "register";
+            case ChrBankSwitch:
+                return "chrBank";
+            case MirroringChange:
+                return "mirroring";
+        }
+        return "unknown";
+    }
+}
+
+PpuTimeline::PpuTimeline(unsigned capacity)
+    : recording { std::vector<Event>(capacity), 0, 0, {} }
+    , completed { std::vector<Event>(capacity), 0, 0, {} }
+{
+}
+
+/**
+ * Called at the beginning of vertical blank. 
+ * Makes the log of just finished frame available and starts recording the next one, reusing the buffer.
+ */
+void PpuTimeline::finishFrame()
+{
+    std::swap(recording, completed);
+    recording.size = 0;
+    recording.dropped = 0;
+    recording.unstableScanlines.reset();
+}
+
+/**
+ * Events of the last completed frame, in the order they happened.
+ */
+std::span<const PpuTimeline::Event> PpuTimeline::getEvents() const
+{
+    return std::span<const Event>(completed.events.data(), completed.size);
+}
+
+unsigned PpuTimeline::getDroppedEventCount() const
+{
+    return completed.dropped;
+}
+
+/**
+ * Tells whether the visible scanline of the last completed frame was rendered without any changes
+ * to the PPU state in the middle of it. Dropped events are accounted for as well.
+ */
+bool PpuTimeline::isScanlineStable(unsigned scanline) const
+{
+    return scanline < VISIBLE_SCANLINES && !completed.unstableScanlines[scanline];
+}
+
+unsigned PpuTimeline::getStableScanlineCount() const
+{
+    return VISIBLE_SCANLINES - completed.unstableScanlines.count();
+}
+
+/**
+ * Dumps the last completed frame as JSON object, with the list of events and unstable scanlines.
+ */
+std::string PpuTimeline::toJson() const
+{
+    std::ostringstream json;
+    json << "{\"events\":[";
+    for (unsigned i = 0; i < completed.size; i++) {
+        const auto& event = completed.events[i];
+        json << (i ? "," : "")
+            << "{\"type\":\"" << eventTypeName(event.type) << "\""
+            << ",\"scanline\":" << event.scanline
+            << ",\"dot\":" << event.dot
+            << ",\"cpuCycle\":" << event.cpuCycle
+            << ",\"address\":" << event.address
+            << ",\"value\":" << unsigned(event.value) << "}";
+    }
+    json << "],\"droppedEvents\":" << completed.dropped << ",\"unstableScanlines\":[";
+    bool first = true;
+    for (unsigned scanline = 0; scanline < VISIBLE_SCANLINES; scanline++) {
+        if (completed.unstableScanlines[scanline]) {
+            json << (first ? "" : ",") << scanline;
+            first = false;
+        }
+    }
+    json << "]}";
+    return json.str();
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <bitset>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "Types.hpp"
+#include "PpuTimelineEventType.hpp"
+
+/**
+ * Log of the writes that affect rendering, timestamped with the position of the PPU and the CPU cycle.
+ * Meant for analysis of raster effects, like split scrolling or palette changes in the middle of the frame.
+ *
+ * Frame in the log starts at the beginning of the vertical blank preceding it, 
+ * so it contains both the setup done by NMI handler and the writes done during rendering.
+ * Events are stored in preallocated buffer, events that don't fit are counted, but dropped.
+ *
+ * Scanline is unstable when some of the events could have changed its rendering while it was in progress.
+ * Remaining scanlines could be rendered as a whole at once, using the state from their beginning.
+ */
+class PpuTimeline
+{
+    public:
+        static constexpr const unsigned DEFAULT_CAPACITY = 4096;
+        static constexpr const unsigned VISIBLE_SCANLINES = 240;
+
+        struct Event
+        {
+            u64 cpuCycle;
+            u16 scanline;
+            u16 dot;
+            u16 address;
+            u8 value;
+            PpuTimelineEventType type;
+        };
+
+        PpuTimeline(unsigned capacity = DEFAULT_CAPACITY);
+
+        ~PpuTimeline() = default;
+
+        void record(PpuTimelineEventType type, unsigned scanline, unsigned dot, u64 cpuCycle, u16 address, u8 value);
+
+        void finishFrame();
+
+        std::span<const Event> getEvents() const;
+
+        unsigned getDroppedEventCount() const;
+
+        bool isScanlineStable(unsigned scanline) const;
+
+        unsigned getStableScanlineCount() const;
+
+        std::string toJson() const;
+
+    private:
+        struct Log
+        {
+            std::vector<Event> events;
+            unsigned size;
+            unsigned dropped;
+            std::bitset<VISIBLE_SCANLINES> unstableScanlines;
+        };
+
+        // Log of the frame in progress and the last completed one
+        Log recording;
+        Log completed;
+};
+
+/**
+ * Called by the PPU for every event, when timeline is attached.
+ */
+inline void PpuTimeline::record(PpuTimelineEventType type, unsigned scanline, unsigned dot, u64 cpuCycle, u16 address, u8 value)
+{
+    // PPUSTATUS is read only, writing to it has no effect on rendering
+    if (type != PpuTimelineEventType::RegisterWrite || address != 0x2002) {
+        // Writes during visible dots 0..255 change the scanline in progress, 
+        // later writes change fetches of the next scanline (pre-render scanline 261 is followed by scanline 0)
+        const auto affectedScanline = dot < 256 ? scanline : (scanline + 1) % 262;
+        if (affectedScanline < VISIBLE_SCANLINES) {
+            recording.unstableScanlines.set(affectedScanline);
+        }
+    }
+    if (recording.size == recording.events.size()) {
+        recording.dropped++;
+        return;
+    }
+    recording.events[recording.size++] = Event { cpuCycle, static_cast<u16>(scanline), static_cast<u16>(dot), address, value, type };
+}
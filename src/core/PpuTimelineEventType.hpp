@@ -0,0 +1,14 @@
+#pragma once
+
+/**
+ * Kind of the event recorded in PPU timeline.
+ */
+enum class PpuTimelineEventType
+{
+    // Write to one of the PPU registers at 0x2000 - 0x2007
+    RegisterWrite,
+    // Write to the mapper that switched CHR banks visible to the PPU
+    ChrBankSwitch,
+    // Write to the mapper that changed the nametable mirroring
+    MirroringChange
+};
@@ -0,0 +1,302 @@
+#include "PpuViewer.hpp"
+#include "Ppu.hpp"
+#include "PpuPalette.hpp"
+
+#include <algorithm>
+
+PpuViewer::PpuViewer(Ppu& ppu)
+    : ppu(ppu)
+    , initialized(false)
+    , chrGeneration(0)
+    , mirroringType(MirroringType::Horizontal)
+    , ppuCtrl(0)
+    , ppuMask(0)
+    , patternTablePalette(0)
+    , patternTablePaletteChanged(false)
+    , palette()
+    , colors()
+    , oam()
+    , redrawnTileCount(0)
+    , tiles(TILE_COUNT * TILE_SIZE * TILE_SIZE)
+    , changedTiles()
+    , patternTables(PATTERN_TABLES_WIDTH * PATTERN_TABLES_HEIGHT)
+    , nametables(NAMETABLES_WIDTH * NAMETABLES_HEIGHT)
+    , sprites(SPRITES_WIDTH * SPRITES_HEIGHT)
+    , paletteView(PALETTE_WIDTH * PALETTE_HEIGHT)
+    , scrollWindowBackup()
+{
+}
+
+/**
+ * Brings all the views up to date with the PPU memory.
+ * Has to be called from the emulation thread, preferably from the vblank callback, when the frame is complete.
+ * First refresh draws everything, subsequent ones only redraw tiles affected by the changes since the previous refresh.
+ */
+void PpuViewer::refresh()
+{
+    redrawnTileCount = 0;
+    // Outline is drawn over the nametables, so it has to be removed before tiles below it are redrawn
+    eraseScrollWindow();
+
+    const auto generation = ppu.cartridge->getChrGeneration();
+    decodeTiles(!initialized || generation != chrGeneration);
+    chrGeneration = generation;
+
+    // Greyscale and emphasis bits of PPUMASK modify every color
+    const u8 mask = ppu.registers.ppuMask.raw & 0xE1;
+    std::array<u8, 32> currentPalette;
+    for (unsigned i = 0; i < currentPalette.size(); i++) {
+        currentPalette[i] = ppu.palette[Ppu::paletteIndex(i)];
+    }
+    const bool paletteChanged = !initialized || currentPalette != palette || mask != ppuMask;
+    if (paletteChanged) {
+        palette = currentPalette;
+        ppuMask = mask;
+        for (unsigned i = 0; i < colors.size(); i++) {
+            colors[i] = PpuPalette::outputColor(palette[i], ppuMask, PpuOutputFormat::Rgba32);
+        }
+        refreshPalette();
+    }
+
+    const auto currentMirroringType = ppu.cartridge->getMirroringType();
+    const u8 currentPpuCtrl = ppu.registers.ppuCtrl.raw;
+    // Background pattern table select
+    const bool nametableLayoutChanged = !initialized || currentMirroringType != mirroringType
+        || ((currentPpuCtrl ^ ppuCtrl) & 0x10);
+    // Sprite pattern table select and sprite size
+    const bool spriteLayoutChanged = !initialized || ((currentPpuCtrl ^ ppuCtrl) & 0x28);
+    mirroringType = currentMirroringType;
+    ppuCtrl = currentPpuCtrl;
+
+    refreshPatternTables(paletteChanged || patternTablePaletteChanged);
+    refreshNametables(paletteChanged || nametableLayoutChanged);
+    refreshSprites(paletteChanged || spriteLayoutChanged);
+    drawScrollWindow();
+
+    ppu.dirtyVram.reset();
+    patternTablePaletteChanged = false;
+    initialized = true;
+}
+
+/**
+ * Selects one of the 8 palettes (first 4 are background palettes, last 4 are sprite palettes),
+ * used to draw the pattern tables. Takes effect on the next refresh.
+ */
+void PpuViewer::setPatternTablePalette(unsigned paletteNumber)
+{
+    paletteNumber &= 7;
+    patternTablePaletteChanged |= paletteNumber != patternTablePalette;
+    patternTablePalette = paletteNumber;
+}
+
+/**
+ * Pattern tables at 0x0000 and 0x1000, next to each other.
+ */
+const u32* PpuViewer::getPatternTables() const
+{
+    return patternTables.data();
+}
+
+/**
+ * Nametables at 0x2000, 0x2400, 0x2800, 0x2C00 arranged in 2x2 grid,
+ * with the outline of the screen as scrolled by the T register.
+ * For games that split the screen, it's the scroll of the last part of the frame.
+ */
+const u32* PpuViewer::getNametables() const
+{
+    return nametables.data();
+}
+
+/**
+ * Sprites in 8 rows of 8 sprites. 8x8 sprites occupy the upper half of their cells.
+ */
+const u32* PpuViewer::getSprites() const
+{
+    return sprites.data();
+}
+
+/**
+ * Background palettes in the upper row and sprite palettes in the lower row.
+ */
+const u32* PpuViewer::getPalette() const
+{
+    return paletteView.data();
+}
+
+/**
+ * Number of 8x8 tiles drawn during the last refresh, across all of the views.
+ */
+unsigned PpuViewer::getRedrawnTileCount() const
+{
+    return redrawnTileCount;
+}
+
+/**
+ * Decodes pattern tiles modified since the last refresh.
+ * After CHR banks were switched whole pattern tables have to be decoded again.
+ */
+void PpuViewer::decodeTiles(bool all)
+{
+    changedTiles = ppu.dirtyChrTiles;
+    ppu.dirtyChrTiles.reset();
+    if (all) {
+        changedTiles.set();
+    }
+
+    for (unsigned tile = 0; tile < TILE_COUNT; tile++) {
+        if (!changedTiles[tile]) {
+            continue;
+        }
+        auto* target = &tiles[tile * TILE_SIZE * TILE_SIZE];
+        for (unsigned row = 0; row < TILE_SIZE; row++) {
+            const u8 lsb = ppu.cartridge->readChr(tile * 16 + row);
+            const u8 msb = ppu.cartridge->readChr(tile * 16 + row + 8);
+            for (unsigned column = 0; column < TILE_SIZE; column++) {
+                const unsigned shift = 7 - column;
+                target[row * TILE_SIZE + column] = ((lsb >> shift) & 1) | (((msb >> shift) & 1) << 1);
+            }
+        }
+    }
+}
+
+/**
+ * Draws decoded tile using one of the 8 palettes. Transparent pixels have the universal background color.
+ */
+void PpuViewer::drawTile(u32* target, unsigned stride, unsigned tile, unsigned paletteNumber,
+    bool horizontalFlip, bool verticalFlip)
+{
+    const auto* source = &tiles[tile * TILE_SIZE * TILE_SIZE];
+    for (unsigned y = 0; y < TILE_SIZE; y++) {
+        const auto* row = source + (verticalFlip ? 7 - y : y) * TILE_SIZE;
+        for (unsigned x = 0; x < TILE_SIZE; x++) {
+            const auto value = row[horizontalFlip ? 7 - x : x];
+            target[y * stride + x] = value ? colors[paletteNumber * 4 + value] : colors[0];
+        }
+    }
+    redrawnTileCount++;
+}
+
+void PpuViewer::refreshPatternTables(bool all)
+{
+    for (unsigned tile = 0; tile < TILE_COUNT; tile++) {
+        if (!all && !changedTiles[tile]) {
+            continue;
+        }
+        const unsigned index = tile % 256;
+        const unsigned x = (tile / 256) * 128 + (index % 16) * TILE_SIZE;
+        const unsigned y = (index / 16) * TILE_SIZE;
+        drawTile(&patternTables[y * PATTERN_TABLES_WIDTH + x], PATTERN_TABLES_WIDTH, tile, patternTablePalette);
+    }
+}
+
+/**
+ * Tile of the nametable is redrawn when its entry, its attribute byte or its pattern has changed.
+ */
+void PpuViewer::refreshNametables(bool all)
+{
+    const unsigned backgroundTable = ppu.registers.ppuCtrl.backgroundPatternTableAddress * 0x100;
+    for (unsigned nametable = 0; nametable < 4; nametable++) {
+        // Mirroring maps whole nametables, so resolving the address of the first byte is enough
+        const unsigned base = ppu.resolveNametableAddress(0x2000 + nametable * 0x400, mirroringType);
+        const unsigned originX = (nametable & 1) * Ppu::SCREEN_WIDTH;
+        const unsigned originY = (nametable >> 1) * Ppu::SCREEN_HEIGHT;
+        for (unsigned row = 0; row < 30; row++) {
+            for (unsigned column = 0; column < 32; column++) {
+                const unsigned tileAddress = base + row * 32 + column;
+                const unsigned attributeAddress = base + 0x3C0 + (row / 4) * 8 + column / 4;
+                const unsigned tile = backgroundTable + ppu.vram[tileAddress];
+                if (!all && !ppu.dirtyVram[tileAddress] && !ppu.dirtyVram[attributeAddress] && !changedTiles[tile]) {
+                    continue;
+                }
+                // Each attribute byte holds palettes of four 2x2 tile areas
+                const unsigned shift = ((row & 2) << 1) | (column & 2);
+                const unsigned paletteNumber = (ppu.vram[attributeAddress] >> shift) & 3;
+                const unsigned x = originX + column * TILE_SIZE;
+                const unsigned y = originY + row * TILE_SIZE;
+                drawTile(&nametables[y * NAMETABLES_WIDTH + x], NAMETABLES_WIDTH, tile, paletteNumber);
+            }
+        }
+    }
+}
+
+/**
+ * Sprite is redrawn when its tile or attributes in OAM, or its pattern has changed.
+ */
+void PpuViewer::refreshSprites(bool all)
+{
+    const bool tallSprites = ppu.registers.ppuCtrl.spriteSize;
+    const unsigned spriteTable = ppu.registers.ppuCtrl.spritePatternTableAddress * 0x100;
+    for (unsigned sprite = 0; sprite < SPRITE_COUNT; sprite++) {
+        const auto* entry = &ppu.oam[sprite * 4];
+        auto* cachedEntry = &oam[sprite * 4];
+        const u8 tileIndex = entry[1];
+        const u8 attributes = entry[2];
+        // 8x16 sprites select the pattern table with the lowest bit of tile index
+        const unsigned tile = tallSprites ? (tileIndex & 1) * 0x100 + (tileIndex & 0xFE) : spriteTable + tileIndex;
+        const bool changed = tileIndex != cachedEntry[1] || attributes != cachedEntry[2]
+            || changedTiles[tile] || (tallSprites && changedTiles[tile + 1]);
+        if (!all && !changed) {
+            continue;
+        }
+        std::copy(entry, entry + 4, cachedEntry);
+
+        const unsigned paletteNumber = 4 + (attributes & 3);
+        const bool horizontalFlip = attributes & 0x40;
+        const bool verticalFlip = attributes & 0x80;
+        auto* target = &sprites[(sprite / 8) * 2 * TILE_SIZE * SPRITES_WIDTH + (sprite % 8) * TILE_SIZE];
+        auto* lowerHalf = target + TILE_SIZE * SPRITES_WIDTH;
+        if (tallSprites) {
+            // Vertical flip of 8x16 sprite swaps its halves as well
+            drawTile(target, SPRITES_WIDTH, verticalFlip ? tile + 1 : tile, paletteNumber, horizontalFlip, verticalFlip);
+            drawTile(lowerHalf, SPRITES_WIDTH, verticalFlip ? tile : tile + 1, paletteNumber, horizontalFlip, verticalFlip);
+        } else {
+            drawTile(target, SPRITES_WIDTH, tile, paletteNumber, horizontalFlip, verticalFlip);
+            for (unsigned y = 0; y < TILE_SIZE; y++) {
+                std::fill_n(lowerHalf + y * SPRITES_WIDTH, TILE_SIZE, colors[0]);
+            }
+        }
+    }
+}
+
+void PpuViewer::refreshPalette()
+{
+    for (unsigned entry = 0; entry < colors.size(); entry++) {
+        auto* target = &paletteView[(entry / 16) * TILE_SIZE * PALETTE_WIDTH + (entry % 16) * TILE_SIZE];
+        for (unsigned y = 0; y < TILE_SIZE; y++) {
+            std::fill_n(target + y * PALETTE_WIDTH, TILE_SIZE, colors[entry]);
+        }
+    }
+}
+
+/**
+ * Draws the outline of the visible screen over the nametables, wrapping around the edges like scrolling does.
+ * Covered pixels are saved, so that outline can be erased without redrawing the tiles.
+ */
+void PpuViewer::drawScrollWindow()
+{
+    const auto& taddr = ppu.registers.taddr;
+    const unsigned left = taddr.baseHorizontalNametable * Ppu::SCREEN_WIDTH + taddr.coarseX * TILE_SIZE + ppu.registers.vaddr.fineX;
+    const unsigned top = taddr.baseVerticalNametable * Ppu::SCREEN_HEIGHT + taddr.coarseY * TILE_SIZE + taddr.fineY;
+
+    auto plot = [this](unsigned x, unsigned y) {
+        const u32 position = (y % NAMETABLES_HEIGHT) * NAMETABLES_WIDTH + x % NAMETABLES_WIDTH;
+        scrollWindowBackup.emplace_back(position, nametables[position]);
+        nametables[position] = SCROLL_WINDOW_COLOR;
+    };
+    for (unsigned x = 0; x < Ppu::SCREEN_WIDTH; x++) {
+        plot(left + x, top);
+        plot(left + x, top + Ppu::SCREEN_HEIGHT - 1);
+    }
+    for (unsigned y = 1; y < Ppu::SCREEN_HEIGHT - 1; y++) {
+        plot(left, top + y);
+        plot(left + Ppu::SCREEN_WIDTH - 1, top + y);
+    }
+}
+
+void PpuViewer::eraseScrollWindow()
+{
+    for (auto it = scrollWindowBackup.rbegin(); it != scrollWindowBackup.rend(); ++it) {
+        nametables[it->first] = it->second;
+    }
+    scrollWindowBackup.clear();
+}
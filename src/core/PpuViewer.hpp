@@ -0,0 +1,95 @@
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <utility>
+#include <vector>
+
+#include "Types.hpp"
+#include "MirroringType.hpp"
+
+class Ppu;
+
+/**
+ * Debug views of the PPU memory rendered into RGBA32 buffers:
+ * - both pattern tables side by side, drawn with selected palette,
+ * - all four nametables with the outline of the scrolled screen,
+ * - 64 sprites from OAM, each in 8x16 cell,
+ * - 32 entries of the palette memory.
+ *
+ * Views are meant to be refreshed once per frame, thus only the tiles that changed since the previous refresh are drawn.
+ * PPU marks pattern tiles and VRAM bytes that were written, and mapper counts switches of CHR banks.
+ * Changes of the palette, mirroring and PPUCTRL are found by comparing them with the values used previously.
+ */
+class PpuViewer
+{
+    public:
+        static constexpr const unsigned PATTERN_TABLES_WIDTH = 256;
+        static constexpr const unsigned PATTERN_TABLES_HEIGHT = 128;
+        static constexpr const unsigned NAMETABLES_WIDTH = 512;
+        static constexpr const unsigned NAMETABLES_HEIGHT = 480;
+        static constexpr const unsigned SPRITES_WIDTH = 64;
+        static constexpr const unsigned SPRITES_HEIGHT = 128;
+        static constexpr const unsigned PALETTE_WIDTH = 128;
+        static constexpr const unsigned PALETTE_HEIGHT = 16;
+
+        PpuViewer(Ppu& ppu);
+
+        ~PpuViewer() = default;
+
+        void refresh();
+
+        void setPatternTablePalette(unsigned paletteNumber);
+
+        const u32* getPatternTables() const;
+
+        const u32* getNametables() const;
+
+        const u32* getSprites() const;
+
+        const u32* getPalette() const;
+
+        unsigned getRedrawnTileCount() const;
+
+    private:
+        static constexpr const unsigned TILE_COUNT = 0x200;
+        static constexpr const unsigned TILE_SIZE = 8;
+        static constexpr const unsigned SPRITE_COUNT = 64;
+        static constexpr const u32 SCROLL_WINDOW_COLOR = 0xFF00FFFF;
+
+        Ppu& ppu;
+        bool initialized;
+        u64 chrGeneration;
+        MirroringType mirroringType;
+        u8 ppuCtrl;
+        u8 ppuMask;
+        unsigned patternTablePalette;
+        bool patternTablePaletteChanged;
+        std::array<u8, 32> palette;
+        std::array<u32, 32> colors;
+        std::array<u8, 256> oam;
+        unsigned redrawnTileCount;
+
+        // Decoded tiles, each pixel is a 2 bit index of the color within palette
+        std::vector<u8> tiles;
+        std::bitset<TILE_COUNT> changedTiles;
+
+        std::vector<u32> patternTables;
+        std::vector<u32> nametables;
+        std::vector<u32> sprites;
+        std::vector<u32> paletteView;
+        // Positions and original colors of nametables view pixels covered by the scroll window outline
+        std::vector<std::pair<u32, u32>> scrollWindowBackup;
+
+        void decodeTiles(bool all);
+        void drawTile(u32* target, unsigned stride, unsigned tile, unsigned paletteNumber,
+            bool horizontalFlip = false, bool verticalFlip = false);
+
+        void refreshPatternTables(bool all);
+        void refreshNametables(bool all);
+        void refreshSprites(bool all);
+        void refreshPalette();
+
+        void drawScrollWindow();
+        void eraseScrollWindow();
+};
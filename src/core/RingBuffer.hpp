@@ -0,0 +1,106 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <vector>
+
+#include "Types.hpp"
+
+/**
+ * Fixed capacity ring buffer used to hand over a stream of values from a single producer to a single consumer.
+ *
+ * Producer only moves the tail and consumer only moves the head, both are free running counters
+ * and the amount of stored values is their difference. Capacity is rounded up to a power of two,
+ * so that positions are wrapped with a mask. Memory is allocated once, at construction.
+ *
+ * Values that don't fit are dropped and counted as an overrun.
+ * Reading more values than stored is counted as an underrun.
+ */
+template <typename T>
+class RingBuffer
+{
+    public:
+        explicit RingBuffer(unsigned capacity)
+            : buffer(std::bit_ceil(std::max(capacity, 1u)))
+            , mask(static_cast<u32>(buffer.size() - 1))
+            , head(0)
+            , tail(0)
+            , overrunCount(0)
+            , underrunCount(0)
+        {
+        }
+
+        ~RingBuffer() = default;
+
+        /**
+         * Called by producer. Writes as many of the values as there is space for, returns the amount written.
+         */
+        unsigned write(const T* values, unsigned count)
+        {
+            const auto currentTail = tail.load(std::memory_order_relaxed);
+            const auto currentHead = head.load(std::memory_order_acquire);
+            const auto written = std::min(count, getCapacity() - (currentTail - currentHead));
+            if (written < count) {
+                overrunCount.fetch_add(1, std::memory_order_relaxed);
+            }
+            // Values are copied in up to two parts, as they can wrap around the end of the buffer
+            const auto position = currentTail & mask;
+            const auto firstPart = std::min(written, getCapacity() - position);
+            std::copy(values, values + firstPart, buffer.begin() + position);
+            std::copy(values + firstPart, values + written, buffer.begin());
+            tail.store(currentTail + written, std::memory_order_release);
+            return written;
+        }
+
+        /**
+         * Called by consumer. Reads up to the given amount of values, returns the amount read.
+         */
+        unsigned read(T* values, unsigned count)
+        {
+            const auto currentHead = head.load(std::memory_order_relaxed);
+            const auto currentTail = tail.load(std::memory_order_acquire);
+            const auto read = std::min(count, currentTail - currentHead);
+            if (read < count) {
+                underrunCount.fetch_add(1, std::memory_order_relaxed);
+            }
+            const auto position = currentHead & mask;
+            const auto firstPart = std::min(read, getCapacity() - position);
+            std::copy(buffer.begin() + position, buffer.begin() + position + firstPart, values);
+            std::copy(buffer.begin(), buffer.begin() + (read - firstPart), values + firstPart);
+            head.store(currentHead + read, std::memory_order_release);
+            return read;
+        }
+
+        /**
+         * Amount of stored values. Exact only when called by producer or consumer,
+         * others get a snapshot that might be outdated.
+         */
+        unsigned getSize() const
+        {
+            return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+        }
+
+        unsigned getCapacity() const
+        {
+            return mask + 1;
+        }
+
+        u64 getOverrunCount() const
+        {
+            return overrunCount.load(std::memory_order_relaxed);
+        }
+
+        u64 getUnderrunCount() const
+        {
+            return underrunCount.load(std::memory_order_relaxed);
+        }
+
+    private:
+        std::vector<T> buffer;
+        u32 mask;
+        std::atomic<u32> head;
+        std::atomic<u32> tail;
+        std::atomic<u64> overrunCount;
+        std::atomic<u64> underrunCount;
+};
@@ -0,0 +1,8 @@
+#pragma once
+
+// Emscripten builds only support threads when compiled with pthreads enabled
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+#define WASM_NES_THREADS 0
+#else
+#define WASM_NES_THREADS 1
+#endif
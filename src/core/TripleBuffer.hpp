@@ -0,0 +1,91 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+
+/**
+ * Triple buffer used to hand over complete frames from a single producer to a single consumer.
+ * 
+ * Producer always writes into a buffer that is not visible to the consumer,
+ * and consumer always reads the latest complete buffer, without copying and without locks.
+ * 
+ * Out of 3 buffers, one is owned by producer (back), one by consumer (front)
+ * and one is kept in the middle. Publishing swaps back buffer with the middle one,
+ * and marks the middle buffer as fresh. Acquiring swaps front buffer with the middle one,
+ * but only if it is fresh. Both swaps are a single atomic exchange of the middle buffer index.
+ */
+template <typename T>
+class TripleBuffer
+{
+    public:
+        TripleBuffer()
+            : buffers()
+            , backIndex(0)
+            , frontIndex(1)
+            , middle(2)
+        {
+        }
+
+        ~TripleBuffer() = default;
+
+        /**
+         * Buffer that is currently written by the producer. 
+         */
+        T& back()
+        {
+            return buffers[backIndex];
+        }
+
+        /**
+         * Called by producer to make the back buffer available to the consumer.
+         * Producer receives the buffer that was previously kept in the middle.
+         */
+        void publish()
+        {
+            auto previous = middle.exchange(backIndex | FRESH_BIT, std::memory_order_acq_rel);
+            backIndex = previous & INDEX_MASK;
+        }
+
+        /**
+         * Checks whether producer has published buffer that has not been acquired by the consumer yet.
+         */
+        bool hasFresh() const
+        {
+            return middle.load(std::memory_order_acquire) & FRESH_BIT;
+        }
+
+        /**
+         * Called by consumer to get the latest published buffer.
+         * If nothing new was published since the last call, same buffer is returned.
+         */
+        const T& acquire()
+        {
+            if (hasFresh()) {
+                auto previous = middle.exchange(frontIndex, std::memory_order_acq_rel);
+                frontIndex = previous & INDEX_MASK;
+            }
+            return buffers[frontIndex];
+        }
+
+        /**
+         * Calls the function with each of the buffers, regardless of who owns it.
+         * Contents of the buffers may only be accessed while neither producer nor consumer uses them,
+         * otherwise the function may only tell the buffers apart by their addresses.
+         */
+        template <typename Function>
+        void forEach(Function function)
+        {
+            for (auto& buffer : buffers) {
+                function(buffer);
+            }
+        }
+
+    private:
+        static constexpr const unsigned FRESH_BIT = 0x4;
+        static constexpr const unsigned INDEX_MASK = 0x3;
+
+        std::array<T, 3> buffers;
+        unsigned backIndex;
+        unsigned frontIndex;
+        std::atomic<unsigned> middle;
+};
@@ -0,0 +1,44 @@
+#include "ApuMixer.hpp"
+
+ApuMixer::ApuMixer()
+    : mode(ApuMixerMode::Nonlinear)
+{
+}
+
+void ApuMixer::setMode(ApuMixerMode mode)
+{
+    this->mode = mode;
+}
+
+ApuMixerMode ApuMixer::getMode() const
+{
+    return mode;
+}
+
+/**
+ * Mixes channel levels. Pulse levels are in range 0..15, as well as triangle and noise levels. DMC level is in range 0..127.
+ */
+float ApuMixer::mix(u8 pulse1, u8 pulse2, u8 triangle, u8 noise, u8 dmc) const
+{
+    if (mode == ApuMixerMode::Linear) {
+        return PULSE_WEIGHT * (pulse1 + pulse2) + TRIANGLE_WEIGHT * triangle + NOISE_WEIGHT * noise + DMC_WEIGHT * dmc;
+    }
+    return TABLES.pulse[pulse1 + pulse2] + TABLES.tnd[3 * triangle + 2 * noise + dmc];
+}
+
+/**
+ * Formulas that the lookup tables approximate. Too expensive to be evaluated for every sample, kept for reference.
+ */
+float ApuMixer::mixReference(u8 pulse1, u8 pulse2, u8 triangle, u8 noise, u8 dmc)
+{
+    float pulseSample = 0.0f;
+    if (pulse1 + pulse2 > 0) {
+        pulseSample = 95.88f / (8128.0f / (pulse1 + pulse2) + 100.0f);
+    }
+    float tndSample = 0.0f;
+    const float tnd = triangle / 8227.0f + noise / 12241.0f + dmc / 22638.0f;
+    if (tnd > 0.0f) {
+        tndSample = 159.79f / (1.0f / tnd + 100.0f);
+    }
+    return pulseSample + tndSample;
+}
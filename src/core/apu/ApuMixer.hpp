@@ -0,0 +1,59 @@
+#pragma once
+
+#include <array>
+
+#include "../Types.hpp"
+#include "ApuMixerMode.hpp"
+
+/**
+ * Lookup tables of the nonlinear DAC of the NES (see https://www.nesdev.org/wiki/APU_Mixer).
+ * Pulse channels share the DAC, so their output only depends on the sum of their levels.
+ * Output of triangle, noise and DMC is approximated using the weighted sum 3 * triangle + 2 * noise + dmc.
+ */
+struct ApuMixerTables
+{
+    std::array<float, 31> pulse;
+    std::array<float, 203> tnd;
+
+    static constexpr ApuMixerTables build()
+    {
+        ApuMixerTables tables {};
+        for (unsigned i = 1; i < tables.pulse.size(); i++) {
+            tables.pulse[i] = 95.52f / (8128.0f / i + 100.0f);
+        }
+        for (unsigned i = 1; i < tables.tnd.size(); i++) {
+            tables.tnd[i] = 163.67f / (24329.0f / i + 100.0f);
+        }
+        return tables;
+    }
+};
+
+/**
+ * Mixes levels of the APU channels into a single sample in range 0..1.
+ */
+class ApuMixer
+{
+    public:
+        static constexpr const ApuMixerTables TABLES = ApuMixerTables::build();
+
+        ApuMixer();
+
+        ~ApuMixer() = default;
+
+        void setMode(ApuMixerMode mode);
+
+        ApuMixerMode getMode() const;
+
+        float mix(u8 pulse1, u8 pulse2, u8 triangle, u8 noise, u8 dmc) const;
+
+        static float mixReference(u8 pulse1, u8 pulse2, u8 triangle, u8 noise, u8 dmc);
+
+    private:
+        // Weights of the linear mode are chosen, so that each of the channels alone reaches the same maximum as in the tables
+        static constexpr const float PULSE_WEIGHT = TABLES.pulse[30] / 30;
+        static constexpr const float TRIANGLE_WEIGHT = TABLES.tnd[3 * 15] / 15;
+        static constexpr const float NOISE_WEIGHT = TABLES.tnd[2 * 15] / 15;
+        static constexpr const float DMC_WEIGHT = TABLES.tnd[127] / 127;
+
+        ApuMixerMode mode;
+};
@@ -0,0 +1,12 @@
+#pragma once
+
+/**
+ * How the APU mixes outputs of the channels into a single sample.
+ */
+enum class ApuMixerMode
+{
+    // Lookup tables approximating nonlinear DAC of the NES, louder channels are slightly compressed.
+    Nonlinear,
+    // Weighted sum of the channel levels, cheaper but it gets too loud when many channels play at full volume.
+    Linear
+};
@@ -0,0 +1,13 @@
+#pragma once
+
+/**
+ * How the APU turns the output of the channels into samples at the output rate.
+ */
+enum class ApuSynthesisMode
+{
+    // Changes of the output are added into the blip buffer as band-limited steps, only when they happen.
+    BandLimited,
+    // Output is sampled at half of the CPU clock and decimated to the output rate, costs more but it is exact
+    // for any waveform, including the ones changing faster than the output rate.
+    NativeRate
+};
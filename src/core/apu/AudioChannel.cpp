@@ -1,11 +1,55 @@
 #include "AudioChannel.hpp"
 
+// Values loaded into the length counter, indexed by the 5 bits written into the last channel register
+const std::array<u8, 32> AudioChannel::LENGTH_TABLE = {
+    10, 254, 20,  2, 40,  4, 80,  6, 160,  8, 60, 10, 14, 12, 26, 14,
+    12,  16, 24, 18, 48, 20, 96, 22, 192, 24, 72, 26, 16, 28, 32, 30
+};
+
+AudioChannel::AudioChannel()
+    : lengthCounter(0)
+    , enabled(false)
+{
+}
+
+/**
+ * Whether the channel is still playing, as reported by APU status register.
+ */
+bool AudioChannel::isActive() const
+{
+    return lengthCounter > 0;
+}
+
 bool AudioChannel::isEnabled()
 {
     return enabled;
 }
 
+/**
+ * Enables or disables the channel via APU status register.
+ * Disabling the channel silences it immediately, by clearing its length counter.
+ */
 void AudioChannel::enable(bool enable)
 {
     enabled = enable;
+    if (!enabled) {
+        lengthCounter = 0;
+    }
+}
+
+/**
+ * Length counter is only loaded while the channel is enabled.
+ */
+void AudioChannel::loadLengthCounter(u8 index)
+{
+    if (enabled) {
+        lengthCounter = LENGTH_TABLE[index & 0x1F];
+    }
+}
+
+void AudioChannel::lengthCounterTick(bool halted)
+{
+    if (!halted && lengthCounter > 0) {
+        lengthCounter--;
+    }
 }
@@ -1,11 +1,21 @@
 #pragma once
 
+#include <array>
+#include <limits>
+
 #include "../Types.hpp"
 
+/**
+ * Base of the APU channels.
+ *
+ * Most of the cycles a channel only counts down its timer. Amount of such cycles ahead is reported as idle cycles,
+ * APU then skips all of them at once and only ticks the channel cycle by cycle when something happens.
+ * When the output is not required, only the changes visible to the CPU end the idle cycles.
+ */
 class AudioChannel
 {
     public:
-        AudioChannel() = default;
+        AudioChannel();
 
         virtual ~AudioChannel() = default;
 
@@ -17,10 +27,27 @@ class AudioChannel
 
         virtual u8 tick() = 0;
 
+        virtual unsigned getIdleCycles(bool outputRequired) const = 0;
+
+        virtual void skip(unsigned cycles) = 0;
+
+        virtual bool isActive() const;
+
         bool isEnabled();
 
-        void enable(bool enable);
-    
+        virtual void enable(bool enable);
+
+    protected:
+        // Idle cycles of a channel that has nothing to change until its registers are written or the frame sequencer clocks it
+        static constexpr const unsigned UNLIMITED_IDLE_CYCLES = std::numeric_limits<unsigned>::max();
+
+        u8 lengthCounter;
+
+        void loadLengthCounter(u8 index);
+        void lengthCounterTick(bool halted);
+
     private:
         bool enabled;
-};
\ No newline at end of file
+
+        static const std::array<u8, 32> LENGTH_TABLE;
+};
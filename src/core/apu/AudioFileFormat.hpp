@@ -0,0 +1,12 @@
+#pragma once
+
+/**
+ * Format of the file written by the file audio sink, both contain 16 bit signed mono samples.
+ */
+enum class AudioFileFormat
+{
+    // RIFF WAVE file, that can be opened by audio players and editors
+    Wav,
+    // Samples only, without any header
+    Raw
+};
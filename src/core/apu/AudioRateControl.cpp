@@ -0,0 +1,54 @@
+#include "AudioRateControl.hpp"
+
+#include <algorithm>
+
+AudioRateControl::AudioRateControl(double maxDeviation)
+    : maxDeviation(maxDeviation)
+    , targetLevel(0)
+    , averageLevel(0.0)
+    , ratio(1.0)
+{
+}
+
+/**
+ * Sets the amount of buffered samples that should be kept, zero disables the rate control.
+ */
+void AudioRateControl::setTargetLevel(unsigned targetLevel)
+{
+    this->targetLevel = targetLevel;
+    reset();
+}
+
+unsigned AudioRateControl::getTargetLevel() const
+{
+    return targetLevel;
+}
+
+/**
+ * Takes the current amount of buffered samples and returns the ratio, that the nominal sample rate
+ * should be multiplied with until the next update.
+ */
+double AudioRateControl::update(unsigned bufferedSamples)
+{
+    if (targetLevel == 0) {
+        return ratio;
+    }
+    averageLevel += (bufferedSamples - averageLevel) * SMOOTHING;
+    const auto error = std::clamp((targetLevel - averageLevel) / targetLevel, -1.0, 1.0);
+    ratio = 1.0 + maxDeviation * error;
+    return ratio;
+}
+
+double AudioRateControl::getRatio() const
+{
+    return ratio;
+}
+
+/**
+ * Forgets the averaged level, the buffer is expected to be at the target level.
+ */
+void AudioRateControl::reset()
+{
+    averageLevel = targetLevel;
+    ratio = 1.0;
+}
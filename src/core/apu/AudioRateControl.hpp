@@ -0,0 +1,43 @@
+#pragma once
+
+#include "../Types.hpp"
+
+/**
+ * Dynamic rate control, keeps the amount of buffered samples around the target level.
+ *
+ * Emulation is paced by the display and the audio device consumes samples with its own clock,
+ * so the two clocks slowly drift apart. Instead of letting the buffer grow or run dry,
+ * the sample rate is adjusted by a fraction of a percent: fewer samples are produced when the buffer
+ * is above the target level and more when it is below. Such a small change of pitch is not audible.
+ *
+ * Level of the buffer jumps whenever the audio device takes a block of samples, so it is averaged
+ * over a few updates before it is used.
+ */
+class AudioRateControl
+{
+    public:
+        static constexpr const double DEFAULT_MAX_DEVIATION = 0.005;
+
+        AudioRateControl(double maxDeviation = DEFAULT_MAX_DEVIATION);
+
+        ~AudioRateControl() = default;
+
+        void setTargetLevel(unsigned targetLevel);
+
+        unsigned getTargetLevel() const;
+
+        double update(unsigned bufferedSamples);
+
+        double getRatio() const;
+
+        void reset();
+
+    private:
+        // Weight of the newest buffer level in the average
+        static constexpr const double SMOOTHING = 1.0 / 16;
+
+        double maxDeviation;
+        unsigned targetLevel;
+        double averageLevel;
+        double ratio;
+};
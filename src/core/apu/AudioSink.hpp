@@ -0,0 +1,12 @@
+#pragma once
+
+/**
+ * Consumer of the samples produced by the APU, such as a file on the disk.
+ */
+class AudioSink
+{
+    public:
+        virtual ~AudioSink() = default;
+
+        virtual void write(const float* samples, unsigned count) = 0;
+};
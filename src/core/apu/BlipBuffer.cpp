@@ -0,0 +1,131 @@
+#include "BlipBuffer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+BlipBuffer::BlipBuffer(double clockRate, double sampleRate, unsigned capacity)
+    : samplesPerClock(0)
+    , frameStart(0)
+    , capacity(capacity)
+    , kernels(PHASE_COUNT * KERNEL_WIDTH)
+    , buffer(capacity + KERNEL_WIDTH)
+    , integrator(0.0f)
+    , highPass(0.0f)
+    , highPassRate(0.0f)
+{
+    buildKernels();
+    setRates(clockRate, sampleRate);
+}
+
+/**
+ * Sets the rate of the clock that deltas are timestamped with and the rate of produced samples.
+ * Output also passes through a high-pass filter, that removes the DC offset like the capacitors on the NES do.
+ */
+void BlipBuffer::setRates(double clockRate, double sampleRate)
+{
+    samplesPerClock = static_cast<u64>(sampleRate / clockRate * double(u64(1) << FRACTION_BITS));
+    highPassRate = static_cast<float>(1.0 - std::exp(-2.0 * std::numbers::pi * HIGH_PASS_FREQUENCY / sampleRate));
+}
+
+/**
+ * Adds change of the output at the given clock of the current frame.
+ * Deltas that don't fit into the buffer are dropped.
+ */
+void BlipBuffer::addDelta(unsigned clock, float delta)
+{
+    const auto position = frameStart + clock * samplesPerClock;
+    const auto index = static_cast<unsigned>(position >> FRACTION_BITS);
+    if (index >= capacity) {
+        return;
+    }
+    const auto phase = static_cast<unsigned>(position >> (FRACTION_BITS - PHASE_BITS)) & (PHASE_COUNT - 1);
+    const auto* kernel = kernels.data() + phase * KERNEL_WIDTH;
+    auto* target = buffer.data() + index;
+    for (unsigned i = 0; i < KERNEL_WIDTH; i++) {
+        target[i] += delta * kernel[i];
+    }
+}
+
+/**
+ * Ends the frame of the given length in clocks, samples that it covers become available.
+ * Oldest samples are dropped when there's not enough space left.
+ */
+void BlipBuffer::endFrame(unsigned clocks)
+{
+    frameStart += clocks * samplesPerClock;
+    const auto available = getAvailableSamples();
+    if (available > capacity) {
+        removeSamples(available - capacity, nullptr);
+    }
+}
+
+unsigned BlipBuffer::getAvailableSamples() const
+{
+    return static_cast<unsigned>(frameStart >> FRACTION_BITS);
+}
+
+/**
+ * Reads up to given amount of samples and returns the amount that was read.
+ */
+unsigned BlipBuffer::readSamples(float* output, unsigned count)
+{
+    count = std::min(count, getAvailableSamples());
+    removeSamples(count, output);
+    return count;
+}
+
+void BlipBuffer::clear()
+{
+    std::fill(buffer.begin(), buffer.end(), 0.0f);
+    frameStart = 0;
+    integrator = 0.0f;
+    highPass = 0.0f;
+}
+
+/**
+ * Each phase of the kernel is a windowed sinc, sampled at the offsets of output samples from the delta.
+ * It is the derivative of the band-limited step, that becomes a step again when integrated.
+ * Output is delayed by half of the kernel width, so that the whole kernel lies after the delta.
+ */
+void BlipBuffer::buildKernels()
+{
+    const double half = KERNEL_WIDTH / 2.0;
+    for (unsigned phase = 0; phase < PHASE_COUNT; phase++) {
+        auto* kernel = kernels.data() + phase * KERNEL_WIDTH;
+        double sum = 0.0;
+        for (unsigned i = 0; i < KERNEL_WIDTH; i++) {
+            const double x = i - half + 0.5 - double(phase) / PHASE_COUNT;
+            const double sinc = x == 0.0 ? 1.0 : std::sin(std::numbers::pi * 2.0 * CUTOFF * x) / (std::numbers::pi * 2.0 * CUTOFF * x);
+            // Blackman window
+            const double w = (x + half) / KERNEL_WIDTH;
+            const double window = 0.42 - 0.5 * std::cos(2.0 * std::numbers::pi * w) + 0.08 * std::cos(4.0 * std::numbers::pi * w);
+            kernel[i] = static_cast<float>(sinc * window);
+            sum += kernel[i];
+        }
+        // Every phase has to add exactly the whole delta, otherwise the output would drift
+        for (unsigned i = 0; i < KERNEL_WIDTH; i++) {
+            kernel[i] = static_cast<float>(kernel[i] / sum);
+        }
+    }
+}
+
+/**
+ * Integrates samples at the beginning of the buffer into the output, or just drops them when output is null.
+ * Remaining deltas are moved to the beginning.
+ */
+void BlipBuffer::removeSamples(unsigned count, float* output)
+{
+    for (unsigned i = 0; i < count; i++) {
+        integrator += buffer[i];
+        const float sample = integrator - highPass;
+        highPass += sample * highPassRate;
+        if (output) {
+            output[i] = sample;
+        }
+    }
+    const auto remaining = std::min<unsigned>(getAvailableSamples() - count + KERNEL_WIDTH, buffer.size() - count);
+    std::copy(buffer.begin() + count, buffer.begin() + count + remaining, buffer.begin());
+    std::fill(buffer.begin() + remaining, buffer.begin() + remaining + count, 0.0f);
+    frameStart -= u64(count) << FRACTION_BITS;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <vector>
+
+#include "../Types.hpp"
+
+/**
+ * Band-limited synthesis buffer.
+ * 
+ * Instead of producing a sample for every clock of the source, only changes of the output (deltas) are added,
+ * timestamped with the clock they happened at. Each delta is spread over a few output samples
+ * with a band-limited step kernel, so that the result is free of aliasing at any output sample rate.
+ * Reading integrates the deltas back into samples. Cost is proportional to the amount of deltas,
+ * not to the amount of source clocks.
+ * 
+ * Deltas are added in frames, clocks are relative to the beginning of the current frame.
+ * Samples become available for reading only after the frame is ended.
+ */
+class BlipBuffer
+{
+    public:
+        static constexpr const unsigned KERNEL_WIDTH = 16;
+        static constexpr const unsigned PHASE_COUNT = 32;
+
+        BlipBuffer(double clockRate, double sampleRate, unsigned capacity);
+
+        ~BlipBuffer() = default;
+
+        void setRates(double clockRate, double sampleRate);
+
+        void addDelta(unsigned clock, float delta);
+
+        void endFrame(unsigned clocks);
+
+        unsigned getAvailableSamples() const;
+
+        unsigned readSamples(float* output, unsigned count);
+
+        void clear();
+
+    private:
+        static constexpr const unsigned FRACTION_BITS = 32;
+        static constexpr const unsigned PHASE_BITS = 5;
+        static constexpr const double CUTOFF = 0.45;
+        static constexpr const double HIGH_PASS_FREQUENCY = 20.0;
+
+        // Sample position of the delta is a fixed point number with 32 bits of fraction.
+        // Top bits of the fraction select the phase of the kernel.
+        u64 samplesPerClock;
+        u64 frameStart;
+        unsigned capacity;
+        std::vector<float> kernels;
+        std::vector<float> buffer;
+        float integrator;
+        float highPass;
+        float highPassRate;
+
+        void buildKernels();
+        void removeSamples(unsigned count, float* output);
+};
@@ -0,0 +1,59 @@
+#include "ChannelTaps.hpp"
+
+ChannelTaps::ChannelTaps(double clockRate, double tapRate, unsigned capacity)
+    : rate(tapRate)
+    , clocksPerSample(static_cast<u64>(clockRate / tapRate * double(u64(1) << FRACTION_BITS)))
+    , elapsed(0)
+    , sums()
+    , scales()
+    , buffers()
+{
+    // Sums of the levels are weighted by the clocks in fixed point, so they are exact.
+    // Scales turn them into averages of the normalized levels.
+    for (unsigned i = 0; i < CHANNEL_COUNT; i++) {
+        scales[i] = 1.0 / (MAX_LEVELS[i] * double(clocksPerSample));
+        buffers[i] = std::make_unique<RingBuffer<float>>(capacity);
+    }
+}
+
+/**
+ * Adds the levels that the channels kept for the given amount of clocks.
+ * Every time the period of a tap sample is covered, the averages are written into the buffers.
+ */
+void ChannelTaps::add(const std::array<u8, CHANNEL_COUNT>& levels, unsigned clocks)
+{
+    auto remaining = u64(clocks) << FRACTION_BITS;
+    while (elapsed + remaining >= clocksPerSample) {
+        const auto part = clocksPerSample - elapsed;
+        accumulate(levels, part);
+        for (unsigned i = 0; i < CHANNEL_COUNT; i++) {
+            const auto sample = static_cast<float>(double(sums[i]) * scales[i]);
+            buffers[i]->write(&sample, 1);
+        }
+        sums.fill(0);
+        elapsed = 0;
+        remaining -= part;
+    }
+    accumulate(levels, remaining);
+    elapsed += remaining;
+}
+
+/**
+ * Buffer of the samples of the given channel. APU is its producer, there can be a single consumer.
+ */
+RingBuffer<float>& ChannelTaps::getBuffer(unsigned channel)
+{
+    return *buffers[channel];
+}
+
+double ChannelTaps::getRate() const
+{
+    return rate;
+}
+
+void ChannelTaps::accumulate(const std::array<u8, CHANNEL_COUNT>& levels, u64 clocks)
+{
+    for (unsigned i = 0; i < CHANNEL_COUNT; i++) {
+        sums[i] += levels[i] * clocks;
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <array>
+#include <memory>
+
+#include "../Types.hpp"
+#include "../RingBuffer.hpp"
+
+/**
+ * Waveforms of the individual channels, in the order of the status register: pulse 1, pulse 2, triangle, noise and DMC.
+ * Meant for oscilloscope views and for recording the channels separately.
+ *
+ * Levels of the channels are averaged over the period of a tap sample, so that they are decimated from the CPU clock
+ * to the tap rate. Each level is divided by the maximum level of its channel, thus samples go from 0 to 1.
+ * Every channel has its own ring buffer, that can be read by another thread.
+ */
+class ChannelTaps
+{
+    public:
+        static constexpr const unsigned CHANNEL_COUNT = 5;
+
+        ChannelTaps(double clockRate, double tapRate, unsigned capacity);
+
+        ~ChannelTaps() = default;
+
+        void add(const std::array<u8, CHANNEL_COUNT>& levels, unsigned clocks);
+
+        RingBuffer<float>& getBuffer(unsigned channel);
+
+        double getRate() const;
+
+    private:
+        static constexpr const unsigned FRACTION_BITS = 32;
+        static constexpr const std::array<double, CHANNEL_COUNT> MAX_LEVELS = { 15.0, 15.0, 15.0, 15.0, 127.0 };
+
+        double rate;
+        // Length of a tap sample in clocks and the part of it that was already added, 32.32 fixed point
+        u64 clocksPerSample;
+        u64 elapsed;
+        std::array<u64, CHANNEL_COUNT> sums;
+        std::array<double, CHANNEL_COUNT> scales;
+        std::array<std::unique_ptr<RingBuffer<float>>, CHANNEL_COUNT> buffers;
+
+        void accumulate(const std::array<u8, CHANNEL_COUNT>& levels, u64 clocks);
+};
@@ -0,0 +1,244 @@
+#include "Decimator.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <numbers>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+#endif
+
+namespace
+{
+    /**
+     * Sum of products of the samples and the kernel, count is a multiple of 4.
+     */
+    float dot(const float* samples, const float* kernel, unsigned count)
+    {
+#if defined(__SSE2__)
+        auto sum = _mm_setzero_ps();
+        for (unsigned i = 0; i < count; i += 4) {
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(samples + i), _mm_loadu_ps(kernel + i)));
+        }
+        sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+        sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+        return _mm_cvtss_f32(sum);
+#elif defined(__wasm_simd128__)
+        auto sum = wasm_f32x4_splat(0.0f);
+        for (unsigned i = 0; i < count; i += 4) {
+            sum = wasm_f32x4_add(sum, wasm_f32x4_mul(wasm_v128_load(samples + i), wasm_v128_load(kernel + i)));
+        }
+        return wasm_f32x4_extract_lane(sum, 0) + wasm_f32x4_extract_lane(sum, 1)
+            + wasm_f32x4_extract_lane(sum, 2) + wasm_f32x4_extract_lane(sum, 3);
+#else
+        float sums[4] = {};
+        for (unsigned i = 0; i < count; i += 4) {
+            for (unsigned lane = 0; lane < 4; lane++) {
+                sums[lane] += samples[i + lane] * kernel[i + lane];
+            }
+        }
+        return (sums[0] + sums[1]) + (sums[2] + sums[3]);
+#endif
+    }
+
+    /**
+     * Windowed sinc with the given cutoff relative to the sample rate, x is the offset in samples from its center.
+     * Position within the Blackman window goes from 0 to 1.
+     */
+    double windowedSinc(double x, double cutoff, double position)
+    {
+        const double sinc = x == 0.0 ? 1.0 : std::sin(std::numbers::pi * 2.0 * cutoff * x) / (std::numbers::pi * 2.0 * cutoff * x);
+        const double window = 0.42 - 0.5 * std::cos(2.0 * std::numbers::pi * position) + 0.08 * std::cos(4.0 * std::numbers::pi * position);
+        return sinc * window;
+    }
+
+    /**
+     * Scales the kernel, so that it passes the DC level unchanged.
+     */
+    void normalize(float* kernel, unsigned size)
+    {
+        double sum = 0.0;
+        for (unsigned i = 0; i < size; i++) {
+            sum += kernel[i];
+        }
+        for (unsigned i = 0; i < size; i++) {
+            kernel[i] = static_cast<float>(kernel[i] / sum);
+        }
+    }
+}
+
+Decimator::Decimator(double inputRate, double outputRate)
+    : resamplerInputRate(inputRate / (1 << HALVING_STAGE_COUNT))
+    , nominalOutputRate(outputRate)
+    , stages()
+    , resamplerKernels(RESAMPLER_PHASE_COUNT * RESAMPLER_TAPS)
+    , resamplerBuffer(RESAMPLER_TAPS + (BLOCK_SIZE >> HALVING_STAGE_COUNT))
+    , resamplerBuffered(0)
+    , position(0)
+    , step(0)
+    , highPass(0.0f)
+    , highPassRate(0.0f)
+    , lastBlockTime(0.0)
+    , averageBlockTime(0.0)
+{
+    for (unsigned i = 0; i < HALVING_STAGE_COUNT; i++) {
+        stages[i].kernel.resize(HALVING_STAGE_TAPS[i]);
+        stages[i].buffer.resize(HALVING_STAGE_TAPS[i] - 1 + (BLOCK_SIZE >> i));
+    }
+    buildKernels();
+    setOutputRate(outputRate);
+}
+
+/**
+ * Sets the rate of produced samples. Meant for small adjustments of the nominal rate given at construction,
+ * cutoff of the filters stays the same. Rate is kept within MAX_RATE_ADJUSTMENT of the nominal rate.
+ */
+void Decimator::setOutputRate(double outputRate)
+{
+    outputRate = std::clamp(outputRate, nominalOutputRate * (1.0 - MAX_RATE_ADJUSTMENT), nominalOutputRate * (1.0 + MAX_RATE_ADJUSTMENT));
+    step = static_cast<u64>(resamplerInputRate / outputRate * double(u64(1) << FRACTION_BITS));
+    highPassRate = static_cast<float>(1.0 - std::exp(-2.0 * std::numbers::pi * HIGH_PASS_FREQUENCY / outputRate));
+}
+
+/**
+ * Maximum amount of samples produced from a single block.
+ */
+unsigned Decimator::getMaxOutputSize() const
+{
+    // Fraction of the position carried from the previous block can add one more sample
+    const double maxOutputRate = nominalOutputRate * (1.0 + MAX_RATE_ADJUSTMENT);
+    return static_cast<unsigned>(std::ceil((BLOCK_SIZE >> HALVING_STAGE_COUNT) * maxOutputRate / resamplerInputRate)) + 1;
+}
+
+/**
+ * Filters a block of BLOCK_SIZE input samples, writes the produced samples into the output
+ * and returns their amount. Output has to have space for getMaxOutputSize() samples.
+ */
+unsigned Decimator::process(const float* input, float* output)
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    // Each stage writes its samples after the history kept by the following stage
+    std::copy(input, input + BLOCK_SIZE, stages[0].buffer.begin() + (HALVING_STAGE_TAPS[0] - 1));
+    auto count = BLOCK_SIZE;
+    for (unsigned i = 0; i < HALVING_STAGE_COUNT; i++) {
+        auto* target = i + 1 < HALVING_STAGE_COUNT
+            ? stages[i + 1].buffer.data() + (HALVING_STAGE_TAPS[i + 1] - 1)
+            : resamplerBuffer.data() + resamplerBuffered;
+        count = halve(stages[i], count, target);
+    }
+    resamplerBuffered += count;
+    const auto produced = resample(output);
+
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    lastBlockTime = elapsed.count();
+    averageBlockTime = averageBlockTime == 0.0
+        ? lastBlockTime
+        : averageBlockTime + (lastBlockTime - averageBlockTime) * AVERAGE_WEIGHT;
+    return produced;
+}
+
+/**
+ * Forgets all the samples kept from the previous blocks.
+ */
+void Decimator::clear()
+{
+    for (auto& stage : stages) {
+        std::fill(stage.buffer.begin(), stage.buffer.end(), 0.0f);
+    }
+    std::fill(resamplerBuffer.begin(), resamplerBuffer.end(), 0.0f);
+    resamplerBuffered = 0;
+    position = 0;
+    highPass = 0.0f;
+}
+
+/**
+ * Time in milliseconds that processing of the last block took.
+ */
+double Decimator::getLastBlockTime() const
+{
+    return lastBlockTime;
+}
+
+/**
+ * Exponential moving average of the time in milliseconds that processing of a block takes.
+ */
+double Decimator::getAverageBlockTime() const
+{
+    return averageBlockTime;
+}
+
+/**
+ * Halving stages are low-pass filters with the cutoff at the half of their band, so that nothing is left
+ * above the Nyquist frequency of their output. Kernels of the resampler are windowed sincs with the cutoff
+ * just below the Nyquist frequency of the output, each phase sampled at the offsets of input samples
+ * from the fractional position of the output sample.
+ */
+void Decimator::buildKernels()
+{
+    for (auto& stage : stages) {
+        const auto taps = static_cast<unsigned>(stage.kernel.size());
+        for (unsigned i = 0; i < taps; i++) {
+            const double x = i - (taps - 1) / 2.0;
+            stage.kernel[i] = static_cast<float>(windowedSinc(x, 0.25, (i + 0.5) / taps));
+        }
+        normalize(stage.kernel.data(), taps);
+    }
+
+    const double cutoff = 0.5 * RESAMPLER_CUTOFF * std::min(nominalOutputRate, resamplerInputRate) / resamplerInputRate;
+    const double half = RESAMPLER_TAPS / 2.0;
+    for (unsigned phase = 0; phase < RESAMPLER_PHASE_COUNT; phase++) {
+        auto* kernel = resamplerKernels.data() + phase * RESAMPLER_TAPS;
+        for (unsigned i = 0; i < RESAMPLER_TAPS; i++) {
+            const double x = i - half + 1.0 - double(phase) / RESAMPLER_PHASE_COUNT;
+            kernel[i] = static_cast<float>(windowedSinc(x, cutoff, (x + half) / RESAMPLER_TAPS));
+        }
+        normalize(kernel, RESAMPLER_TAPS);
+    }
+}
+
+/**
+ * Filters the given amount of samples that follow the history in the stage buffer and keeps every second one.
+ * Last samples become the history for the next block. Returns the amount of produced samples.
+ */
+unsigned Decimator::halve(HalvingStage& stage, unsigned count, float* output)
+{
+    const auto taps = static_cast<unsigned>(stage.kernel.size());
+    const auto* samples = stage.buffer.data();
+    for (unsigned i = 0; i < count / 2; i++) {
+        output[i] = dot(samples + 2 * i, stage.kernel.data(), taps);
+    }
+    std::copy(stage.buffer.begin() + count, stage.buffer.begin() + count + taps - 1, stage.buffer.begin());
+    return count / 2;
+}
+
+/**
+ * Produces output samples for all the positions, whose kernel is covered by the buffered samples.
+ * Samples that won't be needed anymore are removed from the buffer.
+ */
+unsigned Decimator::resample(float* output)
+{
+    // Phase is rounded to the nearest one
+    constexpr const u64 PHASE_ROUNDING = u64(1) << (FRACTION_BITS - RESAMPLER_PHASE_BITS - 1);
+    unsigned count = 0;
+    while (true) {
+        const auto rounded = position + PHASE_ROUNDING;
+        const auto index = static_cast<unsigned>(rounded >> FRACTION_BITS);
+        if (index + RESAMPLER_TAPS > resamplerBuffered) {
+            break;
+        }
+        const auto phase = static_cast<unsigned>(rounded >> (FRACTION_BITS - RESAMPLER_PHASE_BITS)) & (RESAMPLER_PHASE_COUNT - 1);
+        const auto sample = dot(resamplerBuffer.data() + index, resamplerKernels.data() + phase * RESAMPLER_TAPS, RESAMPLER_TAPS) - highPass;
+        highPass += sample * highPassRate;
+        output[count++] = sample;
+        position += step;
+    }
+    const auto consumed = std::min(static_cast<unsigned>(position >> FRACTION_BITS), resamplerBuffered);
+    std::copy(resamplerBuffer.begin() + consumed, resamplerBuffer.begin() + resamplerBuffered, resamplerBuffer.begin());
+    resamplerBuffered -= consumed;
+    position -= u64(consumed) << FRACTION_BITS;
+    return count;
+}
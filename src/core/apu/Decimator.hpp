@@ -0,0 +1,80 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include "../Types.hpp"
+
+/**
+ * Brings samples produced at the native rate of the APU, half of the CPU clock, down to the output sample rate.
+ *
+ * Samples pass through 4 stages, each of them filters out the upper half of its band and keeps every second sample.
+ * Last stage resamples to the output rate with a polyphase windowed sinc. Every stage keeps the band up to 20 kHz
+ * and removes what would alias into it, so any waveform the channels produce, including ultrasonic pulse sweeps,
+ * ends up in the output as it would be heard. Filters take dot products of 4 samples at once,
+ * using SSE or WebAssembly SIMD when available.
+ *
+ * Samples are processed in blocks of fixed size and all the memory is allocated at construction.
+ * Time taken by every block is measured, so that the cost of the exact audio is known.
+ */
+class Decimator
+{
+    public:
+        static constexpr const unsigned BLOCK_SIZE = 4096;
+        // Output rate can deviate this much from the nominal rate, to follow the audio device
+        static constexpr const double MAX_RATE_ADJUSTMENT = 0.01;
+
+        Decimator(double inputRate, double outputRate);
+
+        ~Decimator() = default;
+
+        void setOutputRate(double outputRate);
+
+        unsigned getMaxOutputSize() const;
+
+        unsigned process(const float* input, float* output);
+
+        void clear();
+
+        double getLastBlockTime() const;
+
+        double getAverageBlockTime() const;
+
+    private:
+        static constexpr const unsigned HALVING_STAGE_COUNT = 4;
+        // Each stage has more room for its transition band than the next one, so it needs fewer taps
+        static constexpr const std::array<unsigned, HALVING_STAGE_COUNT> HALVING_STAGE_TAPS = { 12, 16, 24, 44 };
+        static constexpr const unsigned RESAMPLER_TAPS = 64;
+        static constexpr const unsigned RESAMPLER_PHASE_BITS = 8;
+        static constexpr const unsigned RESAMPLER_PHASE_COUNT = 1 << RESAMPLER_PHASE_BITS;
+        static constexpr const unsigned FRACTION_BITS = 32;
+        // Cutoff of the resampler relative to the Nyquist frequency of the output
+        static constexpr const double RESAMPLER_CUTOFF = 0.95;
+        static constexpr const double HIGH_PASS_FREQUENCY = 20.0;
+        static constexpr const double AVERAGE_WEIGHT = 0.05;
+
+        struct HalvingStage
+        {
+            std::vector<float> kernel;
+            // Last samples of the previous block followed by the samples of the current block
+            std::vector<float> buffer;
+        };
+
+        double resamplerInputRate;
+        double nominalOutputRate;
+        std::array<HalvingStage, HALVING_STAGE_COUNT> stages;
+        std::vector<float> resamplerKernels;
+        std::vector<float> resamplerBuffer;
+        unsigned resamplerBuffered;
+        // Position of the next output sample within the resampler buffer, 32.32 fixed point
+        u64 position;
+        u64 step;
+        float highPass;
+        float highPassRate;
+        double lastBlockTime;
+        double averageBlockTime;
+
+        void buildKernels();
+        unsigned halve(HalvingStage& stage, unsigned count, float* output);
+        unsigned resample(float* output);
+};
@@ -0,0 +1,237 @@
+#include "DmcChannel.hpp"
+
+#include <algorithm>
+
+// Periods of the output unit in CPU cycles (NTSC)
+const std::array<u16, 16> DmcChannel::RATE_TABLE = {
+    428, 380, 340, 320, 286, 254, 226, 214, 190, 160, 142, 128, 106, 84, 72, 54
+};
+
+DmcChannel::DmcChannel()
+    : AudioChannel()
+    , registers()
+    , memoryReader()
+    , waveCounter(0)
+    , currentAddress(0xC000)
+    , bytesRemaining(0)
+    , sampleBuffer(0)
+    , sampleBufferEmpty(true)
+    , shiftRegister(0)
+    , bitsRemaining(8)
+    , silence(true)
+    , level(0)
+    , irq(false)
+    , stallCycles(0)
+{
+}
+
+void DmcChannel::write(u8 index, u8 value)
+{
+    switch (index) {
+        case 0:
+            registers.reg0 = value;
+            if (!registers.irqEnable) {
+                irq = false;
+            }
+            break;
+        case 1:
+            registers.reg1 = value;
+            // Output level can be set directly, which allows games to play PCM samples
+            level = registers.directLoad;
+            break;
+        case 2:
+            registers.reg2 = value;
+            break;
+        case 3:
+            registers.reg3 = value;
+            break;
+    }
+}
+
+void DmcChannel::quarterFrameTick()
+{
+}
+
+void DmcChannel::halfFrameTick()
+{
+}
+
+/**
+ * Single CPU cycle. Every time the timer expires, one bit of the sample is consumed
+ * and the output level goes either 2 steps up or down.
+ */
+u8 DmcChannel::tick()
+{
+    if (sampleBufferEmpty && bytesRemaining > 0) {
+        fetchSample();
+    }
+    if (waveCounter > 0) {
+        waveCounter--;
+        return level;
+    }
+    waveCounter = RATE_TABLE[registers.frequencyIndex] - 1;
+    clockOutputUnit();
+    return level;
+}
+
+/**
+ * Cycles until the timer expires, or none when a sample byte has to be fetched.
+ * Without the output required, only the fetch of the next byte matters, it follows the last bit of the current byte.
+ * Channel that is silent with nothing left to play only counts the bits of its empty output unit.
+ */
+unsigned DmcChannel::getIdleCycles(bool outputRequired) const
+{
+    if (sampleBufferEmpty && bytesRemaining > 0) {
+        return 0;
+    }
+    if (sampleBufferEmpty && silence) {
+        return UNLIMITED_IDLE_CYCLES;
+    }
+    if (!outputRequired && !sampleBufferEmpty) {
+        return waveCounter + (bitsRemaining - 1) * RATE_TABLE[registers.frequencyIndex];
+    }
+    return waveCounter;
+}
+
+/**
+ * Advances the timer by the given amount of idle cycles, output unit is clocked every time the timer expires.
+ * Bits of each byte are consumed at once. Output unit without a sample reloads the same byte every 8 bits,
+ * so only the bits after the last of such whole bytes are consumed.
+ */
+void DmcChannel::skip(unsigned cycles)
+{
+    if (cycles <= waveCounter) {
+        waveCounter -= cycles;
+        return;
+    }
+    const unsigned period = RATE_TABLE[registers.frequencyIndex];
+    cycles -= waveCounter + 1;
+    waveCounter = static_cast<u16>(period - 1 - cycles % period);
+    for (unsigned expirations = 1 + cycles / period; expirations > 0;) {
+        if (silence && sampleBufferEmpty && bitsRemaining == 8 && shiftRegister == sampleBuffer) {
+            expirations %= 8;
+        }
+        const auto bits = std::min<unsigned>(expirations, bitsRemaining);
+        clockOutputUnit(bits);
+        expirations -= bits;
+    }
+}
+
+/**
+ * Channel is active while there are bytes of the sample left to fetch.
+ */
+bool DmcChannel::isActive() const
+{
+    return bytesRemaining > 0;
+}
+
+/**
+ * Enabling the channel starts the sample, unless it is still playing. Disabling it stops the sample.
+ */
+void DmcChannel::enable(bool enable)
+{
+    AudioChannel::enable(enable);
+    if (!enable) {
+        bytesRemaining = 0;
+    } else if (bytesRemaining == 0) {
+        restart();
+    }
+}
+
+/**
+ * Sets the function used to fetch bytes of the sample from the CPU memory.
+ */
+void DmcChannel::setMemoryReader(const std::function<u8(u16)>& memoryReader)
+{
+    this->memoryReader = memoryReader;
+}
+
+bool DmcChannel::hasIrq() const
+{
+    return irq;
+}
+
+void DmcChannel::clearIrq()
+{
+    irq = false;
+}
+
+/**
+ * Cycles until the interrupt is raised by the fetch of the last byte, counting the cycle of the fetch.
+ * Byte in the buffer is taken by the output unit after the last bit of the current byte,
+ * the next byte is fetched right in the following cycle. NO_IRQ when the sample loops or doesn't raise the interrupt.
+ */
+unsigned DmcChannel::getIrqCycles() const
+{
+    if (!registers.irqEnable || registers.loopSample || bytesRemaining == 0) {
+        return NO_IRQ;
+    }
+    const unsigned period = RATE_TABLE[registers.frequencyIndex];
+    const unsigned nextBufferFetch = waveCounter + (bitsRemaining - 1) * period + 2;
+    if (!sampleBufferEmpty) {
+        return nextBufferFetch + (bytesRemaining - 1) * 8 * period;
+    }
+    // Empty buffer is filled in the next cycle
+    return bytesRemaining == 1 ? 1 : nextBufferFetch + (bytesRemaining - 2) * 8 * period;
+}
+
+/**
+ * Returns the amount of cycles, for which the CPU has to be halted because of sample fetches done since the last call.
+ */
+unsigned DmcChannel::takeStallCycles()
+{
+    auto cycles = stallCycles;
+    stallCycles = 0;
+    return cycles;
+}
+
+/**
+ * Consumes the given amount of bits of the sample, up to the end of the current byte, moving the output level.
+ * Next byte is taken from the buffer after the last bit.
+ */
+void DmcChannel::clockOutputUnit(unsigned bits)
+{
+    if (!silence) {
+        for (unsigned bit = 0; bit < bits; bit++) {
+            if ((shiftRegister >> bit) & 1) {
+                if (level <= 125) {
+                    level += 2;
+                }
+            } else if (level >= 2) {
+                level -= 2;
+            }
+        }
+    }
+    shiftRegister = static_cast<u8>(shiftRegister >> bits);
+    bitsRemaining -= bits;
+    if (bitsRemaining == 0) {
+        // Next byte of the sample is taken from the buffer, channel stays silent when there is none
+        bitsRemaining = 8;
+        silence = sampleBufferEmpty;
+        shiftRegister = sampleBuffer;
+        sampleBufferEmpty = true;
+    }
+}
+
+void DmcChannel::restart()
+{
+    currentAddress = 0xC000 + registers.sampleAddress * 64;
+    bytesRemaining = registers.sampleLength * 16 + 1;
+}
+
+void DmcChannel::fetchSample()
+{
+    sampleBuffer = memoryReader ? memoryReader(currentAddress) : 0;
+    sampleBufferEmpty = false;
+    stallCycles += FETCH_STALL_CYCLES;
+    // Address wraps around to $8000 after reaching the end of memory
+    currentAddress = currentAddress == 0xFFFF ? 0x8000 : currentAddress + 1;
+    if (--bytesRemaining > 0) {
+        return;
+    }
+    if (registers.loopSample) {
+        restart();
+    } else if (registers.irqEnable) {
+        irq = true;
+    }
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <array>
+#include <functional>
+
+#include "AudioChannel.hpp"
+#include "AudioChannelRegisters.hpp"
+
+/**
+ * Delta modulation channel plays 1 bit delta encoded samples, that are fetched directly from the CPU memory.
+ */
+class DmcChannel : public AudioChannel
+{
+    public:
+        // Cycles until the interrupt when none is due
+        static constexpr const unsigned NO_IRQ = UNLIMITED_IDLE_CYCLES;
+
+        DmcChannel();
+
+        ~DmcChannel() = default;
+
+        void write(u8 index, u8 value) override;
+
+        void quarterFrameTick() override;
+
+        void halfFrameTick() override;
+
+        u8 tick() override;
+
+        unsigned getIdleCycles(bool outputRequired) const override;
+
+        void skip(unsigned cycles) override;
+
+        bool isActive() const override;
+
+        void enable(bool enable) override;
+
+        void setMemoryReader(const std::function<u8(u16)>& memoryReader);
+
+        bool hasIrq() const;
+
+        void clearIrq();
+
+        unsigned getIrqCycles() const;
+
+        unsigned takeStallCycles();
+
+    private:
+        DmcChannelRegisters registers;
+        std::function<u8(u16)> memoryReader;
+        u16 waveCounter;
+        u16 currentAddress;
+        u16 bytesRemaining;
+        u8 sampleBuffer;
+        bool sampleBufferEmpty;
+        u8 shiftRegister;
+        u8 bitsRemaining;
+        bool silence;
+        u8 level;
+        bool irq;
+        unsigned stallCycles;
+
+        void clockOutputUnit(unsigned bits = 1);
+        void restart();
+        void fetchSample();
+
+        static const std::array<u16, 16> RATE_TABLE;
+        static constexpr const unsigned FETCH_STALL_CYCLES = 4;
+};
@@ -0,0 +1,48 @@
+#include "Envelope.hpp"
+
+Envelope::Envelope()
+    : startFlag(false)
+    , divider(0)
+    , decayLevel(0)
+{
+}
+
+/**
+ * Called when the last register of the channel is written, envelope starts again from the full volume.
+ */
+void Envelope::restart()
+{
+    startFlag = true;
+}
+
+/**
+ * Clocked by the frame sequencer every quarter frame.
+ * Decay level is decremented every period + 1 clocks, and wraps back to 15 when looping is enabled.
+ */
+void Envelope::tick(u8 period, bool loop)
+{
+    if (startFlag) {
+        startFlag = false;
+        decayLevel = 15;
+        divider = period;
+        return;
+    }
+    if (divider > 0) {
+        divider--;
+        return;
+    }
+    divider = period;
+    if (decayLevel > 0) {
+        decayLevel--;
+    } else if (loop) {
+        decayLevel = 15;
+    }
+}
+
+/**
+ * Same 4 bits of the channel register are either a constant volume or the period of the envelope.
+ */
+u8 Envelope::getVolume(bool constantVolume, u8 period) const
+{
+    return constantVolume ? period : decayLevel;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "../Types.hpp"
+
+/**
+ * Envelope generator shared by pulse and noise channels.
+ * It produces either a constant volume or a decreasing saw envelope, that can loop.
+ */
+class Envelope
+{
+    public:
+        Envelope();
+
+        ~Envelope() = default;
+
+        void restart();
+
+        void tick(u8 period, bool loop);
+
+        u8 getVolume(bool constantVolume, u8 period) const;
+
+    private:
+        bool startFlag;
+        u8 divider;
+        u8 decayLevel;
+};
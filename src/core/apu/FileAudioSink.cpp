@@ -0,0 +1,94 @@
+#include "FileAudioSink.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+FileAudioSink::FileAudioSink(const std::string& filename, AudioFileFormat format, unsigned sampleRate)
+    : file(filename, std::ios::binary)
+    , format(format)
+    , sampleRate(sampleRate)
+    , sampleCount(0)
+{
+    if (format == AudioFileFormat::Wav) {
+        writeWavHeader();
+    }
+}
+
+FileAudioSink::~FileAudioSink()
+{
+    close();
+}
+
+/**
+ * Converts the samples into 16 bit integers and appends them to the file, a chunk at a time.
+ */
+void FileAudioSink::write(const float* samples, unsigned count)
+{
+    if (!isOpen()) {
+        return;
+    }
+    std::array<u8, CHUNK_SAMPLES * 2> chunk;
+    while (count > 0) {
+        const auto chunkSamples = std::min(count, CHUNK_SAMPLES);
+        for (unsigned i = 0; i < chunkSamples; i++) {
+            const auto value = static_cast<s16>(std::lround(std::clamp(samples[i], -1.0f, 1.0f) * 32767.0f));
+            chunk[i * 2] = value & 0xFF;
+            chunk[i * 2 + 1] = static_cast<u16>(value) >> 8;
+        }
+        file.write(reinterpret_cast<const char*>(chunk.data()), chunkSamples * 2);
+        sampleCount += chunkSamples;
+        samples += chunkSamples;
+        count -= chunkSamples;
+    }
+}
+
+/**
+ * Finishes the file, WAV header gets the final sizes.
+ */
+void FileAudioSink::close()
+{
+    if (!isOpen()) {
+        return;
+    }
+    if (format == AudioFileFormat::Wav) {
+        file.seekp(0);
+        writeWavHeader();
+    }
+    file.close();
+}
+
+bool FileAudioSink::isOpen() const
+{
+    return file.is_open() && file.good();
+}
+
+u64 FileAudioSink::getSampleCount() const
+{
+    return sampleCount;
+}
+
+void FileAudioSink::writeWavHeader()
+{
+    const auto dataSize = static_cast<u32>(sampleCount * 2);
+    std::array<u8, WAV_HEADER_SIZE> header {};
+    auto put = [&header](unsigned offset, u32 value, unsigned size) {
+        for (unsigned i = 0; i < size; i++) {
+            header[offset + i] = (value >> (i * 8)) & 0xFF;
+        }
+    };
+    std::copy_n("RIFF", 4, header.begin());
+    put(4, WAV_HEADER_SIZE - 8 + dataSize, 4);
+    std::copy_n("WAVEfmt ", 8, header.begin() + 8);
+    // PCM format chunk of 16 bytes, 1 channel, 2 bytes per sample
+    put(16, 16, 4);
+    put(20, 1, 2);
+    put(22, 1, 2);
+    put(24, sampleRate, 4);
+    put(28, sampleRate * 2, 4);
+    put(32, 2, 2);
+    put(34, 16, 2);
+    std::copy_n("data", 4, header.begin() + 36);
+    put(40, dataSize, 4);
+    file.write(reinterpret_cast<const char*>(header.data()), header.size());
+}
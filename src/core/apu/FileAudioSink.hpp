@@ -0,0 +1,41 @@
+#pragma once
+
+#include <fstream>
+#include <string>
+
+#include "../Types.hpp"
+#include "AudioFileFormat.hpp"
+#include "AudioSink.hpp"
+
+/**
+ * Streams samples into a file as they come, so that runs of any length can be recorded.
+ * Samples are clamped to range -1..1 and stored as 16 bit signed little endian integers.
+ *
+ * WAV header is written when the file is opened, sizes in it are filled in when the file is closed.
+ */
+class FileAudioSink : public AudioSink
+{
+    public:
+        FileAudioSink(const std::string& filename, AudioFileFormat format, unsigned sampleRate);
+
+        ~FileAudioSink() override;
+
+        void write(const float* samples, unsigned count) override;
+
+        void close();
+
+        bool isOpen() const;
+
+        u64 getSampleCount() const;
+
+    private:
+        static constexpr const unsigned WAV_HEADER_SIZE = 44;
+        static constexpr const unsigned CHUNK_SAMPLES = 1024;
+
+        std::ofstream file;
+        AudioFileFormat format;
+        unsigned sampleRate;
+        u64 sampleCount;
+
+        void writeWavHeader();
+};
@@ -0,0 +1,108 @@
+#include "FrameCounter.hpp"
+
+#include <algorithm>
+
+FrameCounter::FrameCounter()
+    : frameCounterRegister()
+    , sequence(&FOUR_STEP_SEQUENCE)
+    , step(0)
+    , sequenceStart(0)
+    , restartCycle(NEVER)
+    , nextEventCycle(0)
+    , irq(false)
+    , irqCycle(NEVER)
+{
+    frameCounterRegister = 0;
+    updateNextEventCycle();
+}
+
+/**
+ * Register $4017 was written at the given cycle. Sequence restarts 3 cycles later when the write happens
+ * on an APU cycle (even CPU cycle), otherwise 4 cycles later.
+ */
+void FrameCounter::write(u8 value, u64 cycle)
+{
+    frameCounterRegister = value;
+    if (frameCounterRegister.irqDisable) {
+        clearIrq();
+    }
+    restartCycle = cycle + (cycle % 2 == 0 ? 3 : 4);
+    updateNextEventCycle();
+}
+
+/**
+ * Processes the event at the given cycle and returns what it clocks.
+ * Restarted 5-step sequence clocks both the quarter and half frame units right away.
+ */
+FrameCounterEvent FrameCounter::clock(u64 cycle)
+{
+    if (cycle == restartCycle) {
+        restartCycle = NEVER;
+        const bool fiveStep = frameCounterRegister.fiveStepSequencer;
+        sequence = fiveStep ? &FIVE_STEP_SEQUENCE : &FOUR_STEP_SEQUENCE;
+        step = 0;
+        sequenceStart = cycle;
+        updateNextEventCycle();
+        return FrameCounterEvent { 0, fiveStep, fiveStep, false };
+    }
+
+    const auto event = (*sequence)[step];
+    if (event.irq && !frameCounterRegister.irqDisable && !irq) {
+        irq = true;
+        irqCycle = cycle;
+    }
+    if (++step == sequence->size()) {
+        step = 0;
+        sequenceStart = cycle;
+    }
+    updateNextEventCycle();
+    return event;
+}
+
+bool FrameCounter::hasIrq() const
+{
+    return irq;
+}
+
+/**
+ * Acknowledges the interrupt. In 4-step mode the flag is set on 3 consecutive cycles,
+ * so it can be raised again right after it is cleared.
+ */
+void FrameCounter::clearIrq()
+{
+    irq = false;
+    irqCycle = NEVER;
+}
+
+/**
+ * Cycle at which the interrupt flag was set or, when it is clear, the cycle at which it will be set,
+ * unless $4017 is written before. NEVER when the interrupt is inhibited or the 5-step sequence runs.
+ */
+u64 FrameCounter::getIrqCycle() const
+{
+    if (irq) {
+        return irqCycle;
+    }
+    if (frameCounterRegister.irqDisable) {
+        return NEVER;
+    }
+    // 4-step sequence always sets the flag before its end, unless it is restarted first
+    for (auto i = step; i < sequence->size(); i++) {
+        const auto cycle = sequenceStart + (*sequence)[i].cycle;
+        if (cycle >= restartCycle) {
+            break;
+        }
+        if ((*sequence)[i].irq) {
+            return cycle;
+        }
+    }
+    if (restartCycle == NEVER || frameCounterRegister.fiveStepSequencer) {
+        return NEVER;
+    }
+    return restartCycle + FOUR_STEP_SEQUENCE[3].cycle;
+}
+
+void FrameCounter::updateNextEventCycle()
+{
+    nextEventCycle = std::min(sequenceStart + (*sequence)[step].cycle, restartCycle);
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <array>
+#include <limits>
+
+#include "../Types.hpp"
+#include "../ApuRegisters.hpp"
+
+/**
+ * Event of the frame counter sequence, at the given CPU cycle from the start of the sequence.
+ */
+struct FrameCounterEvent
+{
+    u16 cycle;
+    bool quarterFrame;
+    bool halfFrame;
+    bool irq;
+};
+
+/**
+ * Frame counter of the APU, it clocks the envelopes and the length counters and raises the frame interrupt.
+ *
+ * All of its events are scheduled at absolute CPU cycles, counted from the power-up, so the APU only has to
+ * compare the current cycle with the cycle of the next event. The same way, the cycle of the next frame interrupt
+ * is known in advance, the CPU doesn't need the APU to tell it about the interrupt every cycle.
+ *
+ * Writes to $4017 restart the sequence 3 or 4 cycles later, depending on whether they happen on an APU cycle.
+ * Until then the previous sequence goes on. Interrupt inhibit takes effect immediately.
+ */
+class FrameCounter
+{
+    public:
+        static constexpr const u64 NEVER = std::numeric_limits<u64>::max();
+
+        FrameCounter();
+
+        ~FrameCounter() = default;
+
+        void write(u8 value, u64 cycle);
+
+        /**
+         * Cycle of the next event, the APU has to call clock() exactly at that cycle.
+         */
+        u64 getNextEventCycle() const
+        {
+            return nextEventCycle;
+        }
+
+        FrameCounterEvent clock(u64 cycle);
+
+        bool hasIrq() const;
+
+        void clearIrq();
+
+        u64 getIrqCycle() const;
+
+    private:
+        using Sequence = std::array<FrameCounterEvent, 6>;
+
+        // Step 4 of the 5-step sequence does nothing, the last event of a sequence also starts the next one
+        static constexpr const Sequence FOUR_STEP_SEQUENCE = {{
+            { 7457, true, false, false },
+            { 14913, true, true, false },
+            { 22371, true, false, false },
+            { 29828, false, false, true },
+            { 29829, true, true, true },
+            { 29830, false, false, true }
+        }};
+        static constexpr const Sequence FIVE_STEP_SEQUENCE = {{
+            { 7457, true, false, false },
+            { 14913, true, true, false },
+            { 22371, true, false, false },
+            { 29829, false, false, false },
+            { 37281, true, true, false },
+            { 37282, false, false, false }
+        }};
+
+        FrameCounterRegister frameCounterRegister;
+        const Sequence* sequence;
+        unsigned step;
+        u64 sequenceStart;
+        // Cycle at which the sequence restarts after a write, NEVER when there is no write pending
+        u64 restartCycle;
+        u64 nextEventCycle;
+        bool irq;
+        u64 irqCycle;
+
+        void updateNextEventCycle();
+};
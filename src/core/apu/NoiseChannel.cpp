@@ -0,0 +1,184 @@
+#include "NoiseChannel.hpp"
+
+#include <vector>
+
+namespace
+{
+    // Normal mode goes through all 32767 states that are not zero, loop mode through sequences of 93 or 31 states
+    constexpr const unsigned NORMAL_PERIOD = 32767;
+    constexpr const unsigned LOOP_PERIOD = 93;
+
+    /**
+     * In loop mode feedback is taken from bit 6 instead of bit 1, producing much shorter, periodic sequence.
+     */
+    u16 shifted(u16 shiftRegister, bool loop)
+    {
+        const u16 feedback = (shiftRegister ^ (shiftRegister >> (loop ? 6 : 1))) & 1;
+        return (shiftRegister >> 1) | (feedback << 14);
+    }
+
+    /**
+     * Jump table of the shift register, that advances it by any amount of shifts at once.
+     *
+     * States are stored in the order the register goes through them, each sequence in a slot as long as the period.
+     * Sequences that are shorter divide the period, so they are repeated to fill their slot.
+     * State after n shifts is found n places further in the slot of the current state, wrapping around its end.
+     */
+    class ShiftSequences
+    {
+        public:
+            ShiftSequences(bool loop, unsigned period)
+                : states()
+                , positions()
+                , period(period)
+            {
+                std::vector<bool> visited(positions.size());
+                // Zero is never reached, it is left at the position 0
+                for (unsigned first = 1; first < positions.size(); first++) {
+                    if (visited[first]) {
+                        continue;
+                    }
+                    const auto start = static_cast<unsigned>(states.size());
+                    for (auto state = static_cast<u16>(first); !visited[state]; state = shifted(state, loop)) {
+                        visited[state] = true;
+                        positions[state] = static_cast<u16>(states.size());
+                        states.push_back(state);
+                    }
+                    for (unsigned i = start; states.size() < start + period; i++) {
+                        states.push_back(states[i]);
+                    }
+                }
+            }
+
+            u16 advance(u16 shiftRegister, unsigned shifts) const
+            {
+                if (shiftRegister == 0) {
+                    return 0;
+                }
+                const unsigned position = positions[shiftRegister];
+                const unsigned offset = position % period;
+                return states[position - offset + (offset + shifts % period) % period];
+            }
+
+        private:
+            std::vector<u16> states;
+            std::array<u16, 0x8000> positions;
+            unsigned period;
+    };
+
+    u16 advance(u16 shiftRegister, bool loop, unsigned shifts)
+    {
+        static const ShiftSequences normalSequences(false, NORMAL_PERIOD);
+        static const ShiftSequences loopSequences(true, LOOP_PERIOD);
+        return (loop ? loopSequences : normalSequences).advance(shiftRegister, shifts);
+    }
+}
+
+// Periods of the noise timer in CPU cycles (NTSC)
+const std::array<u16, 16> NoiseChannel::PERIOD_TABLE = {
+    4, 8, 16, 32, 64, 96, 128, 160, 202, 254, 380, 508, 762, 1016, 2034, 4068
+};
+
+NoiseChannel::NoiseChannel()
+    : AudioChannel()
+    , registers()
+    , envelope()
+    , waveCounter(0)
+    , shiftRegister(1)
+    , level(0)
+    , silent(true)
+{
+}
+
+/**
+ * Noise channel has no register under $400D, so the indices 2 and 3 are mapped onto the registers 1 and 2.
+ */
+void NoiseChannel::write(u8 index, u8 value)
+{
+    switch (index) {
+        case 0:
+            registers.reg0 = value;
+            break;
+        case 2:
+            registers.reg1 = value;
+            break;
+        case 3:
+            registers.reg2 = value;
+            loadLengthCounter(registers.lengthCounterLoad);
+            envelope.restart();
+            break;
+    }
+    updateLevel();
+}
+
+void NoiseChannel::quarterFrameTick()
+{
+    envelope.tick(registers.decayRate, registers.decayLoopEnable);
+    updateLevel();
+}
+
+void NoiseChannel::halfFrameTick()
+{
+    lengthCounterTick(registers.lengthCounterDisable);
+    updateLevel();
+}
+
+/**
+ * Single CPU cycle. Pseudo-random bits are produced by 15 bit linear feedback shift register,
+ * which is shifted every time the timer expires.
+ */
+u8 NoiseChannel::tick()
+{
+    if (waveCounter > 0) {
+        waveCounter--;
+        return level;
+    }
+    waveCounter = PERIOD_TABLE[registers.noisePeriod] - 1;
+    shift();
+    updateLevel();
+    return level;
+}
+
+/**
+ * Cycles until the shift register is shifted. Silent channel has no output to change, so it never needs to be ticked.
+ */
+unsigned NoiseChannel::getIdleCycles(bool outputRequired) const
+{
+    return silent || !outputRequired ? UNLIMITED_IDLE_CYCLES : waveCounter;
+}
+
+/**
+ * Advances the timer by the given amount of idle cycles. Shift register is advanced by all the timer periods
+ * that passed at once, when the channel is silent or its output is not required.
+ */
+void NoiseChannel::skip(unsigned cycles)
+{
+    if (cycles <= waveCounter) {
+        waveCounter -= cycles;
+        return;
+    }
+    const unsigned period = PERIOD_TABLE[registers.noisePeriod];
+    cycles -= waveCounter + 1;
+    shiftRegister = advance(shiftRegister, registers.noiseLoop, 1 + cycles / period);
+    waveCounter = static_cast<u16>(period - 1 - cycles % period);
+    updateLevel();
+}
+
+void NoiseChannel::enable(bool enable)
+{
+    AudioChannel::enable(enable);
+    updateLevel();
+}
+
+void NoiseChannel::shift()
+{
+    shiftRegister = shifted(shiftRegister, registers.noiseLoop);
+}
+
+void NoiseChannel::updateLevel()
+{
+    // Channel is silenced while the lowest bit of the shift register is set
+    const auto volume = envelope.getVolume(registers.decayDisable, registers.fixedVolume);
+    silent = lengthCounter == 0 || volume == 0;
+    level = silent || (shiftRegister & 1) ? 0 : volume;
+}
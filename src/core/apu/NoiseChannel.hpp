@@ -0,0 +1,42 @@
+#pragma once
+
+#include <array>
+
+#include "AudioChannel.hpp"
+#include "AudioChannelRegisters.hpp"
+#include "Envelope.hpp"
+
+class NoiseChannel : public AudioChannel
+{
+    public:
+        NoiseChannel();
+
+        ~NoiseChannel() = default;
+
+        void write(u8 index, u8 value) override;
+
+        void quarterFrameTick() override;
+
+        void halfFrameTick() override;
+
+        u8 tick() override;
+
+        unsigned getIdleCycles(bool outputRequired) const override;
+
+        void skip(unsigned cycles) override;
+
+        void enable(bool enable) override;
+
+    private:
+        NoiseChannelRegisters registers;
+        Envelope envelope;
+        u16 waveCounter;
+        u16 shiftRegister;
+        u8 level;
+        bool silent;
+
+        void shift();
+        void updateLevel();
+
+        static const std::array<u16, 16> PERIOD_TABLE;
+};
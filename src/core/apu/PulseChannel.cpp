@@ -1,15 +1,17 @@
 #include "PulseChannel.hpp"
 
+#include <algorithm>
+
 PulseChannel::PulseChannel(bool secondChannel)
     : AudioChannel()
     , registers()
-    , lengthCounter(0)
+    , envelope()
     , waveCounter(0)
-    , envelope(0)
-    , envelopeDecay(0)
     , phase(0)
     , level(0)
+    , silent(true)
     , sweepDelay(0)
+    , sweepReload(false)
     , secondChannel(secondChannel)
 {
 }
@@ -22,81 +24,121 @@ void PulseChannel::write(u8 index, u8 value)
             break;
         case 1:
             registers.reg1 = value;
+            sweepReload = true;
             break;
         case 2:
             registers.reg2 = value;
             break;
         case 3:
             registers.reg3 = value;
+            // Writing the last register restarts the note
+            loadLengthCounter(registers.lengthCounterIndex);
+            envelope.restart();
+            phase = 0;
             break;
     }
+    updateLevel();
 }
 
 void PulseChannel::quarterFrameTick()
 {
-    if (envelopeDecay == 0) {
-        envelopeDecay = registers.decayRate;
-        if (envelope > 0 || registers.decayLoopEnable) {
-            envelope = (envelope - 1) & 0xF;
-        }
-    } else {
-        envelopeDecay--;
-    }
+    envelope.tick(registers.decayRate, registers.decayLoopEnable);
+    updateLevel();
 }
 
 void PulseChannel::halfFrameTick()
 {
-    if (!registers.lengthCounterDisable && lengthCounter > 0) {
-        lengthCounter--;
+    lengthCounterTick(registers.lengthCounterDisable);
+    // Sweep unit periodically adjusts the wave length, unless the channel is muted by it
+    auto wl = registers.waveLength;
+    auto target = sweepTarget();
+    if (sweepDelay == 0 && registers.sweepEnabled && registers.shiftCount > 0 && wl >= 8 && target < 0x800) {
+        registers.waveLength = target;
     }
-    if (sweepDelay == 0) {
+    if (sweepDelay == 0 || sweepReload) {
         sweepDelay = registers.sweepPeriod;
-        auto wl = registers.waveLength;
-        if (wl >= 8 && registers.sweepEnabled && registers.shiftCount > 0) {
-            int sweepedWaveLength = wl >> registers.shiftCount;
-            if (registers.negative) {
-                wl = wl + (secondChannel ? -sweepedWaveLength : ~sweepedWaveLength);
-            } else {
-                wl = wl + sweepedWaveLength;
-            }
-            if (wl < 0x800) {
-                registers.waveLength = wl;
-            }
-        }
+        sweepReload = false;
     } else {
         sweepDelay--;
     }
+    updateLevel();
 }
 
+/**
+ * Single CPU cycle. Waveform advances by one step every (wave length + 1) * 2 cycles.
+ */
 u8 PulseChannel::tick()
-{   
-    if (!isEnabled()) {
-        return 8;
-    }
-    
-    auto wl = (registers.waveLength) + 1 * 2;
-    if (waveCounter == 0) {
-        waveCounter = wl;
-        return level;
-    } else {
+{
+    if (waveCounter > 0) {
         waveCounter--;
+        return level;
+    }
+    waveCounter = (registers.waveLength + 1) * 2 - 1;
+    phase = (phase + 1) % 8;
+    updateLevel();
+    return level;
+}
+
+/**
+ * Cycles until the waveform advances. Silent channel has no output to change, so it never needs to be ticked.
+ */
+unsigned PulseChannel::getIdleCycles(bool outputRequired) const
+{
+    return silent || !outputRequired ? UNLIMITED_IDLE_CYCLES : waveCounter;
+}
+
+/**
+ * Advances the timer by the given amount of idle cycles. Waveform is advanced by the amount of timer periods
+ * that passed, when the channel is silent or its output is not required.
+ */
+void PulseChannel::skip(unsigned cycles)
+{
+    if (cycles <= waveCounter) {
+        waveCounter -= cycles;
+        return;
     }
+    const unsigned period = (registers.waveLength + 1) * 2;
+    cycles -= waveCounter + 1;
+    phase = (phase + 1 + cycles / period) % 8;
+    waveCounter = period - 1 - cycles % period;
+    updateLevel();
+}
+
+void PulseChannel::enable(bool enable)
+{
+    AudioChannel::enable(enable);
+    updateLevel();
+}
 
+/**
+ * Wave length that sweep unit would set. First channel negates using one's complement, second one using two's complement.
+ */
+u16 PulseChannel::sweepTarget() const
+{
+    int wl = registers.waveLength;
+    int sweepedWaveLength = wl >> registers.shiftCount;
+    if (registers.negative) {
+        return static_cast<u16>(std::max(0, wl - sweepedWaveLength - (secondChannel ? 0 : 1)));
+    }
+    return static_cast<u16>(wl + sweepedWaveLength);
+}
+
+void PulseChannel::updateLevel()
+{
     // Waveform generator has 4 different 8-step binary waveforms thus it is composed of 32 bits of data
     // 1. 12.5% duty cycle
     // 2. 25% duty cycle
     // 3. 50% duty cycle
     // 4. 25% duty cycle (negated)
-    static const u32 WAVEFORMS = 0xF33C0C04;
-    
-    // Envelope generator can produce fixed volume or decreasing saw envelope.
-    u8 volume = 0;
-    if (lengthCounter > 0) {
-        volume = registers.decayDisable ? registers.fixedVolume : envelope; 
-    }
+    static const u32 WAVEFORMS = 0xF91E0602;
 
-    // Return previously chosen volume or zero depending on the phase of chosen waveform
-    phase = (phase + 1) % 8;
+    // Channel is muted when length counter runs out, or when the wave length is out of range of the sweep unit
+    if (lengthCounter == 0 || registers.waveLength < 8 || sweepTarget() >= 0x800) {
+        level = 0;
+        silent = true;
+        return;
+    }
+    auto volume = envelope.getVolume(registers.decayDisable, registers.fixedVolume);
+    silent = volume == 0;
     level = (WAVEFORMS & (1 << (phase + registers.dutyCycle * 8))) ? volume : 0;
-    return level;
 }
@@ -2,6 +2,7 @@
 
 #include "AudioChannel.hpp"
 #include "AudioChannelRegisters.hpp"
+#include "Envelope.hpp"
 
 class PulseChannel : public AudioChannel
 {
@@ -18,14 +19,23 @@ class PulseChannel : public AudioChannel
 
         u8 tick() override;
 
+        unsigned getIdleCycles(bool outputRequired) const override;
+
+        void skip(unsigned cycles) override;
+
+        void enable(bool enable) override;
+
     private:
         PulseChannelRegisters registers;
-        u8 lengthCounter;
-        u8 waveCounter;
-        u8 envelope;
-        u8 envelopeDecay;
+        Envelope envelope;
+        u16 waveCounter;
         u8 phase;
         u8 level;
+        bool silent;
         u8 sweepDelay;
+        bool sweepReload;
         bool secondChannel;
-};
\ No newline at end of file
+
+        u16 sweepTarget() const;
+        void updateLevel();
+};
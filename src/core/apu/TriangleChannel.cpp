@@ -0,0 +1,108 @@
+#include "TriangleChannel.hpp"
+
+TriangleChannel::TriangleChannel()
+    : AudioChannel()
+    , registers()
+    , waveCounter(0)
+    , phase(0)
+    , linearCounter(0)
+    , linearCounterReload(false)
+{
+}
+
+/**
+ * Triangle channel has no register under $4009, so the indices 2 and 3 are mapped onto the registers 1 and 2.
+ */
+void TriangleChannel::write(u8 index, u8 value)
+{
+    switch (index) {
+        case 0:
+            registers.reg0 = value;
+            break;
+        case 2:
+            registers.reg1 = value;
+            break;
+        case 3:
+            registers.reg2 = value;
+            loadLengthCounter(registers.lengthCounterLoad);
+            linearCounterReload = true;
+            break;
+    }
+}
+
+/**
+ * Linear counter is a second, more precise length counter of the triangle channel.
+ */
+void TriangleChannel::quarterFrameTick()
+{
+    if (linearCounterReload) {
+        linearCounter = registers.linearCounterReloadValue;
+    } else if (linearCounter > 0) {
+        linearCounter--;
+    }
+    if (!registers.linearCounterControl) {
+        linearCounterReload = false;
+    }
+}
+
+void TriangleChannel::halfFrameTick()
+{
+    lengthCounterTick(registers.linearCounterControl);
+}
+
+/**
+ * Single CPU cycle. Unlike other channels, triangle timer is clocked at the CPU rate,
+ * 32 step waveform advances every wave length + 1 cycles.
+ * 
+ * When any of the counters runs out, waveform stops at its current level instead of being silenced.
+ * Periods below 2 produce ultrasonic frequencies, they are also stopped to avoid aliasing.
+ */
+u8 TriangleChannel::tick()
+{
+    if (waveCounter > 0) {
+        waveCounter--;
+    } else {
+        waveCounter = waveLength();
+        if (isPlaying()) {
+            phase = (phase + 1) % 32;
+        }
+    }
+    // Level goes down from 15 to 0 and then back up to 15
+    return phase < 16 ? 15 - phase : phase - 16;
+}
+
+/**
+ * Cycles until the waveform advances. Stopped waveform holds its level, so the channel never needs to be ticked.
+ */
+unsigned TriangleChannel::getIdleCycles(bool outputRequired) const
+{
+    return isPlaying() && outputRequired ? waveCounter : UNLIMITED_IDLE_CYCLES;
+}
+
+/**
+ * Advances the timer by the given amount of idle cycles. Waveform moves by the amount of timer periods that passed,
+ * unless it is stopped.
+ */
+void TriangleChannel::skip(unsigned cycles)
+{
+    if (cycles <= waveCounter) {
+        waveCounter -= cycles;
+        return;
+    }
+    const unsigned period = waveLength() + 1;
+    cycles -= waveCounter + 1;
+    if (isPlaying()) {
+        phase = (phase + 1 + cycles / period) % 32;
+    }
+    waveCounter = static_cast<u16>(period - 1 - cycles % period);
+}
+
+u16 TriangleChannel::waveLength() const
+{
+    return registers.timerLow | registers.timerHigh << 8;
+}
+
+bool TriangleChannel::isPlaying() const
+{
+    return lengthCounter > 0 && linearCounter > 0 && waveLength() >= 2;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "AudioChannel.hpp"
+#include "AudioChannelRegisters.hpp"
+
+class TriangleChannel : public AudioChannel
+{
+    public:
+        TriangleChannel();
+
+        ~TriangleChannel() = default;
+
+        void write(u8 index, u8 value) override;
+
+        void quarterFrameTick() override;
+
+        void halfFrameTick() override;
+
+        u8 tick() override;
+
+        unsigned getIdleCycles(bool outputRequired) const override;
+
+        void skip(unsigned cycles) override;
+
+    private:
+        TriangleChannelRegisters registers;
+        u16 waveCounter;
+        u8 phase;
+        u8 linearCounter;
+        bool linearCounterReload;
+
+        u16 waveLength() const;
+        bool isPlaying() const;
+};
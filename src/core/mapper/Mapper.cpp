@@ -5,5 +5,68 @@ Mapper::Mapper(std::vector<u8> &&prgRom, std::vector<u8> &&chrRom, MirroringType
     , chrRom(chrRom)
     , prgRam()
     , mirroringType(mirroringType)
+    , chrGeneration(0)
+    , chrPages()
+    , chrWriteMask(0)
 {
-}
\ No newline at end of file
+    // Cartridges without CHR-ROM have 8KB of CHR-RAM instead
+    if (this->chrRom.empty()) {
+        this->chrRom.resize(0x2000);
+        chrWriteMask = 0xFF;
+    }
+    mapChr(0, CHR_PAGE_COUNT, 0);
+}
+
+/**
+ * Returns the counter that is incremented every time the CHR banks visible to the PPU are switched.
+ * Consumers that cache decoded pattern data compare it with the previously seen value
+ * to find out that whole pattern table has to be decoded again.
+ */
+u64 Mapper::getChrGeneration() const
+{
+    return chrGeneration;
+}
+
+/**
+ * Whole CHR memory of the cartridge, pages of the pattern table address space point into it.
+ */
+const std::vector<u8>& Mapper::getChrMemory() const
+{
+    return chrRom;
+}
+
+/**
+ * Offset in CHR memory of the given 1KB page of the pattern table address space.
+ */
+unsigned Mapper::getChrPageOffset(unsigned page) const
+{
+    return static_cast<unsigned>(chrPages[page] - chrRom.data());
+}
+
+u8 Mapper::getChrWriteMask() const
+{
+    return chrWriteMask;
+}
+
+void Mapper::chrBankingChanged()
+{
+    chrGeneration++;
+}
+
+/**
+ * Points given pages of pattern table address space to consecutive pages of CHR memory, starting at given address.
+ * Addresses past the end of CHR memory are wrapped around.
+ */
+void Mapper::mapChr(unsigned firstPage, unsigned pageCount, unsigned chrAddress)
+{
+    bool changed = false;
+    for (unsigned page = firstPage; page < firstPage + pageCount; page++) {
+        auto* pageData = chrRom.data() + chrAddress % chrRom.size();
+        changed |= chrPages[page] != pageData;
+        chrPages[page] = pageData;
+        chrAddress += CHR_PAGE_SIZE;
+    }
+    if (changed) {
+        chrBankingChanged();
+    }
+}
@@ -9,6 +9,9 @@
 class Mapper
 {
     public:
+        static constexpr const unsigned CHR_PAGE_COUNT = 8;
+        static constexpr const unsigned CHR_PAGE_SIZE = 0x400;
+
         Mapper(std::vector<u8>&& prgRom, std::vector<u8>&& chrRom, MirroringType mirroringType);
 
         virtual ~Mapper() = default;
@@ -19,9 +22,51 @@ class Mapper
 
         virtual MirroringType getMirroringType() = 0;
 
+        u8 readChr(u16 addr) const;
+
+        void writeChr(u16 addr, u8 value);
+
+        u64 getChrGeneration() const;
+
+        const std::vector<u8>& getChrMemory() const;
+
+        unsigned getChrPageOffset(unsigned page) const;
+
+        u8 getChrWriteMask() const;
+
     protected:
         std::vector<u8> prgRom;
         std::vector<u8> chrRom;
         std::array<u8, 0x2000> prgRam;
         MirroringType mirroringType;
-};
\ No newline at end of file
+        u64 chrGeneration;
+
+        void chrBankingChanged();
+        void mapChr(unsigned firstPage, unsigned pageCount, unsigned chrAddress);
+
+    private:
+        // PPU pattern table address space (0x0000 - 0x1FFF) split into 1KB pages pointing into CHR memory.
+        // Mappers switch banks by pointing pages to the other parts of CHR memory.
+        std::array<u8*, CHR_PAGE_COUNT> chrPages;
+        // Bit for each of the pages, that is set when the page can be written to (CHR-RAM)
+        u8 chrWriteMask;
+};
+
+/**
+ * Reads from pattern table address space of the PPU.
+ */
+inline u8 Mapper::readChr(u16 addr) const
+{
+    return chrPages[(addr >> 10) & 7][addr & (CHR_PAGE_SIZE - 1)];
+}
+
+/**
+ * Writes into pattern table address space of the PPU. Writes into CHR-ROM are ignored.
+ */
+inline void Mapper::writeChr(u16 addr, u8 value)
+{
+    const auto page = (addr >> 10) & 7;
+    if (chrWriteMask & (1 << page)) {
+        chrPages[page][addr & (CHR_PAGE_SIZE - 1)] = value;
+    }
+}
@@ -19,6 +19,5 @@ class Mapper0 : public Mapper
         MirroringType getMirroringType() override;
 
     private:
-        bool writableChrRom;
         u8& memoryRef(u16 addr);
 };
\ No newline at end of file
@@ -4,21 +4,14 @@ Mapper1::Mapper1(std::vector<u8> &&prgRom, std::vector<u8> &&chrRom, MirroringTy
     : Mapper(std::move(prgRom), std::move(chrRom), mirroringType)
     , shiftRegister(0x10)
     , registers()
-    , writableChr(false)
 {
-    if (this->chrRom.empty()) {
-        this->chrRom.resize(0x2000);
-        writableChr = true;
-    }
     registers.control.prgRomBankMode = 3;
+    updateChrPages();
 }
 
 void Mapper1::write(u16 addr, u8 value)
 {
-    if (writableChr && addr < 0x2000) {
-        auto address = absoluteChrAddress(addr);
-        chrRom[address] = value;
-    } else if (addr >= 0x6000 && addr < 0x8000) {
+    if (addr >= 0x6000 && addr < 0x8000) {
         prgRam[addr - 0x6000] = value;
     } else if (addr >= 0x8000 && addr <= 0xFFFF) {
         // MMC1 Serial port
@@ -28,10 +21,7 @@ void Mapper1::write(u16 addr, u8 value)
 
 u8 Mapper1::read(u16 addr)
 {
-    if (addr < 0x2000) {
-        auto address = absoluteChrAddress(addr);
-        return chrRom[address];
-    } else if (addr >= 0x6000 && addr < 0x8000) {
+    if (addr >= 0x6000 && addr < 0x8000) {
         return prgRam[addr - 0x6000];
     } else if (addr >= 0x8000 && addr <= 0xFFFF) {
         auto address = absolutePrgAddress(addr - 0x8000);
@@ -73,10 +63,13 @@ void Mapper1::writeToLoadRegister(u16 addr, u8 value)
         shiftRegister |= (value & 1) << 4;
         if (addr < 0xA000) {
             registers.control = shiftRegister;
+            updateChrPages();
         } else if (addr < 0xC000) {
             registers.chrBank0 = shiftRegister;
+            updateChrPages();
         } else if (addr < 0xE000) {
             registers.chrBank1 = shiftRegister;
+            updateChrPages();
         } else {
             registers.prgBank = shiftRegister;
         }
@@ -87,20 +80,19 @@ void Mapper1::writeToLoadRegister(u16 addr, u8 value)
     }
 }
 
-unsigned Mapper1::absoluteChrAddress(u16 addr)
+/**
+ * Maps CHR banks selected by the registers into pattern table address space.
+ * CHR is switched either as a single 8KB bank, or as two independent 4KB banks.
+ */
+void Mapper1::updateChrPages()
 {
     const auto& chrBankMode = registers.control.chrRomBankMode;
     if (chrBankMode == 0) {
         auto bank = (registers.chrBank0 >> 1);
-        return bank * 0x2000 + addr;
+        mapChr(0, 8, bank * 0x2000);
     } else {
-        if (addr < 0x1000) {
-            auto bank = registers.chrBank0;
-            return bank * 0x1000 + addr;
-        } else {
-            auto bank = registers.chrBank1;
-            return bank * 0x1000 + addr - 0x1000; 
-        }
+        mapChr(0, 4, registers.chrBank0 * 0x1000);
+        mapChr(4, 4, registers.chrBank1 * 0x1000);
     }
 }
 
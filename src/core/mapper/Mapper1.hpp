@@ -21,12 +21,11 @@ class Mapper1 : public Mapper
 
     private:
         u8 shiftRegister;
-        bool writableChr;
         Mapper1Registers registers;
 
         void resetShiftRegister();
         void writeToLoadRegister(u16 addr, u8 value);
 
-        unsigned absoluteChrAddress(u16 addr);
+        void updateChrPages();
         unsigned absolutePrgAddress(u16 addr);
 };
\ No newline at end of file
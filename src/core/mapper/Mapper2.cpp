@@ -4,9 +4,6 @@ Mapper2::Mapper2(std::vector<u8> &&prgRom, std::vector<u8> &&chrRom, MirroringTy
     : Mapper(std::move(prgRom), std::move(chrRom), mirroringType)
     , bankSelectRegister(0)
 {
-    if(this->chrRom.empty()) {
-        this->chrRom.resize(0x2000);
-    }
 }
 
 void Mapper2::write(u16 addr, u8 value)
@@ -34,9 +31,7 @@ u8 &Mapper2::memoryRef(u16 addr)
 {
     static const unsigned PRG_ROM_BANK_SIZE = 0x4000;
     static u8 dummyByte = 0;
-    if (addr < 0x2000 && chrRom.size() != 0) {
-        return chrRom[addr];
-    } else if (addr >= 0x6000 && addr < 0x8000) {
+    if (addr >= 0x6000 && addr < 0x8000) {
         auto prgRamAddr = addr - 0x6000;
         return prgRam[addr % prgRam.size()];
     } else if (addr >= 0x8000 && addr < 0xC000) {
@@ -10,6 +10,7 @@ void Mapper3::write(u16 addr, u8 value)
 {
     if(addr >= 0x8000 && addr <= 0xFFFF) {
         bankSelectRegister = value & 0x3;
+        mapChr(0, CHR_PAGE_COUNT, bankSelectRegister * CHR_ROM_BANK_SIZE);
     } else if(addr >= 0x6000 && addr < 0x8000) {
         prgRam[addr - 0x6000] = value;
     }
@@ -17,11 +18,7 @@ void Mapper3::write(u16 addr, u8 value)
 
 u8 Mapper3::read(u16 addr)
 {
-    const unsigned CHR_ROM_BANK_SIZE = 0x2000;
-    if (addr < 0x2000) {
-        auto chrRomAddr = CHR_ROM_BANK_SIZE * bankSelectRegister + addr;
-        return chrRom[chrRomAddr];
-    } else if (addr >= 0x6000 && addr < 0x8000) {
+    if (addr >= 0x6000 && addr < 0x8000) {
         auto prgRamAddr = addr - 0x6000;
         return prgRam[prgRamAddr];
     } else if (addr >= 0x8000 && addr < 0xFFFF) {
@@ -16,5 +16,7 @@ class Mapper3 : public Mapper
         MirroringType getMirroringType() override;
 
     private:
+        static constexpr const unsigned CHR_ROM_BANK_SIZE = 0x2000;
+
         u8 bankSelectRegister;
 };
\ No newline at end of file
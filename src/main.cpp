@@ -13,12 +13,103 @@ extern "C"
         emulator.loadRom(filenameString);
     }
 
+    EMSCRIPTEN_KEEPALIVE unsigned getSkippedFrames()
+    {
+        return static_cast<unsigned>(emulator.getSkippedFrameCount());
+    }
+
+    EMSCRIPTEN_KEEPALIVE unsigned getAudioOverruns()
+    {
+        return static_cast<unsigned>(emulator.getAudioOverrunCount());
+    }
+
+    EMSCRIPTEN_KEEPALIVE unsigned getAudioUnderruns()
+    {
+        return static_cast<unsigned>(emulator.getAudioUnderrunCount());
+    }
+
+    EMSCRIPTEN_KEEPALIVE void setAudioEnabled(int enabled)
+    {
+        emulator.setAudioEnabled(enabled != 0);
+    }
+
+    EMSCRIPTEN_KEEPALIVE void setNativeRateAudio(int enabled)
+    {
+        emulator.setNativeRateAudio(enabled != 0);
+    }
+
+    EMSCRIPTEN_KEEPALIVE double getAudioBlockTime()
+    {
+        return emulator.getAudioBlockTime();
+    }
+
+    EMSCRIPTEN_KEEPALIVE void setMutedChannels(int mask)
+    {
+        emulator.setMutedChannels(static_cast<u8>(mask));
+    }
+
+    EMSCRIPTEN_KEEPALIVE void setSoloChannels(int mask)
+    {
+        emulator.setSoloChannels(static_cast<u8>(mask));
+    }
+
+    EMSCRIPTEN_KEEPALIVE void setChannelTapRate(int rate)
+    {
+        emulator.setChannelTapRate(rate > 0 ? static_cast<unsigned>(rate) : 0);
+    }
+
+    // Samples are then read from the memory at the address returned by getChannelTapSamples
+    EMSCRIPTEN_KEEPALIVE int readChannelTap(int channel)
+    {
+        return static_cast<int>(emulator.readChannelTap(static_cast<unsigned>(channel)));
+    }
+
+    EMSCRIPTEN_KEEPALIVE const float* getChannelTapSamples()
+    {
+        return emulator.getChannelTapSamples();
+    }
+
+    EMSCRIPTEN_KEEPALIVE void setNtscFilter(int enabled)
+    {
+        emulator.setNtscFilter(enabled != 0);
+    }
+
+    EMSCRIPTEN_KEEPALIVE void setPpuConfig(int spriteLimit, int firstVisibleRow, int visibleRowCount)
+    {
+        emulator.setPpuConfig(PpuConfig {
+            .spriteLimit = static_cast<unsigned>(spriteLimit),
+            .firstVisibleRow = static_cast<unsigned>(firstVisibleRow),
+            .visibleRowCount = static_cast<unsigned>(visibleRowCount)
+        });
+    }
+
+    EMSCRIPTEN_KEEPALIVE void setScaler(int filter, int factor)
+    {
+        // Negative filter disables software scaling
+        if (filter < 0) {
+            emulator.disableScaler();
+        } else if (!emulator.setScaler(static_cast<ScalerFilter>(filter), factor > 0 ? static_cast<unsigned>(factor) : 1)) {
+            std::cerr << "Unknown scaler filter " << filter << std::endl;
+        }
+    }
+
+    EMSCRIPTEN_KEEPALIVE double getScalerFrameTime()
+    {
+        return emulator.getScalerFrameTime();
+    }
+
     EMSCRIPTEN_KEEPALIVE void run()
     {
         if(SDL_Init(SDL_INIT_VIDEO) != 0) {
             std::cerr << "Failed to initialize SDL Video" << std::endl;
             return;
         }
+        // Emulation runs without sound when audio is not available
+        if(SDL_InitSubSystem(SDL_INIT_AUDIO) == 0) {
+            emulator.startAudio();
+        } else {
+            std::cerr << "Failed to initialize SDL Audio" << std::endl;
+        }
         u64 currentTime;
         u64 deltaTime;
         u64 lastTime = 0;
@@ -0,0 +1,61 @@
+#include "DirtyRowTracker.hpp"
+
+#include <algorithm>
+
+DirtyRowTracker::DirtyRowTracker()
+    : uploadedRowHashes()
+    , fullUploadRequired(true)
+    , framesSinceFullUpload(0)
+    , skippedFrameCount(0)
+{
+}
+
+/**
+ * Compares hashes of the rows of a new frame with the rows uploaded last time.
+ * Returns the range of rows that has to be uploaded, or nothing when the frame can be skipped.
+ * Range is extended by the given amount of rows on both sides, for the output rows that depend on their neighbours.
+ */
+std::optional<DirtyRowTracker::RowRange> DirtyRowTracker::update(const RowHashes& rowHashes, unsigned margin)
+{
+    if (++framesSinceFullUpload >= FULL_UPLOAD_INTERVAL) {
+        fullUploadRequired = true;
+    }
+
+    unsigned firstDirtyRow = ROW_COUNT;
+    unsigned lastDirtyRow = 0;
+    for (unsigned row = 0; row < ROW_COUNT; row++) {
+        if (rowHashes[row] != uploadedRowHashes[row] || fullUploadRequired) {
+            firstDirtyRow = std::min(firstDirtyRow, row);
+            lastDirtyRow = row;
+        }
+    }
+    if (firstDirtyRow > lastDirtyRow) {
+        skippedFrameCount++;
+        return std::nullopt;
+    }
+
+    if (fullUploadRequired) {
+        fullUploadRequired = false;
+        framesSinceFullUpload = 0;
+    }
+    uploadedRowHashes = rowHashes;
+    firstDirtyRow = firstDirtyRow > margin ? firstDirtyRow - margin : 0;
+    lastDirtyRow = std::min(ROW_COUNT - 1, lastDirtyRow + margin);
+    return RowRange { firstDirtyRow, lastDirtyRow - firstDirtyRow + 1 };
+}
+
+/**
+ * Makes the next frame upload whole, for example when the texture was recreated.
+ */
+void DirtyRowTracker::invalidate()
+{
+    fullUploadRequired = true;
+}
+
+/**
+ * Returns the amount of frames that were skipped, as none of their rows changed.
+ */
+u64 DirtyRowTracker::getSkippedFrameCount() const
+{
+    return skippedFrameCount;
+}
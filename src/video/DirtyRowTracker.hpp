@@ -0,0 +1,45 @@
+#pragma once
+
+#include <array>
+#include <optional>
+
+#include "../core/Types.hpp"
+#include "../core/Ppu.hpp"
+
+/**
+ * Finds the rows of a frame that differ from the rows uploaded to the texture last time,
+ * so that unchanged frames are skipped and only the changed part of the others is uploaded.
+ *
+ * Rows are compared by their 32 bit hashes only. To keep a row changed without a change of its hash
+ * from staying on the screen, whole frame is uploaded every FULL_UPLOAD_INTERVAL frames.
+ */
+class DirtyRowTracker
+{
+    public:
+        static constexpr const unsigned ROW_COUNT = Ppu::SCREEN_HEIGHT;
+        static constexpr const unsigned FULL_UPLOAD_INTERVAL = 60;
+
+        using RowHashes = std::array<u32, ROW_COUNT>;
+
+        struct RowRange
+        {
+            unsigned first;
+            unsigned count;
+        };
+
+        DirtyRowTracker();
+
+        ~DirtyRowTracker() = default;
+
+        std::optional<RowRange> update(const RowHashes& rowHashes, unsigned margin = 0);
+
+        void invalidate();
+
+        u64 getSkippedFrameCount() const;
+
+    private:
+        RowHashes uploadedRowHashes;
+        bool fullUploadRequired;
+        unsigned framesSinceFullUpload;
+        u64 skippedFrameCount;
+};
@@ -0,0 +1,205 @@
+#include "NtscFilter.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <numbers>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+#endif
+
+namespace
+{
+    // Signal levels relative to the sync level, as measured on the 2C02
+    // (see https://www.nesdev.org/wiki/NTSC_video)
+    static constexpr const float BLACK = 0.518f;
+    static constexpr const float WHITE = 1.962f;
+    static constexpr const float ATTENUATION = 0.746f;
+    static constexpr const float LEVELS[8] = {
+        0.350f, 0.518f, 0.962f, 1.550f, // Signal low
+        1.094f, 1.506f, 1.962f, 1.962f  // Signal high
+    };
+    // Shift of the decoder's color subcarrier phase in samples, adjusts the hue
+    static constexpr const float HUE = 3.9f;
+
+    static constexpr const int SAMPLES_PER_PIXEL = 8;
+    static constexpr const int SAMPLES_PER_CYCLE = 12;
+    static constexpr const int PIXELS_PER_GROUP = 3;
+    static constexpr const int OUTPUT_PIXELS_PER_GROUP = 7;
+
+    bool inColorPhase(int color, int phase)
+    {
+        return (color + phase) % SAMPLES_PER_CYCLE < 6;
+    }
+
+    /**
+     * Level of the composite signal generated by the PPU for the given Indexed9 color at given phase.
+     * Result is normalized, so that black is 0 and white is 1.
+     */
+    float signalLevel(unsigned entry, int phase)
+    {
+        int color = entry & 0x0F;
+        int level = (entry >> 4) & 3;
+        int emphasis = entry >> 6;
+        // Colors $xE and $xF are forced to level 1
+        if (color > 13) {
+            level = 1;
+        }
+        float low = LEVELS[level];
+        float high = LEVELS[4 + level];
+        // Color 0 only emits high level and colors $xD-$xF only emit low level, thus they are grey
+        if (color == 0) {
+            low = high;
+        }
+        if (color > 12) {
+            high = low;
+        }
+        float signal = inColorPhase(color, phase) ? high : low;
+        // Emphasis attenuates the signal during the phases of emphasized colors
+        if (((emphasis & 1) && inColorPhase(0, phase))
+            || ((emphasis & 2) && inColorPhase(4, phase))
+            || ((emphasis & 4) && inColorPhase(8, phase))) {
+            signal *= ATTENUATION;
+        }
+        return (signal - BLACK) / (WHITE - BLACK);
+    }
+
+    /**
+     * Position of the sample in the center of the decoding window of given output pixel.
+     */
+    int windowCenter(int outputPixel)
+    {
+        return static_cast<int>(std::floor(outputPixel * float(PIXELS_PER_GROUP * SAMPLES_PER_PIXEL) / OUTPUT_PIXELS_PER_GROUP));
+    }
+}
+
+NtscFilter::NtscFilter()
+    : kernels(LINE_PHASES * ALIGNMENTS * PpuPalette::COLOR_COUNT * KERNEL_WIDTH)
+    , kernelOffsets()
+{
+    buildKernels();
+}
+
+/**
+ * Filters given rows of the Indexed9 frame. Output rows are OUTPUT_WIDTH pixels wide,
+ * first output row corresponds to the first filtered row.
+ */
+void NtscFilter::apply(const u8* input, unsigned firstRow, unsigned rowCount, u32* output) const
+{
+    for (unsigned row = firstRow; row < firstRow + rowCount; row++) {
+        // Each scanline is 341 * 8 samples long, so its starting phase is shifted by 4 samples from the previous one
+        filterRow(input + row * INPUT_WIDTH * sizeof(u16), row % LINE_PHASES, output + (row - firstRow) * OUTPUT_WIDTH);
+    }
+}
+
+const NtscFilter::Color* NtscFilter::kernel(unsigned linePhase, unsigned alignment, unsigned entry) const
+{
+    return kernels.data() + ((linePhase * ALIGNMENTS + alignment) * PpuPalette::COLOR_COUNT + entry) * KERNEL_WIDTH;
+}
+
+/**
+ * Decodes the signal of every palette entry in isolation.
+ * Output pixel is decoded from the 12 samples around its center (single cycle of color subcarrier),
+ * which gives luma, and the chroma is demodulated using the subcarrier phase.
+ */
+void NtscFilter::buildKernels()
+{
+    for (int alignment = 0; alignment < int(ALIGNMENTS); alignment++) {
+        const int firstSample = alignment * SAMPLES_PER_PIXEL;
+        int offset = -OUTPUT_PIXELS_PER_GROUP;
+        while (windowCenter(offset) + SAMPLES_PER_CYCLE / 2 <= firstSample) {
+            offset++;
+        }
+        kernelOffsets[alignment] = offset;
+    }
+
+    for (unsigned linePhase = 0; linePhase < LINE_PHASES; linePhase++) {
+        const int phaseShift = linePhase * 4;
+        for (unsigned alignment = 0; alignment < ALIGNMENTS; alignment++) {
+            const int firstSample = alignment * SAMPLES_PER_PIXEL;
+            for (unsigned entry = 0; entry < PpuPalette::COLOR_COUNT; entry++) {
+                auto* target = kernels.data() + ((linePhase * ALIGNMENTS + alignment) * PpuPalette::COLOR_COUNT + entry) * KERNEL_WIDTH;
+                for (unsigned i = 0; i < KERNEL_WIDTH; i++) {
+                    const int center = windowCenter(kernelOffsets[alignment] + i);
+                    float y = 0.0f;
+                    float in = 0.0f;
+                    float q = 0.0f;
+                    for (int sample = firstSample; sample < firstSample + SAMPLES_PER_PIXEL; sample++) {
+                        if (sample < center - SAMPLES_PER_CYCLE / 2 || sample >= center + SAMPLES_PER_CYCLE / 2) {
+                            continue;
+                        }
+                        const int phase = sample + phaseShift;
+                        const float level = signalLevel(entry, phase) / SAMPLES_PER_CYCLE;
+                        const float angle = std::numbers::pi_v<float> * (phase + HUE) / 6.0f;
+                        y += level;
+                        in += level * std::cos(angle);
+                        q += level * std::sin(angle);
+                    }
+                    // FCC YIQ to RGB conversion
+                    target[i] = Color {{
+                        255.0f * (y + 0.946882f * in + 0.623557f * q),
+                        255.0f * (y - 0.274788f * in - 0.635691f * q),
+                        255.0f * (y - 1.108545f * in + 1.709007f * q),
+                        0.0f
+                    }};
+                }
+            }
+        }
+    }
+}
+
+void NtscFilter::filterRow(const u8* input, unsigned linePhase, u32* output) const
+{
+    std::array<u16, INPUT_WIDTH> entries;
+    std::memcpy(entries.data(), input, sizeof(entries));
+    // Alpha channel is not touched by kernels, so it stays opaque
+    std::array<Color, ROW_SIZE> row;
+    row.fill(Color {{ 0.0f, 0.0f, 0.0f, 255.0f }});
+
+    for (unsigned group = 0; group * PIXELS_PER_GROUP < INPUT_WIDTH; group++) {
+        for (unsigned alignment = 0; alignment < ALIGNMENTS; alignment++) {
+            const auto x = group * PIXELS_PER_GROUP + alignment;
+            if (x >= INPUT_WIDTH) {
+                break;
+            }
+            const auto* source = kernel(linePhase, alignment, entries[x] % PpuPalette::COLOR_COUNT);
+            auto* target = row.data() + ROW_PADDING + group * OUTPUT_PIXELS_PER_GROUP + kernelOffsets[alignment];
+            for (unsigned i = 0; i < KERNEL_WIDTH; i++) {
+#if defined(__SSE2__)
+                _mm_store_ps(target[i].channels, _mm_add_ps(_mm_load_ps(target[i].channels), _mm_load_ps(source[i].channels)));
+#elif defined(__wasm_simd128__)
+                wasm_v128_store(target[i].channels, wasm_f32x4_add(wasm_v128_load(target[i].channels), wasm_v128_load(source[i].channels)));
+#else
+                for (unsigned channel = 0; channel < 4; channel++) {
+                    target[i].channels[channel] += source[i].channels[channel];
+                }
+#endif
+            }
+        }
+    }
+
+    // Convert accumulated colors into RGBA, clamping channels to 0..255
+    for (unsigned x = 0; x < OUTPUT_WIDTH; x++) {
+        const auto& color = row[ROW_PADDING + x];
+#if defined(__SSE2__)
+        auto channels = _mm_cvtps_epi32(_mm_load_ps(color.channels));
+        channels = _mm_packs_epi32(channels, channels);
+        channels = _mm_packus_epi16(channels, channels);
+        output[x] = static_cast<u32>(_mm_cvtsi128_si32(channels));
+#elif defined(__wasm_simd128__)
+        auto channels = wasm_i32x4_trunc_sat_f32x4(wasm_f32x4_nearest(wasm_v128_load(color.channels)));
+        channels = wasm_i16x8_narrow_i32x4(channels, channels);
+        channels = wasm_u8x16_narrow_i16x8(channels, channels);
+        output[x] = static_cast<u32>(wasm_i32x4_extract_lane(channels, 0));
+#else
+        u32 rgba = 0;
+        for (unsigned channel = 0; channel < 4; channel++) {
+            auto value = std::lround(std::fmin(std::fmax(color.channels[channel], 0.0f), 255.0f));
+            rgba |= static_cast<u32>(value) << (channel * 8);
+        }
+        output[x] = rgba;
+#endif
+    }
+}
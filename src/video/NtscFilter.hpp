@@ -0,0 +1,52 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include "../core/Types.hpp"
+#include "../core/PpuPalette.hpp"
+
+/**
+ * Software NTSC composite video filter.
+ *
+ * Takes the frame in Indexed9 format (6 bit color index and 3 emphasis bits)
+ * and produces RGBA image with the artifacts of the composite signal (color bleeding, dot crawl pattern).
+ *
+ * PPU outputs 8 samples of the signal per pixel and there are 12 samples per color subcarrier cycle,
+ * so every 3 pixels span exactly 2 cycles. Output pixels are sampled 7 times per 3 input pixels.
+ * Decoding of the signal is linear, so contribution of every palette entry to the output pixels
+ * is precomputed for each phase of the scanline and alignment of the pixel within group of 3.
+ * Filtering is then just a sum of these kernels.
+ */
+class NtscFilter
+{
+    public:
+        static constexpr const unsigned INPUT_WIDTH = 256;
+        static constexpr const unsigned OUTPUT_WIDTH = (INPUT_WIDTH + 2) / 3 * 7;
+
+        NtscFilter();
+
+        ~NtscFilter() = default;
+
+        void apply(const u8* input, unsigned firstRow, unsigned rowCount, u32* output) const;
+
+    private:
+        struct alignas(16) Color
+        {
+            float channels[4];
+        };
+
+        static constexpr const unsigned LINE_PHASES = 3;
+        static constexpr const unsigned ALIGNMENTS = 3;
+        static constexpr const unsigned KERNEL_WIDTH = 6;
+        static constexpr const unsigned ROW_PADDING = 2;
+        static constexpr const unsigned ROW_SIZE = ROW_PADDING + OUTPUT_WIDTH + KERNEL_WIDTH;
+
+        std::vector<Color> kernels;
+        std::array<int, ALIGNMENTS> kernelOffsets;
+
+        const Color* kernel(unsigned linePhase, unsigned alignment, unsigned entry) const;
+
+        void buildKernels();
+        void filterRow(const u8* input, unsigned linePhase, u32* output) const;
+};
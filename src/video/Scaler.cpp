@@ -0,0 +1,791 @@
+#include "Scaler.hpp"
+#include "../core/ThreadSupport.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+#endif
+
+namespace
+{
+    /**
+     * 4 pixels processed at once. Comparisons produce masks with all bits set in the lanes that matched.
+     */
+#if defined(__SSE2__)
+    using Pixels = __m128i;
+
+    Pixels load(const u32* source) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(source)); }
+    void store(u32* target, Pixels pixels) { _mm_storeu_si128(reinterpret_cast<__m128i*>(target), pixels); }
+    Pixels equal(Pixels a, Pixels b) { return _mm_cmpeq_epi32(a, b); }
+    Pixels notEqual(Pixels a, Pixels b) { return _mm_xor_si128(_mm_cmpeq_epi32(a, b), _mm_set1_epi32(-1)); }
+    Pixels both(Pixels a, Pixels b) { return _mm_and_si128(a, b); }
+    Pixels either(Pixels a, Pixels b) { return _mm_or_si128(a, b); }
+    Pixels select(Pixels mask, Pixels a, Pixels b) { return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b)); }
+    Pixels interleaveLow(Pixels a, Pixels b) { return _mm_unpacklo_epi32(a, b); }
+    Pixels interleaveHigh(Pixels a, Pixels b) { return _mm_unpackhi_epi32(a, b); }
+#elif defined(__wasm_simd128__)
+    using Pixels = v128_t;
+
+    Pixels load(const u32* source) { return wasm_v128_load(source); }
+    void store(u32* target, Pixels pixels) { wasm_v128_store(target, pixels); }
+    Pixels equal(Pixels a, Pixels b) { return wasm_i32x4_eq(a, b); }
+    Pixels notEqual(Pixels a, Pixels b) { return wasm_i32x4_ne(a, b); }
+    Pixels both(Pixels a, Pixels b) { return wasm_v128_and(a, b); }
+    Pixels either(Pixels a, Pixels b) { return wasm_v128_or(a, b); }
+    Pixels select(Pixels mask, Pixels a, Pixels b) { return wasm_v128_bitselect(a, b, mask); }
+    Pixels interleaveLow(Pixels a, Pixels b) { return wasm_i32x4_shuffle(a, b, 0, 4, 1, 5); }
+    Pixels interleaveHigh(Pixels a, Pixels b) { return wasm_i32x4_shuffle(a, b, 2, 6, 3, 7); }
+#else
+    struct Pixels
+    {
+        std::array<u32, 4> lanes;
+    };
+
+    template <typename Operation>
+    Pixels lanewise(Pixels a, Pixels b, Operation operation)
+    {
+        Pixels result;
+        for (unsigned i = 0; i < 4; i++) {
+            result.lanes[i] = operation(a.lanes[i], b.lanes[i]);
+        }
+        return result;
+    }
+
+    Pixels load(const u32* source) { Pixels pixels; std::copy_n(source, 4, pixels.lanes.begin()); return pixels; }
+    void store(u32* target, Pixels pixels) { std::copy_n(pixels.lanes.begin(), 4, target); }
+    Pixels equal(Pixels a, Pixels b) { return lanewise(a, b, [](u32 x, u32 y) { return x == y ? ~0u : 0u; }); }
+    Pixels notEqual(Pixels a, Pixels b) { return lanewise(a, b, [](u32 x, u32 y) { return x != y ? ~0u : 0u; }); }
+    Pixels both(Pixels a, Pixels b) { return lanewise(a, b, [](u32 x, u32 y) { return x & y; }); }
+    Pixels either(Pixels a, Pixels b) { return lanewise(a, b, [](u32 x, u32 y) { return x | y; }); }
+    Pixels select(Pixels mask, Pixels a, Pixels b) { return either(both(mask, a), lanewise(mask, b, [](u32 m, u32 y) { return ~m & y; })); }
+    Pixels interleaveLow(Pixels a, Pixels b) { return Pixels {{ a.lanes[0], b.lanes[0], a.lanes[1], b.lanes[1] }}; }
+    Pixels interleaveHigh(Pixels a, Pixels b) { return Pixels {{ a.lanes[2], b.lanes[2], a.lanes[3], b.lanes[3] }}; }
+#endif
+
+    // Single pixel variants, so that the same rules are used for the frame edges
+    u32 equal(u32 a, u32 b) { return a == b ? ~0u : 0u; }
+    u32 notEqual(u32 a, u32 b) { return a != b ? ~0u : 0u; }
+    u32 both(u32 a, u32 b) { return a & b; }
+    u32 either(u32 a, u32 b) { return a | b; }
+    u32 select(u32 mask, u32 a, u32 b) { return (mask & a) | (~mask & b); }
+
+    /**
+     * Scale2x rules. B, D, F and H are neighbours of E above, on the left, on the right and below.
+     * Outputs are E0 E1 in the upper row and E2 E3 in the lower one.
+     */
+    template <typename T>
+    void scale2xRules(T b, T d, T e, T f, T h, T& e0, T& e1, T& e2, T& e3)
+    {
+        const T edges = both(notEqual(b, h), notEqual(d, f));
+        e0 = select(both(edges, equal(d, b)), d, e);
+        e1 = select(both(edges, equal(b, f)), f, e);
+        e2 = select(both(edges, equal(d, h)), d, e);
+        e3 = select(both(edges, equal(h, f)), f, e);
+    }
+
+    /**
+     * Scale3x rules, for the 3x3 neighbourhood A B C / D E F / G H I.
+     * Outputs are E0 E1 E2 / E3 E4 E5 / E6 E7 E8.
+     */
+    template <typename T>
+    void scale3xRules(T a, T b, T c, T d, T e, T f, T g, T h, T i, T (&out)[9])
+    {
+        const T edges = both(notEqual(b, h), notEqual(d, f));
+        const T db = both(edges, equal(d, b));
+        const T bf = both(edges, equal(b, f));
+        const T dh = both(edges, equal(d, h));
+        const T hf = both(edges, equal(h, f));
+        out[0] = select(db, d, e);
+        out[1] = select(either(both(db, notEqual(e, c)), both(bf, notEqual(e, a))), b, e);
+        out[2] = select(bf, f, e);
+        out[3] = select(either(both(db, notEqual(e, g)), both(dh, notEqual(e, a))), d, e);
+        out[4] = e;
+        out[5] = select(either(both(bf, notEqual(e, i)), both(hf, notEqual(e, c))), f, e);
+        out[6] = select(dh, d, e);
+        out[7] = select(either(both(dh, notEqual(e, i)), both(hf, notEqual(e, g))), h, e);
+        out[8] = select(hf, f, e);
+    }
+
+    u32 toYuv(u32 color)
+    {
+        const int r = color & 0xFF;
+        const int g = (color >> 8) & 0xFF;
+        const int b = (color >> 16) & 0xFF;
+        const int y = (299 * r + 587 * g + 114 * b) / 1000;
+        const int u = (-169 * r - 331 * g + 500 * b) / 1000 + 128;
+        const int v = (500 * r - 419 * g - 81 * b) / 1000 + 128;
+        return static_cast<u32>(y << 16 | u << 8 | v);
+    }
+
+    /**
+     * Pixel of the xBR neighbourhood together with its color in YUV space.
+     */
+    struct Neighbour
+    {
+        u32 color;
+        u32 yuv;
+    };
+
+    /**
+     * Sum of absolute differences of Y, U and V.
+     */
+    u32 distance(u32 a, u32 b)
+    {
+        return std::abs(int(a >> 16) - int(b >> 16))
+            + std::abs(int((a >> 8) & 0xFF) - int((b >> 8) & 0xFF))
+            + std::abs(int(a & 0xFF) - int(b & 0xFF));
+    }
+
+    u32 add(u32 a, u32 b) { return a + b; }
+    u32 lessOrEqual(u32 a, u32 b) { return a <= b ? ~0u : 0u; }
+
+    /**
+     * Distances of 4 pairs of YUV colors at once, upper byte of YUV colors is always zero.
+     * Weights built from the distances stay far below 2^31, so they can be compared as signed.
+     */
+#if defined(__SSE2__)
+    Pixels add(Pixels a, Pixels b) { return _mm_add_epi32(a, b); }
+    Pixels lessOrEqual(Pixels a, Pixels b) { return _mm_xor_si128(_mm_cmpgt_epi32(a, b), _mm_set1_epi32(-1)); }
+
+    Pixels distance(Pixels a, Pixels b)
+    {
+        const auto difference = _mm_or_si128(_mm_subs_epu8(a, b), _mm_subs_epu8(b, a));
+        const auto mask = _mm_set1_epi32(0xFF);
+        return _mm_add_epi32(_mm_add_epi32(_mm_and_si128(difference, mask), _mm_and_si128(_mm_srli_epi32(difference, 8), mask)),
+            _mm_srli_epi32(difference, 16));
+    }
+#elif defined(__wasm_simd128__)
+    Pixels add(Pixels a, Pixels b) { return wasm_i32x4_add(a, b); }
+    Pixels lessOrEqual(Pixels a, Pixels b) { return wasm_i32x4_le(a, b); }
+
+    Pixels distance(Pixels a, Pixels b)
+    {
+        const auto difference = wasm_v128_or(wasm_u8x16_sub_sat(a, b), wasm_u8x16_sub_sat(b, a));
+        const auto mask = wasm_i32x4_splat(0xFF);
+        return wasm_i32x4_add(wasm_i32x4_add(wasm_v128_and(difference, mask), wasm_v128_and(wasm_u32x4_shr(difference, 8), mask)),
+            wasm_u32x4_shr(difference, 16));
+    }
+#else
+    Pixels add(Pixels a, Pixels b) { return lanewise(a, b, [](u32 x, u32 y) { return x + y; }); }
+    Pixels lessOrEqual(Pixels a, Pixels b) { return lanewise(a, b, [](u32 x, u32 y) { return x <= y ? ~0u : 0u; }); }
+    Pixels distance(Pixels a, Pixels b) { return lanewise(a, b, [](u32 x, u32 y) { return distance(x, y); }); }
+#endif
+
+    unsigned distance(const Neighbour& a, const Neighbour& b)
+    {
+        return distance(a.yuv, b.yuv);
+    }
+
+    bool similar(const Neighbour& a, const Neighbour& b)
+    {
+        return distance(a, b) < 155;
+    }
+
+    /**
+     * Blends weight/256 of the source color into the target, channel by channel.
+     */
+    void blend(u32& target, u32 source, unsigned weight)
+    {
+        u32 result = 0;
+        for (unsigned shift = 0; shift < 32; shift += 8) {
+            const unsigned t = (target >> shift) & 0xFF;
+            const unsigned s = (source >> shift) & 0xFF;
+            result |= ((s * weight + t * (256 - weight)) >> 8) << shift;
+        }
+        target = result;
+    }
+
+    /**
+     * Neighbourhood of the pixel E used by xBR:
+     *
+     *       A1 B1 C1
+     *    A0 PA PB PC C4
+     *    D0 PD PE PF F4
+     *    G0 PG PH PI I4
+     *       G5 H5 I5
+     */
+    enum XbrNeighbour : u8
+    {
+        A1, B1, C1,
+        A0, PA, PB, PC, C4,
+        D0, PD, PE, PF, F4,
+        G0, PG, PH, PI, I4,
+        G5, H5, I5,
+        XBR_NEIGHBOUR_COUNT
+    };
+
+    /**
+     * Position of each of the neighbours relative to E, as dx and dy.
+     */
+    const std::array<std::array<int, 2>, XBR_NEIGHBOUR_COUNT> XBR_OFFSETS = {{
+                  { -1, -2 }, { 0, -2 }, { 1, -2 },
+        { -2, -1 }, { -1, -1 }, { 0, -1 }, { 1, -1 }, { 2, -1 },
+        { -2,  0 }, { -1,  0 }, { 0,  0 }, { 1,  0 }, { 2,  0 },
+        { -2,  1 }, { -1,  1 }, { 0,  1 }, { 1,  1 }, { 2,  1 },
+                  { -1,  2 }, { 0,  2 }, { 1,  2 }
+    }};
+
+    /**
+     * Neighbours seen from each of the 4 corners, expressed as if it was the lower right corner:
+     * E, I, H, F, G, C, D, B, F4, I4, H5, I5, followed by the indices of output pixels N1, N2, N3.
+     * Outputs are indexed 0 1 / 2 3.
+     */
+    const std::array<std::array<u8, 15>, 4> XBR_CORNERS = {{
+        { PE, PI, PH, PF, PG, PC, PD, PB, F4, I4, H5, I5, 1, 2, 3 },
+        { PE, PC, PF, PB, PI, PA, PH, PD, B1, C1, F4, C4, 0, 3, 1 },
+        { PE, PA, PB, PD, PC, PG, PF, PH, D0, A0, B1, A1, 2, 1, 0 },
+        { PE, PG, PD, PH, PA, PI, PB, PF, H5, G5, D0, G0, 3, 0, 2 }
+    }};
+
+    /**
+     * Weighted distances along both of the diagonals of each corner, edge goes along the one that is smoother.
+     * Neighbours are given as YUV colors, either of a single pixel, or of 4 pixels at once.
+     */
+    template <typename T>
+    void xbrWeights(const T (&n)[XBR_NEIGHBOUR_COUNT], T (&edgeWeights)[4], T (&crossWeights)[4])
+    {
+        // Corners share the distances from E to the diagonal neighbours,
+        // and between the two neighbours of E next to each of the diagonal ones
+        T toCenter[XBR_NEIGHBOUR_COUNT];
+        T around[XBR_NEIGHBOUR_COUNT];
+        for (auto diagonal : { PA, PC, PG, PI }) {
+            toCenter[diagonal] = distance(n[PE], n[diagonal]);
+        }
+        around[PA] = distance(n[PB], n[PD]);
+        around[PC] = distance(n[PB], n[PF]);
+        around[PG] = distance(n[PD], n[PH]);
+        around[PI] = distance(n[PF], n[PH]);
+
+        for (unsigned k = 0; k < XBR_CORNERS.size(); k++) {
+            const auto& corner = XBR_CORNERS[k];
+            const auto i = corner[1];
+            const auto g = corner[4];
+            const auto c = corner[5];
+            const auto& h = n[corner[2]];
+            const auto& f = n[corner[3]];
+            const auto& f4 = n[corner[8]];
+            const auto& i4 = n[corner[9]];
+            const auto& h5 = n[corner[10]];
+            const auto& i5 = n[corner[11]];
+
+            const T hf = around[i];
+            const T ei = toCenter[i];
+            edgeWeights[k] = add(add(add(toCenter[c], toCenter[g]), add(distance(n[i], h5), distance(n[i], f4))),
+                add(add(hf, hf), add(hf, hf)));
+            crossWeights[k] = add(add(add(around[g], distance(h, i5)), add(distance(f, i4), around[c])),
+                add(add(ei, ei), add(ei, ei)));
+        }
+    }
+
+    /**
+     * Masks of the corners that are blended. Corner is blended when E differs from both of its neighbours
+     * next to the corner, and the edge doesn't cross the corner. Differences from E are given for B, D, F and H.
+     */
+    template <typename T>
+    void xbrBlends(const T (&differs)[XBR_NEIGHBOUR_COUNT], const T (&edgeWeights)[4], const T (&crossWeights)[4], T (&blends)[4])
+    {
+        for (unsigned k = 0; k < XBR_CORNERS.size(); k++) {
+            const auto& corner = XBR_CORNERS[k];
+            blends[k] = both(both(differs[corner[2]], differs[corner[3]]), lessOrEqual(edgeWeights[k], crossWeights[k]));
+        }
+    }
+
+    /**
+     * Blends the corner, only called for the corners that xbrBlends() selected.
+     */
+    void xbrCorner(const std::array<Neighbour, XBR_NEIGHBOUR_COUNT>& n, const std::array<u8, 15>& corner,
+        u32 edgeWeight, u32 crossWeight, std::array<u32, 4>& out)
+    {
+        const auto& e = n[corner[0]];
+        const auto& i = n[corner[1]];
+        const auto& h = n[corner[2]];
+        const auto& f = n[corner[3]];
+        const auto& g = n[corner[4]];
+        const auto& c = n[corner[5]];
+        const auto& d = n[corner[6]];
+        const auto& b = n[corner[7]];
+        const auto& i4 = n[corner[9]];
+        const auto& i5 = n[corner[11]];
+        auto& n1 = out[corner[12]];
+        auto& n2 = out[corner[13]];
+        auto& n3 = out[corner[14]];
+
+        const auto color = distance(e, f) <= distance(e, h) ? f.color : h.color;
+        if (edgeWeight < crossWeight
+            && ((!similar(f, b) && !similar(h, d)) || (similar(e, i) && !similar(f, i4) && !similar(h, i5))
+                || similar(e, g) || similar(e, c))) {
+            // Level 2 detects shallow and steep edges, which span over 2 pixels
+            const auto shallowWeight = distance(f, g);
+            const auto steepWeight = distance(h, c);
+            const bool shallow = 2 * shallowWeight <= steepWeight && e.color != g.color && d.color != g.color;
+            const bool steep = shallowWeight >= 2 * steepWeight && e.color != c.color && b.color != c.color;
+            if (shallow && steep) {
+                blend(n3, color, 224);
+                blend(n2, color, 64);
+                n1 = n2;
+            } else if (shallow) {
+                blend(n3, color, 192);
+                blend(n2, color, 64);
+            } else if (steep) {
+                blend(n3, color, 192);
+                blend(n1, color, 64);
+            } else {
+                blend(n3, color, 128);
+            }
+        } else {
+            blend(n3, color, 128);
+        }
+    }
+}
+
+Scaler::Scaler()
+    : Scaler(getDefaultThreadCount())
+{
+}
+
+/**
+ * Creates the scaler with the given amount of worker threads, with no threads frames are scaled by the caller alone.
+ */
+Scaler::Scaler(unsigned threadCount)
+    : filter(ScalerFilter::Nearest)
+    , factor(2)
+    , yuv()
+    , lastFrameTime(0.0)
+    , averageFrameTime(0.0)
+    , workers()
+    , mutex()
+    , workAvailable()
+    , workFinished()
+    , queuedBands()
+    , unfinishedBands(0)
+    , stopping(false)
+{
+    for (unsigned i = 0; i < threadCount; i++) {
+        workers.emplace_back([this]() {
+            work();
+        });
+    }
+}
+
+Scaler::~Scaler()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    workAvailable.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+/**
+ * Selects the filter. Factor is only used by nearest neighbour filter, other filters have fixed scale.
+ * Factor is clamped to 1..MAX_NEAREST_FACTOR, so that the output stays of a reasonable size.
+ * Returns false and keeps the current filter when the filter is not known.
+ */
+bool Scaler::setFilter(ScalerFilter filter, unsigned nearestFactor)
+{
+    using enum ScalerFilter;
+    switch (filter) {
+        case Nearest:
+            factor = std::clamp(nearestFactor, 1u, MAX_NEAREST_FACTOR);
+            break;
+        case Scale2x:
+        case Xbr2x:
+            factor = 2;
+            break;
+        case Scale3x:
+            factor = 3;
+            break;
+        default:
+            return false;
+    }
+    this->filter = filter;
+    return true;
+}
+
+ScalerFilter Scaler::getFilter() const
+{
+    return filter;
+}
+
+/**
+ * Amount of times output is larger than the input in each direction.
+ */
+unsigned Scaler::getFactor() const
+{
+    return factor;
+}
+
+/**
+ * Amount of neighbouring rows above and below, that the output row depends on.
+ * When only some of the input rows change, that many rows around them have to be scaled again.
+ */
+unsigned Scaler::getMargin() const
+{
+    using enum ScalerFilter;
+    switch (filter) {
+        case Scale2x:
+        case Scale3x:
+            return 1;
+        case Xbr2x:
+            return 2;
+        default:
+            return 0;
+    }
+}
+
+void Scaler::scale(const u32* input, unsigned width, unsigned height, u32* output)
+{
+    scale(input, width, height, 0, height, output);
+}
+
+/**
+ * Scales given rows of the input frame. Output has the size of whole scaled frame,
+ * rows outside of the given range are left untouched.
+ * Rows are split into bands, the last one is scaled by the calling thread while the workers scale the others.
+ */
+void Scaler::scale(const u32* input, unsigned width, unsigned height, unsigned firstRow, unsigned rowCount, u32* output)
+{
+    const auto start = std::chrono::steady_clock::now();
+    firstRow = std::min(firstRow, height);
+    const auto lastRow = std::min(height, firstRow + rowCount);
+
+    if (filter == ScalerFilter::Xbr2x) {
+        // Colors are converted to YUV once, as every pixel is compared with its neighbours many times
+        yuv.resize(width * height);
+        const auto first = firstRow > 2 ? firstRow - 2 : 0;
+        const auto last = std::min(height, lastRow + 2);
+        std::transform(input + first * width, input + last * width, yuv.data() + first * width, toYuv);
+    }
+    const auto bandCount = std::clamp((lastRow - firstRow) / MIN_BAND_HEIGHT, 1u, getThreadCount() + 1);
+    const auto bandHeight = (lastRow - firstRow + bandCount - 1) / bandCount;
+    if (bandCount > 1) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (unsigned i = 0; i + 1 < bandCount; i++) {
+                const auto bandRow = firstRow + i * bandHeight;
+                queuedBands.push_back(Band { input, width, height, bandRow, bandRow + bandHeight, output });
+            }
+            unfinishedBands += bandCount - 1;
+        }
+        workAvailable.notify_all();
+    }
+    scaleRows(Band { input, width, height, firstRow + (bandCount - 1) * bandHeight, lastRow, output });
+    if (bandCount > 1) {
+        std::unique_lock<std::mutex> lock(mutex);
+        workFinished.wait(lock, [this]() {
+            return unfinishedBands == 0;
+        });
+    }
+
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    lastFrameTime = elapsed.count();
+    averageFrameTime = averageFrameTime == 0.0
+        ? lastFrameTime
+        : averageFrameTime + (lastFrameTime - averageFrameTime) * AVERAGE_WEIGHT;
+}
+
+/**
+ * Time in milliseconds that scaling of the last frame took.
+ */
+double Scaler::getLastFrameTime() const
+{
+    return lastFrameTime;
+}
+
+/**
+ * Exponential moving average of the time in milliseconds that scaling of a frame takes.
+ */
+double Scaler::getAverageFrameTime() const
+{
+    return averageFrameTime;
+}
+
+unsigned Scaler::getThreadCount() const
+{
+    return static_cast<unsigned>(workers.size());
+}
+
+/**
+ * Amount of workers worth having on this host. Calling thread scales a band as well,
+ * so without threads or spare cores frames are scaled by the caller alone.
+ */
+unsigned Scaler::getDefaultThreadCount()
+{
+    if (!WASM_NES_THREADS) {
+        return 0;
+    }
+    const unsigned hardwareThreads = std::thread::hardware_concurrency();
+    return std::min(MAX_THREAD_COUNT, hardwareThreads > 1 ? hardwareThreads - 1 : 0);
+}
+
+/**
+ * Loop of the worker thread, scales bands as they are handed over, until the scaler is destroyed.
+ */
+void Scaler::work()
+{
+    while (true) {
+        Band band;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            workAvailable.wait(lock, [this]() {
+                return stopping || !queuedBands.empty();
+            });
+            if (queuedBands.empty()) {
+                return;
+            }
+            band = queuedBands.front();
+            queuedBands.pop_front();
+        }
+        scaleRows(band);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            unfinishedBands--;
+        }
+        workFinished.notify_all();
+    }
+}
+
+void Scaler::scaleRows(const Band& band) const
+{
+    const auto [input, width, height, firstRow, lastRow, output] = band;
+    for (unsigned y = firstRow; y < lastRow; y++) {
+        auto* target = output + y * factor * width * factor;
+        using enum ScalerFilter;
+        switch (filter) {
+            case Nearest:
+                nearest(input, width, y, target);
+                break;
+            case Scale2x:
+                scale2x(input, width, height, y, target);
+                break;
+            case Scale3x:
+                scale3x(input, width, height, y, target);
+                break;
+            case Xbr2x:
+                xbr2x(input, width, height, y, target);
+                break;
+        }
+    }
+}
+
+void Scaler::nearest(const u32* input, unsigned width, unsigned y, u32* output) const
+{
+    const auto* row = input + y * width;
+    const auto outputWidth = width * factor;
+    unsigned x = 0;
+    if (factor == 2) {
+        for (; x + 4 <= width; x += 4) {
+            auto pixels = load(row + x);
+            store(output + 2 * x, interleaveLow(pixels, pixels));
+            store(output + 2 * x + 4, interleaveHigh(pixels, pixels));
+        }
+    }
+    for (; x < width; x++) {
+        std::fill_n(output + x * factor, factor, row[x]);
+    }
+    // Remaining rows are the copies of the first one
+    for (unsigned i = 1; i < factor; i++) {
+        std::copy_n(output, outputWidth, output + i * outputWidth);
+    }
+}
+
+void Scaler::scale2x(const u32* input, unsigned width, unsigned height, unsigned y, u32* output) const
+{
+    const auto* row = input + y * width;
+    const auto* above = y > 0 ? row - width : row;
+    const auto* below = y + 1 < height ? row + width : row;
+    auto* upper = output;
+    auto* lower = output + 2 * width;
+
+    auto scalePixel = [&](unsigned x) {
+        const auto left = x > 0 ? x - 1 : x;
+        const auto right = x + 1 < width ? x + 1 : x;
+        u32 e0, e1, e2, e3;
+        scale2xRules(above[x], row[left], row[x], row[right], below[x], e0, e1, e2, e3);
+        upper[2 * x] = e0;
+        upper[2 * x + 1] = e1;
+        lower[2 * x] = e2;
+        lower[2 * x + 1] = e3;
+    };
+
+    // Pixels on the edges don't have neighbours on both sides, so they are handled one by one
+    scalePixel(0);
+    unsigned x = 1;
+    for (; x + 5 <= width; x += 4) {
+        Pixels e0, e1, e2, e3;
+        scale2xRules(load(above + x), load(row + x - 1), load(row + x), load(row + x + 1), load(below + x), e0, e1, e2, e3);
+        store(upper + 2 * x, interleaveLow(e0, e1));
+        store(upper + 2 * x + 4, interleaveHigh(e0, e1));
+        store(lower + 2 * x, interleaveLow(e2, e3));
+        store(lower + 2 * x + 4, interleaveHigh(e2, e3));
+    }
+    for (; x < width; x++) {
+        scalePixel(x);
+    }
+}
+
+void Scaler::scale3x(const u32* input, unsigned width, unsigned height, unsigned y, u32* output) const
+{
+    const auto* row = input + y * width;
+    const auto* above = y > 0 ? row - width : row;
+    const auto* below = y + 1 < height ? row + width : row;
+    std::array<u32*, 3> targets = { output, output + 3 * width, output + 6 * width };
+
+    auto scalePixel = [&](unsigned x) {
+        const auto left = x > 0 ? x - 1 : x;
+        const auto right = x + 1 < width ? x + 1 : x;
+        u32 out[9];
+        scale3xRules(above[left], above[x], above[right], row[left], row[x], row[right],
+            below[left], below[x], below[right], out);
+        for (unsigned i = 0; i < 9; i++) {
+            targets[i / 3][3 * x + i % 3] = out[i];
+        }
+    };
+
+    scalePixel(0);
+    unsigned x = 1;
+    for (; x + 5 <= width; x += 4) {
+        Pixels out[9];
+        scale3xRules(load(above + x - 1), load(above + x), load(above + x + 1),
+            load(row + x - 1), load(row + x), load(row + x + 1),
+            load(below + x - 1), load(below + x), load(below + x + 1), out);
+        // Outputs of 4 pixels are computed at once, but they have to be interleaved by 3
+        std::array<std::array<u32, 4>, 9> lanes;
+        for (unsigned i = 0; i < 9; i++) {
+            store(lanes[i].data(), out[i]);
+        }
+        for (unsigned lane = 0; lane < 4; lane++) {
+            for (unsigned i = 0; i < 9; i++) {
+                targets[i / 3][3 * (x + lane) + i % 3] = lanes[i][lane];
+            }
+        }
+    }
+    for (; x < width; x++) {
+        scalePixel(x);
+    }
+}
+
+void Scaler::xbr2x(const u32* input, unsigned width, unsigned height, unsigned y, u32* output) const
+{
+    // Values of the corners in each of the lanes they were computed in
+    using Corners = std::array<std::array<u32, 4>, 4>;
+
+    // Rows from 2 above to 2 below the current one, edges are extended
+    std::array<const u32*, 5> colorRows;
+    std::array<const u32*, 5> yuvRows;
+    for (int dy = -2; dy <= 2; dy++) {
+        const auto line = static_cast<unsigned>(std::clamp(int(y) + dy, 0, int(height) - 1));
+        colorRows[dy + 2] = input + line * width;
+        yuvRows[dy + 2] = yuv.data() + line * width;
+    }
+
+    auto neighbourhood = [&](unsigned x) {
+        std::array<Neighbour, XBR_NEIGHBOUR_COUNT> n;
+        for (unsigned i = 0; i < XBR_NEIGHBOUR_COUNT; i++) {
+            const auto column = std::clamp(int(x) + XBR_OFFSETS[i][0], 0, int(width) - 1);
+            const auto row = XBR_OFFSETS[i][1] + 2;
+            n[i] = Neighbour { colorRows[row][column], yuvRows[row][column] };
+        }
+        return n;
+    };
+
+    auto copyPixel = [&](unsigned x) {
+        const auto color = colorRows[2][x];
+        std::fill_n(output + 2 * x, 2, color);
+        std::fill_n(output + 2 * width + 2 * x, 2, color);
+    };
+
+    auto scalePixel = [&](unsigned x, const Corners& edgeWeights, const Corners& crossWeights, const Corners& blends, unsigned lane) {
+        const auto n = neighbourhood(x);
+        std::array<u32, 4> out;
+        out.fill(n[PE].color);
+        for (unsigned corner = 0; corner < XBR_CORNERS.size(); corner++) {
+            if (blends[corner][lane]) {
+                xbrCorner(n, XBR_CORNERS[corner], edgeWeights[corner][lane], crossWeights[corner][lane], out);
+            }
+        }
+        output[2 * x] = out[0];
+        output[2 * x + 1] = out[1];
+        output[2 * width + 2 * x] = out[2];
+        output[2 * width + 2 * x + 1] = out[3];
+    };
+
+    // Pixels close to the edges see the extended edge, so they are processed one by one
+    auto scaleEdgePixel = [&](unsigned x) {
+        const auto n = neighbourhood(x);
+        u32 colors[XBR_NEIGHBOUR_COUNT];
+        u32 differs[XBR_NEIGHBOUR_COUNT];
+        for (unsigned i = 0; i < XBR_NEIGHBOUR_COUNT; i++) {
+            colors[i] = n[i].yuv;
+            differs[i] = notEqual(n[PE].color, n[i].color);
+        }
+        u32 edgeWeight[4], crossWeight[4], blend[4];
+        xbrWeights(colors, edgeWeight, crossWeight);
+        xbrBlends(differs, edgeWeight, crossWeight, blend);
+        Corners edgeWeights, crossWeights, blends;
+        for (unsigned corner = 0; corner < XBR_CORNERS.size(); corner++) {
+            edgeWeights[corner][0] = edgeWeight[corner];
+            crossWeights[corner][0] = crossWeight[corner];
+            blends[corner][0] = blend[corner];
+        }
+        scalePixel(x, edgeWeights, crossWeights, blends, 0);
+    };
+
+    unsigned x = 0;
+    for (; x < std::min(2u, width); x++) {
+        scaleEdgePixel(x);
+    }
+    // Weights and the choice of the corners that are blended take most of the comparisons,
+    // they are done for 4 pixels at once. Only the blending itself is left for each of the pixels.
+    for (; x + 6 <= width; x += 4) {
+        const auto e = load(colorRows[2] + x);
+        Pixels differs[XBR_NEIGHBOUR_COUNT];
+        differs[PB] = notEqual(e, load(colorRows[1] + x));
+        differs[PD] = notEqual(e, load(colorRows[2] + x - 1));
+        differs[PF] = notEqual(e, load(colorRows[2] + x + 1));
+        differs[PH] = notEqual(e, load(colorRows[3] + x));
+        // Flat areas are common, there E matches one of the neighbours next to each of the corners
+        std::array<u32, 4> candidates;
+        store(candidates.data(), either(either(both(differs[PH], differs[PF]), both(differs[PF], differs[PB])),
+            either(both(differs[PB], differs[PD]), both(differs[PD], differs[PH]))));
+        if (std::all_of(candidates.begin(), candidates.end(), [](u32 mask) { return mask == 0; })) {
+            store(output + 2 * x, interleaveLow(e, e));
+            store(output + 2 * x + 4, interleaveHigh(e, e));
+            store(output + 2 * width + 2 * x, interleaveLow(e, e));
+            store(output + 2 * width + 2 * x + 4, interleaveHigh(e, e));
+            continue;
+        }
+        Pixels colors[XBR_NEIGHBOUR_COUNT];
+        for (unsigned i = 0; i < XBR_NEIGHBOUR_COUNT; i++) {
+            colors[i] = load(yuvRows[XBR_OFFSETS[i][1] + 2] + x + XBR_OFFSETS[i][0]);
+        }
+        Pixels edgeWeight[4], crossWeight[4], blend[4];
+        xbrWeights(colors, edgeWeight, crossWeight);
+        xbrBlends(differs, edgeWeight, crossWeight, blend);
+        Corners edgeWeights, crossWeights, blends;
+        for (unsigned corner = 0; corner < XBR_CORNERS.size(); corner++) {
+            store(edgeWeights[corner].data(), edgeWeight[corner]);
+            store(crossWeights[corner].data(), crossWeight[corner]);
+            store(blends[corner].data(), blend[corner]);
+        }
+        for (unsigned lane = 0; lane < 4; lane++) {
+            if (blends[0][lane] | blends[1][lane] | blends[2][lane] | blends[3][lane]) {
+                scalePixel(x + lane, edgeWeights, crossWeights, blends, lane);
+            } else {
+                copyPixel(x + lane);
+            }
+        }
+    }
+    for (; x < width; x++) {
+        scaleEdgePixel(x);
+    }
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../core/Types.hpp"
+#include "ScalerFilter.hpp"
+
+/**
+ * Software upscaler of RGBA frames, which doesn't depend on a GPU.
+ * Used when the output has to be produced at higher resolution than the emulated picture,
+ * for example for recording or streaming.
+ *
+ * Rows of the frame are split into horizontal bands, that are scaled by a small pool of worker threads
+ * together with the calling thread. Without threads (wasm build without pthreads) whole frame is scaled
+ * by the calling thread.
+ *
+ * Time taken by each frame is measured, so that the filter that fits the frame budget can be chosen.
+ */
+class Scaler
+{
+    public:
+        static constexpr const unsigned MAX_NEAREST_FACTOR = 4;
+        static constexpr const unsigned MAX_THREAD_COUNT = 3;
+        // Bands are never shorter, so that a few dirty rows are scaled without waking up the workers
+        static constexpr const unsigned MIN_BAND_HEIGHT = 16;
+
+        Scaler();
+
+        explicit Scaler(unsigned threadCount);
+
+        ~Scaler();
+
+        bool setFilter(ScalerFilter filter, unsigned nearestFactor = 2);
+
+        ScalerFilter getFilter() const;
+
+        unsigned getFactor() const;
+
+        unsigned getMargin() const;
+
+        void scale(const u32* input, unsigned width, unsigned height, u32* output);
+
+        void scale(const u32* input, unsigned width, unsigned height, unsigned firstRow, unsigned rowCount, u32* output);
+
+        double getLastFrameTime() const;
+
+        double getAverageFrameTime() const;
+
+        unsigned getThreadCount() const;
+
+        static unsigned getDefaultThreadCount();
+
+    private:
+        struct Band
+        {
+            const u32* input;
+            unsigned width;
+            unsigned height;
+            unsigned firstRow;
+            unsigned lastRow;
+            u32* output;
+        };
+
+        ScalerFilter filter;
+        unsigned factor;
+        std::vector<u32> yuv;
+        double lastFrameTime;
+        double averageFrameTime;
+
+        std::vector<std::thread> workers;
+        std::mutex mutex;
+        std::condition_variable workAvailable;
+        std::condition_variable workFinished;
+        std::deque<Band> queuedBands;
+        unsigned unfinishedBands;
+        bool stopping;
+
+        void work();
+        void scaleRows(const Band& band) const;
+        void nearest(const u32* input, unsigned width, unsigned y, u32* output) const;
+        void scale2x(const u32* input, unsigned width, unsigned height, unsigned y, u32* output) const;
+        void scale3x(const u32* input, unsigned width, unsigned height, unsigned y, u32* output) const;
+        void xbr2x(const u32* input, unsigned width, unsigned height, unsigned y, u32* output) const;
+
+        static constexpr const double AVERAGE_WEIGHT = 0.05;
+};
@@ -0,0 +1,17 @@
+#pragma once
+
+/**
+ * Upscaling filter applied to RGBA frames by the software scaler.
+ */
+enum class ScalerFilter
+{
+    // Every pixel is repeated N times in both directions.
+    Nearest,
+    // EPX/AdvMAME2x. Smooths diagonal edges by copying neighbouring pixels, output is 2x larger.
+    Scale2x,
+    // AdvMAME3x. Same as Scale2x but output is 3x larger.
+    Scale3x,
+    // xBR level 2 by Hyllian. Detects edges using distance between colors in YUV space
+    // and blends pixels along them. Output is 2x larger.
+    Xbr2x
+};
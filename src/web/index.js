@@ -29,6 +29,18 @@ async function runRom(e) {
     await Module.ccall('loadRom', null, ['string'], [memFsFilename], { async: true });
 }
 
+/**
+ * Video filters
+ */
+function toggleNtscFilter(event) {
+    Module.ccall('setNtscFilter', null, ['number'], [event.target.checked ? 1 : 0]);
+}
+
+function changeScaler(event) {
+    const [filter, factor] = event.target.value.split(',').map(Number);
+    Module.ccall('setScaler', null, ['number', 'number'], [filter, factor]);
+}
+
 /**
  * Module
  */
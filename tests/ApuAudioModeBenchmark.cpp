@@ -0,0 +1,183 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <fstream>
+#include <random>
+#include <vector>
+
+#include "util/SystemUnderTest.hpp"
+
+/**
+ * Compares how long it takes to emulate the APU with and without audio.
+ * Behaviour visible to the CPU has to be the same in both modes, which is checked on short runs.
+ * Longer runs measure the time, they are disabled and run with --gtest_also_run_disabled_tests.
+ * Times are reported as test properties.
+ */
+class ApuAudioModeBenchmark : public ::testing::Test
+{
+    protected:
+        // NTSC frame lasts 341 * 262 - 0.5 PPU dots, 3 of them per CPU cycle
+        static constexpr const double CPU_CYCLES_PER_FRAME = 29780.5;
+
+        /**
+         * What the CPU could observe: cycles at which the IRQ line got asserted, DMC fetches and the status register reads.
+         */
+        struct Trace
+        {
+            std::vector<u64> irqCycles;
+            std::vector<u64> stallCycles;
+            std::vector<u8> status;
+
+            bool operator==(const Trace&) const = default;
+        };
+
+        ApuAudioModeBenchmark() = default;
+
+        ~ApuAudioModeBenchmark() = default;
+
+        /**
+         * Drives APU alone with random register writes, every channel is playing most of the time.
+         * When toggled, audio is switched on or off at random cycles, independent of the writes.
+         */
+        double runApu(bool audioEnabled, unsigned seconds, Trace& trace, bool audioToggled = false)
+        {
+            u64 cycle = 0;
+            Apu apu;
+            apu.setMemoryReader([](u16 addr) { return static_cast<u8>(addr * 37); });
+            apu.setAudioEnabled(audioEnabled);
+            std::vector<float> samples(Apu::DEFAULT_SAMPLE_RATE);
+            std::mt19937 random(1234);
+            std::mt19937 toggleRandom(5678);
+            auto nextToggle = toggleRandom() % 20000;
+
+            auto start = std::chrono::steady_clock::now();
+            apu.write(0x15, 0x1F);
+            while (cycle < u64(seconds) * Apu::CPU_CLOCK_RATE) {
+                for (auto cycles = random() % 3000; cycles > 0; cycles--) {
+                    cycle++;
+                    apu.tick();
+                    if (audioToggled && cycle == nextToggle) {
+                        apu.setAudioEnabled(!apu.isAudioEnabled());
+                        nextToggle += 1 + toggleRandom() % 20000;
+                    }
+                    if (apu.takeDmcStallCycles() > 0) {
+                        trace.stallCycles.push_back(cycle);
+                    }
+                    if (apu.getIrqCycle() == cycle) {
+                        trace.irqCycles.push_back(cycle);
+                    }
+                }
+                const auto value = static_cast<u8>(random());
+                const auto addr = static_cast<u8>(random() % 0x18);
+                if (addr == 0x15) {
+                    trace.status.push_back(apu.read());
+                    apu.write(addr, value | 0x10);
+                } else if (addr != 0x14 && addr != 0x16) {
+                    apu.write(addr, addr == 0x17 ? value & 0xC0 : value);
+                }
+                apu.getAudioBuffer().read(samples.data(), apu.getAudioBuffer().getSize());
+            }
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            return elapsed.count();
+        }
+
+        /**
+         * Runs the rom on the whole system. Returns the time and the state of the CPU memory at the end.
+         */
+        double runRom(const std::string& romFileName, bool audioEnabled, unsigned frames, std::vector<u8>& memory)
+        {
+            SystemUnderTest systemUnderTest;
+            systemUnderTest.getPpu()->setRenderMode(PpuRenderMode::TimingOnly);
+            systemUnderTest.getApu()->setAudioEnabled(audioEnabled);
+            EXPECT_TRUE(systemUnderTest.getCartridge()->loadFromFile(std::ifstream(romFileName, std::ios::binary)));
+            auto cpu = systemUnderTest.getCpu();
+            auto& audioBuffer = systemUnderTest.getApu()->getAudioBuffer();
+            std::vector<float> samples(Apu::DEFAULT_SAMPLE_RATE);
+
+            auto start = std::chrono::steady_clock::now();
+            cpu->reset();
+            for (u64 cycles = 0; cycles < frames * CPU_CYCLES_PER_FRAME;) {
+                cycles += cpu->step();
+                audioBuffer.read(samples.data(), audioBuffer.getSize());
+            }
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+            memory.clear();
+            for (u32 addr = 0; addr < 0x800; addr++) {
+                memory.push_back(systemUnderTest.getMmu()->readFromMemory(addr));
+            }
+            return elapsed.count();
+        }
+
+        void report(const std::string& name, double audioOn, double audioOff)
+        {
+            RecordProperty(name + "AudioOnMs", std::to_string(audioOn));
+            RecordProperty(name + "AudioOffMs", std::to_string(audioOff));
+        }
+
+        void compareApu(unsigned seconds)
+        {
+            Trace audioOnTrace;
+            Trace audioOffTrace;
+            const auto audioOn = runApu(true, seconds, audioOnTrace);
+            const auto audioOff = runApu(false, seconds, audioOffTrace);
+            EXPECT_FALSE(audioOnTrace.irqCycles.empty());
+            EXPECT_FALSE(audioOnTrace.stallCycles.empty());
+            EXPECT_TRUE(audioOnTrace == audioOffTrace);
+            report("Apu", audioOn, audioOff);
+        }
+
+        void compareRoms(unsigned frames)
+        {
+            double audioOn = 0.0;
+            double audioOff = 0.0;
+            for (const auto* romFileName : {
+                "resources/cpu_interrupts_v2/cli_latency.nes",
+                "resources/cpu_interrupts_v2/irq_and_dma.nes",
+                "resources/ppu_sprite_hit/timing_basics.nes"
+            }) {
+                std::vector<u8> audioOnMemory;
+                std::vector<u8> audioOffMemory;
+                audioOn += runRom(romFileName, true, frames, audioOnMemory);
+                audioOff += runRom(romFileName, false, frames, audioOffMemory);
+                EXPECT_EQ(audioOnMemory, audioOffMemory) << romFileName;
+            }
+            report("Roms", audioOn, audioOff);
+        }
+};
+
+TEST_F(ApuAudioModeBenchmark, Apu)
+{
+    compareApu(2);
+}
+
+/**
+ * Switching the audio on or off in the middle of the emulation doesn't change the behaviour either.
+ */
+TEST_F(ApuAudioModeBenchmark, ApuAudioToggled)
+{
+    Trace audioOnTrace;
+    Trace toggledTrace;
+    runApu(true, 2, audioOnTrace);
+    runApu(true, 2, toggledTrace, true);
+    EXPECT_FALSE(audioOnTrace.irqCycles.empty());
+    EXPECT_FALSE(audioOnTrace.stallCycles.empty());
+    EXPECT_EQ(audioOnTrace.irqCycles, toggledTrace.irqCycles);
+    EXPECT_EQ(audioOnTrace.stallCycles, toggledTrace.stallCycles);
+    EXPECT_EQ(audioOnTrace.status, toggledTrace.status);
+}
+
+TEST_F(ApuAudioModeBenchmark, Roms)
+{
+    compareRoms(60);
+}
+
+TEST_F(ApuAudioModeBenchmark, DISABLED_ApuLong)
+{
+    compareApu(20);
+}
+
+TEST_F(ApuAudioModeBenchmark, DISABLED_RomsLong)
+{
+    compareRoms(240);
+}
@@ -0,0 +1,137 @@
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#include "util/AudioRomTest.hpp"
+#include "../src/core/apu/FileAudioSink.hpp"
+
+/**
+ * Regression tests of the APU output. Test roms beep when they finish, some of them also use frame or DMC interrupts.
+ * Fingerprints were taken from the output considered correct, they have to be updated whenever the output
+ * changes intentionally. Set AUDIO_DUMP_DIRECTORY to listen to the rendered audio.
+ */
+class ApuAudioTest : public AudioRomTest
+{
+    protected:
+        // Relative, libm of the native and of the Emscripten builds differ in the last bits
+        static constexpr const double RMS_TOLERANCE = 1e-4;
+
+        ApuAudioTest() = default;
+
+        ~ApuAudioTest() = default;
+
+        void SetUp() override
+        {
+            AudioRomTest::SetUp();
+        }
+
+        void TearDown() override
+        {
+            AudioRomTest::TearDown();
+        }
+
+        void expectFingerprint(const AudioFingerprint& expected, const AudioFingerprint& actual)
+        {
+            EXPECT_EQ(expected.sampleCount, actual.sampleCount);
+            EXPECT_NEAR(expected.rms, actual.rms, expected.rms * RMS_TOLERANCE);
+            EXPECT_NEAR(expected.differenceRms, actual.differenceRms, expected.differenceRms * RMS_TOLERANCE);
+            ASSERT_EQ(expected.envelope.size(), actual.envelope.size());
+            // Quiet blocks are compared with the tolerance of the whole, not with their own
+            for (unsigned block = 0; block < expected.envelope.size(); block++) {
+                EXPECT_NEAR(expected.envelope[block], actual.envelope[block], expected.rms * RMS_TOLERANCE) << "block " << block;
+            }
+        }
+
+        std::vector<u8> readFile(const std::filesystem::path& path)
+        {
+            std::ifstream file(path, std::ios::binary);
+            return std::vector<u8>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+
+        u32 readLittleEndian(const std::vector<u8>& data, unsigned offset, unsigned size)
+        {
+            u32 value = 0;
+            for (unsigned i = 0; i < size; i++) {
+                value |= data[offset + i] << (i * 8);
+            }
+            return value;
+        }
+};
+
+TEST_F(ApuAudioTest, CliLatency)
+{
+    const auto fingerprint = render("resources/cpu_interrupts_v2/cli_latency.nes", 90);
+    expectFingerprint(AudioFingerprint { .sampleCount = 65962, .rms = 0.015861598, .differenceRms = 0.002637221,
+        .envelope = { 0.022504474, 0.000005215 } }, fingerprint);
+}
+
+TEST_F(ApuAudioTest, IrqAndDma)
+{
+    const auto fingerprint = render("resources/cpu_interrupts_v2/irq_and_dma.nes", 120);
+    expectFingerprint(AudioFingerprint { .sampleCount = 88011, .rms = 0.015737128, .differenceRms = 0.003753064,
+        .envelope = { 0.018719459, 0.016600524 } }, fingerprint);
+}
+
+TEST_F(ApuAudioTest, SpriteHitTimingBasics)
+{
+    const auto fingerprint = render("resources/ppu_sprite_hit/timing_basics.nes", 240);
+    expectFingerprint(AudioFingerprint { .sampleCount = 176023, .rms = 0.018791113, .differenceRms = 0.006346324,
+        .envelope = { 0.018719459, 0.004865064, 0.023106543, 0.022656795, 0.021805574 } }, fingerprint);
+}
+
+TEST_F(ApuAudioTest, NativeRateMatchesBandLimited)
+{
+    // Both syntheses filter the same waveform, they only differ in the latency and in the residue of their filters
+    const auto bandLimited = render("resources/cpu_interrupts_v2/cli_latency.nes", 90);
+    SetUp();
+    systemUnderTest->getApu()->setSynthesisMode(ApuSynthesisMode::NativeRate);
+    const auto nativeRate = render("resources/cpu_interrupts_v2/cli_latency.nes", 90);
+    EXPECT_NEAR(bandLimited.sampleCount, nativeRate.sampleCount, Decimator::BLOCK_SIZE / 16);
+    EXPECT_NEAR(bandLimited.rms, nativeRate.rms, bandLimited.rms * 0.01);
+    EXPECT_GT(systemUnderTest->getApu()->getDecimator().getAverageBlockTime(), 0.0);
+}
+
+TEST_F(ApuAudioTest, WavFile)
+{
+    const auto path = std::filesystem::temp_directory_path() / "wasm_nes_apu_audio_test.wav";
+    const std::vector<float> samples = { 0.0f, 0.5f, -0.5f, 1.0f, -1.0f, 2.0f };
+    {
+        FileAudioSink sink(path.string(), AudioFileFormat::Wav, 44100);
+        ASSERT_TRUE(sink.isOpen());
+        sink.write(samples.data(), samples.size());
+        sink.write(samples.data(), 2);
+        EXPECT_EQ(8, sink.getSampleCount());
+    }
+    const auto data = readFile(path);
+    std::filesystem::remove(path);
+    ASSERT_EQ(44 + 8 * 2, data.size());
+    EXPECT_EQ("RIFF", std::string(data.begin(), data.begin() + 4));
+    EXPECT_EQ(36 + 8 * 2, readLittleEndian(data, 4, 4));
+    EXPECT_EQ("WAVEfmt ", std::string(data.begin() + 8, data.begin() + 16));
+    EXPECT_EQ(1, readLittleEndian(data, 22, 2));
+    EXPECT_EQ(44100, readLittleEndian(data, 24, 4));
+    EXPECT_EQ(16, readLittleEndian(data, 34, 2));
+    EXPECT_EQ("data", std::string(data.begin() + 36, data.begin() + 40));
+    EXPECT_EQ(8 * 2, readLittleEndian(data, 40, 4));
+    // Samples are clamped and scaled to 16 bits
+    EXPECT_EQ(0x3FFF + 1, readLittleEndian(data, 46, 2));
+    EXPECT_EQ(0x7FFF, readLittleEndian(data, 50, 2));
+    EXPECT_EQ(0x8001, readLittleEndian(data, 52, 2));
+    EXPECT_EQ(0x7FFF, readLittleEndian(data, 54, 2));
+}
+
+TEST_F(ApuAudioTest, RawFile)
+{
+    const auto path = std::filesystem::temp_directory_path() / "wasm_nes_apu_audio_test.raw";
+    const std::vector<float> samples(3000, 0.25f);
+    {
+        FileAudioSink sink(path.string(), AudioFileFormat::Raw, 44100);
+        ASSERT_TRUE(sink.isOpen());
+        sink.write(samples.data(), samples.size());
+    }
+    const auto data = readFile(path);
+    std::filesystem::remove(path);
+    ASSERT_EQ(3000 * 2, data.size());
+    EXPECT_EQ(8192, readLittleEndian(data, 0, 2));
+    EXPECT_EQ(8192, readLittleEndian(data, data.size() - 2, 2));
+}
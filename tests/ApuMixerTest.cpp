@@ -0,0 +1,76 @@
+#include <gtest/gtest.h>
+
+#include "../src/core/apu/ApuMixer.hpp"
+
+/**
+ * Compares the mixer against the formulas approximating the nonlinear DAC of the NES.
+ */
+class ApuMixerTest : public ::testing::Test
+{
+    protected:
+        static constexpr const float PULSE_TOLERANCE = 0.002f;
+        static constexpr const float TND_TOLERANCE = 0.015f;
+        // Linear mode only matches the formulas when a single channel plays
+        static constexpr const float LINEAR_TOLERANCE = 0.03f;
+        // DMC has the widest range of levels, so the curve of the DAC bends the most over it
+        static constexpr const float LINEAR_DMC_TOLERANCE = 0.075f;
+
+        ApuMixerTest() = default;
+
+        ~ApuMixerTest() = default;
+
+        ApuMixer mixer;
+};
+
+TEST_F(ApuMixerTest, SilenceIsZero)
+{
+    EXPECT_EQ(0.0f, mixer.mix(0, 0, 0, 0, 0));
+    mixer.setMode(ApuMixerMode::Linear);
+    EXPECT_EQ(0.0f, mixer.mix(0, 0, 0, 0, 0));
+}
+
+TEST_F(ApuMixerTest, PulseTableMatchesReference)
+{
+    for (u8 pulse1 = 0; pulse1 < 16; pulse1++) {
+        for (u8 pulse2 = 0; pulse2 < 16; pulse2++) {
+            EXPECT_NEAR(ApuMixer::mixReference(pulse1, pulse2, 0, 0, 0), mixer.mix(pulse1, pulse2, 0, 0, 0), PULSE_TOLERANCE)
+                << "pulse1 " << +pulse1 << " pulse2 " << +pulse2;
+        }
+    }
+}
+
+TEST_F(ApuMixerTest, TndTableMatchesReference)
+{
+    for (u8 triangle = 0; triangle < 16; triangle++) {
+        for (u8 noise = 0; noise < 16; noise++) {
+            for (u8 dmc = 0; dmc < 128; dmc++) {
+                EXPECT_NEAR(ApuMixer::mixReference(0, 0, triangle, noise, dmc), mixer.mix(0, 0, triangle, noise, dmc), TND_TOLERANCE)
+                    << "triangle " << +triangle << " noise " << +noise << " dmc " << +dmc;
+            }
+        }
+    }
+}
+
+TEST_F(ApuMixerTest, PulseAndTndAreSummed)
+{
+    EXPECT_FLOAT_EQ(mixer.mix(15, 15, 0, 0, 0) + mixer.mix(0, 0, 15, 15, 127), mixer.mix(15, 15, 15, 15, 127));
+    EXPECT_NEAR(ApuMixer::mixReference(15, 15, 15, 15, 127), mixer.mix(15, 15, 15, 15, 127), PULSE_TOLERANCE + TND_TOLERANCE);
+}
+
+TEST_F(ApuMixerTest, LinearModeMatchesSingleChannels)
+{
+    mixer.setMode(ApuMixerMode::Linear);
+    ASSERT_EQ(ApuMixerMode::Linear, mixer.getMode());
+    for (u8 level = 0; level < 16; level++) {
+        EXPECT_NEAR(ApuMixer::mixReference(level, 0, 0, 0, 0), mixer.mix(level, 0, 0, 0, 0), LINEAR_TOLERANCE);
+        EXPECT_NEAR(ApuMixer::mixReference(0, level, 0, 0, 0), mixer.mix(0, level, 0, 0, 0), LINEAR_TOLERANCE);
+        EXPECT_NEAR(ApuMixer::mixReference(0, 0, level, 0, 0), mixer.mix(0, 0, level, 0, 0), LINEAR_TOLERANCE);
+        EXPECT_NEAR(ApuMixer::mixReference(0, 0, 0, level, 0), mixer.mix(0, 0, 0, level, 0), LINEAR_TOLERANCE);
+    }
+    for (u8 dmc = 0; dmc < 128; dmc++) {
+        EXPECT_NEAR(ApuMixer::mixReference(0, 0, 0, 0, dmc), mixer.mix(0, 0, 0, 0, dmc), LINEAR_DMC_TOLERANCE);
+    }
+    // Full scale outputs of the channels are preserved
+    EXPECT_NEAR(mixer.mix(15, 15, 0, 0, 0), ApuMixer::TABLES.pulse[30], 1e-5f);
+    EXPECT_NEAR(mixer.mix(0, 0, 15, 0, 0), ApuMixer::TABLES.tnd[45], 1e-5f);
+}
@@ -0,0 +1,337 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cmath>
+#include <random>
+
+#include "../src/core/Apu.hpp"
+
+/**
+ * Checks that the APU changes its state at the right CPU cycles, even though it skips the idle cycles at once.
+ */
+class ApuTest : public ::testing::Test
+{
+    protected:
+        ApuTest() = default;
+
+        ~ApuTest() = default;
+
+        void SetUp() override
+        {
+            cycle = 0;
+            irqCycles.clear();
+            apu = std::make_unique<Apu>();
+            apu->setMemoryReader([](u16 addr) { return static_cast<u8>(addr); });
+        }
+
+        void TearDown() override
+        {
+        }
+
+        void run(unsigned cycles)
+        {
+            for (unsigned i = 0; i < cycles; i++) {
+                cycle++;
+                apu->tick();
+                stallCycles += apu->takeDmcStallCycles();
+                if (apu->getIrqCycle() == cycle) {
+                    irqCycles.push_back(cycle);
+                }
+            }
+        }
+
+        /**
+         * Runs until the status register no longer reports the given channel as active, returns the cycle it happened at.
+         */
+        u64 runUntilInactive(u8 channelMask)
+        {
+            while (apu->read() & channelMask) {
+                run(1);
+            }
+            return cycle;
+        }
+
+        /**
+         * Plays both pulse channels at full volume, with different periods.
+         */
+        void playPulses()
+        {
+            apu->write(0x15, 0x03);
+            apu->write(0x00, 0xBF);
+            apu->write(0x02, 0xFD);
+            apu->write(0x03, 0x01);
+            apu->write(0x04, 0xBF);
+            apu->write(0x06, 0x7E);
+            apu->write(0x07, 0x01);
+        }
+
+        /**
+         * RMS of the output during the given amount of cycles. Output of the preceding 0.05 s is dropped,
+         * so that the high-pass filter settles after a change of the mix.
+         */
+        double measureRms(unsigned cycles)
+        {
+            auto& audioBuffer = apu->getAudioBuffer();
+            std::vector<float> samples(audioBuffer.getCapacity());
+            run(Apu::CPU_CLOCK_RATE / 20);
+            audioBuffer.read(samples.data(), audioBuffer.getSize());
+            run(cycles);
+            const auto count = audioBuffer.read(samples.data(), audioBuffer.getSize());
+            double sum = 0.0;
+            for (unsigned i = 0; i < count; i++) {
+                sum += double(samples[i]) * samples[i];
+            }
+            return count > 0 ? std::sqrt(sum / count) : 0.0;
+        }
+
+        /**
+         * Everything the APU produced: cycles at which the IRQ line got asserted, DMC fetches,
+         * the status register reads and the samples.
+         */
+        struct Trace
+        {
+            std::vector<u64> irqCycles;
+            std::vector<u64> stallCycles;
+            std::vector<u8> status;
+            std::vector<float> samples;
+        };
+
+        /**
+         * Drives a separate APU with random register writes. Gaps between the writes are mostly short,
+         * some of them are long enough for the silent channels to stay idle for many timer periods.
+         */
+        static Trace runRandomWrites(bool audioEnabled, bool idleSkipping, unsigned seed, unsigned writes = 1500)
+        {
+            Trace trace;
+            u64 cycle = 0;
+            Apu apu;
+            apu.setMemoryReader([](u16 addr) { return static_cast<u8>(addr * 37); });
+            apu.setAudioEnabled(audioEnabled);
+            apu.setIdleSkipping(idleSkipping);
+            auto& audioBuffer = apu.getAudioBuffer();
+            std::vector<float> samples(audioBuffer.getCapacity());
+            std::mt19937 random(seed);
+
+            apu.write(0x15, 0x1F);
+            for (unsigned write = 0; write < writes; write++) {
+                const auto gap = random() % 8 == 0 ? random() % 100000 : random() % 3000;
+                for (unsigned i = 0; i < gap; i++) {
+                    cycle++;
+                    apu.tick();
+                    if (apu.takeDmcStallCycles() > 0) {
+                        trace.stallCycles.push_back(cycle);
+                    }
+                    if (apu.getIrqCycle() == cycle) {
+                        trace.irqCycles.push_back(cycle);
+                    }
+                }
+                const auto value = static_cast<u8>(random());
+                const auto addr = static_cast<u8>(random() % 0x18);
+                if (addr == 0x15) {
+                    trace.status.push_back(apu.read());
+                    apu.write(addr, value);
+                } else if (addr != 0x14 && addr != 0x16) {
+                    apu.write(addr, addr == 0x17 ? value & 0xC0 : value);
+                }
+                const auto count = audioBuffer.read(samples.data(), audioBuffer.getSize());
+                trace.samples.insert(trace.samples.end(), samples.begin(), samples.begin() + count);
+            }
+            return trace;
+        }
+
+        u64 cycle;
+        unsigned stallCycles = 0;
+        std::vector<u64> irqCycles;
+        std::unique_ptr<Apu> apu;
+};
+
+TEST_F(ApuTest, FrameIrq)
+{
+    // Sequence of the 4-step mode starts at the power-up, the interrupt is known before it happens
+    EXPECT_EQ(29828, apu->getIrqCycle());
+    run(29827);
+    EXPECT_FALSE(apu->isIrqAsserted());
+    run(1);
+    EXPECT_TRUE(apu->isIrqAsserted());
+    // Flag is set in 3 consecutive cycles, so the acknowledged interrupt is raised again in the first two
+    for (u64 expectedCycle : { 29828, 29829, 29830 }) {
+        EXPECT_EQ(expectedCycle, apu->getIrqCycle());
+        EXPECT_EQ(0x40, apu->read() & 0x40);
+        EXPECT_FALSE(apu->isIrqAsserted());
+        run(1);
+    }
+    EXPECT_FALSE(apu->isIrqAsserted());
+    EXPECT_EQ(29830 + 29828, apu->getIrqCycle());
+    // Unacknowledged interrupt stays asserted
+    run(100000);
+    EXPECT_EQ(std::vector<u64>({ 29828, 29829, 29830, 59658 }), irqCycles);
+    EXPECT_TRUE(apu->isIrqAsserted());
+}
+
+TEST_F(ApuTest, FrameIrqDisabled)
+{
+    apu->write(0x17, 0x40);
+    EXPECT_EQ(Apu::NO_IRQ, apu->getIrqCycle());
+    run(100000);
+    EXPECT_TRUE(irqCycles.empty());
+    // Inhibiting the interrupt acknowledges it
+    apu->write(0x17, 0x00);
+    run(3 + 29828);
+    EXPECT_TRUE(apu->isIrqAsserted());
+    apu->write(0x17, 0x40);
+    EXPECT_FALSE(apu->isIrqAsserted());
+}
+
+TEST_F(ApuTest, FrameCounterWriteDelay)
+{
+    // Sequence restarts 3 cycles after the write on an even cycle and 4 cycles after the write on an odd one
+    run(100);
+    apu->write(0x17, 0x00);
+    EXPECT_EQ(103 + 29828, apu->getIrqCycle());
+    run(1);
+    apu->write(0x17, 0x00);
+    EXPECT_EQ(105 + 29828, apu->getIrqCycle());
+    // Previous sequence goes on until the restart
+    SetUp();
+    run(29825);
+    apu->write(0x17, 0x00);
+    EXPECT_EQ(29828, apu->getIrqCycle());
+    run(3);
+    EXPECT_TRUE(apu->isIrqAsserted());
+    apu->read();
+    run(2);
+    EXPECT_FALSE(apu->isIrqAsserted());
+    EXPECT_EQ(29829 + 29828, apu->getIrqCycle());
+}
+
+TEST_F(ApuTest, FiveStepSequence)
+{
+    apu->write(0x15, 0x01);
+    // Length counter of 2 half frames
+    apu->write(0x00, 0x1F);
+    apu->write(0x03, 0x18);
+    apu->write(0x17, 0x80);
+    EXPECT_EQ(Apu::NO_IRQ, apu->getIrqCycle());
+    // Restart of the 5-step sequence clocks the half frame at the cycle 3, the next one follows 14913 cycles later
+    run(3);
+    EXPECT_EQ(1, apu->read() & 0x01);
+    EXPECT_EQ(3 + 14913, runUntilInactive(0x01));
+    run(100000);
+    EXPECT_TRUE(irqCycles.empty());
+}
+
+TEST_F(ApuTest, LengthCounter)
+{
+    apu->write(0x17, 0x40);
+    apu->write(0x15, 0x01);
+    // Length counter of 10 half frames
+    apu->write(0x00, 0x1F);
+    apu->write(0x03, 0x00);
+    EXPECT_EQ(1, apu->read() & 0x01);
+    // Write to $4017 at the cycle 0 restarts the sequence at the cycle 3.
+    // Half frames are clocked at the cycles 14913 and 29829 of the 29830 cycles long sequence.
+    EXPECT_EQ(3 + 4 * 29830 + 29829, runUntilInactive(0x01));
+}
+
+TEST_F(ApuTest, DmcFetchesAndIrq)
+{
+    apu->write(0x17, 0x40);
+    // Fastest rate with IRQ enabled, sample of 17 bytes
+    apu->write(0x10, 0x8F);
+    apu->write(0x13, 0x01);
+    apu->write(0x15, 0x10);
+    // First byte is fetched right away and waits in the buffer until the output unit finishes its initial 8 silent bits.
+    // Second byte is fetched at the cycle 380, every following one 8 bits of 54 cycles later.
+    EXPECT_EQ(380 + 15 * 8 * 54, apu->getIrqCycle());
+    const auto endCycle = runUntilInactive(0x10);
+    EXPECT_EQ(380 + 15 * 8 * 54, endCycle);
+    EXPECT_EQ(17 * 4, stallCycles);
+    ASSERT_EQ(1, irqCycles.size());
+    EXPECT_EQ(endCycle, irqCycles[0]);
+    EXPECT_EQ(0x80, apu->read() & 0x80);
+    apu->write(0x15, 0x00);
+    EXPECT_EQ(0, apu->read() & 0x80);
+}
+
+TEST_F(ApuTest, MutedAndSoloChannels)
+{
+    playPulses();
+    const auto both = measureRms(Apu::CPU_CLOCK_RATE / 5);
+    EXPECT_GT(both, 0.05);
+    apu->setMutedChannels(1 << Apu::PULSE_1);
+    const auto pulse2 = measureRms(Apu::CPU_CLOCK_RATE / 5);
+    EXPECT_GT(pulse2, 0.02);
+    EXPECT_LT(pulse2, both);
+    apu->setMutedChannels(Apu::ALL_CHANNELS);
+    EXPECT_LT(measureRms(Apu::CPU_CLOCK_RATE / 5), 1e-3);
+    // Solo channels are played even when they are muted
+    apu->setSoloChannels(1 << Apu::PULSE_2);
+    EXPECT_NEAR(pulse2, measureRms(Apu::CPU_CLOCK_RATE / 5), pulse2 * 0.02);
+    apu->setSoloChannels(0);
+    apu->setMutedChannels(0);
+    EXPECT_NEAR(both, measureRms(Apu::CPU_CLOCK_RATE / 5), both * 0.02);
+}
+
+TEST_F(ApuTest, ChannelTaps)
+{
+    EXPECT_EQ(nullptr, apu->getChannelTaps());
+    apu->setChannelTapRate(8000);
+    ASSERT_NE(nullptr, apu->getChannelTaps());
+    playPulses();
+    // Taps don't depend on the mix
+    apu->setSoloChannels(1 << Apu::TRIANGLE);
+    run(Apu::CPU_CLOCK_RATE / 10);
+    std::vector<float> samples(1000);
+    for (unsigned channel = 0; channel < Apu::CHANNEL_COUNT; channel++) {
+        auto& buffer = apu->getChannelTaps()->getBuffer(channel);
+        EXPECT_NEAR(800, buffer.getSize(), 1) << "channel " << channel;
+        const auto count = buffer.read(samples.data(), samples.size());
+        const auto [min, max] = std::minmax_element(samples.begin(), samples.begin() + count);
+        if (channel == Apu::PULSE_1 || channel == Apu::PULSE_2) {
+            EXPECT_EQ(0.0f, *min) << "channel " << channel;
+            EXPECT_EQ(1.0f, *max) << "channel " << channel;
+        } else {
+            // Channels that are not playing hold their level, triangle stays at the top of its sequence
+            EXPECT_EQ(*min, *max) << "channel " << channel;
+        }
+    }
+    apu->setChannelTapRate(0);
+    EXPECT_EQ(nullptr, apu->getChannelTaps());
+}
+
+/**
+ * Skipping the idle cycles must produce exactly the same as stepping every cycle, with and without audio.
+ */
+TEST_F(ApuTest, IdleSkippingMatchesStepping)
+{
+    for (bool audioEnabled : { true, false }) {
+        for (unsigned seed : { 1u, 2u }) {
+            const auto stepped = runRandomWrites(audioEnabled, false, seed);
+            const auto skipped = runRandomWrites(audioEnabled, true, seed);
+            EXPECT_FALSE(stepped.irqCycles.empty());
+            EXPECT_FALSE(stepped.stallCycles.empty());
+            EXPECT_EQ(audioEnabled, !stepped.samples.empty());
+            EXPECT_EQ(stepped.irqCycles, skipped.irqCycles) << "audio " << audioEnabled << ", seed " << seed;
+            EXPECT_EQ(stepped.stallCycles, skipped.stallCycles) << "audio " << audioEnabled << ", seed " << seed;
+            EXPECT_EQ(stepped.status, skipped.status) << "audio " << audioEnabled << ", seed " << seed;
+            EXPECT_TRUE(stepped.samples == skipped.samples) << "audio " << audioEnabled << ", seed " << seed;
+        }
+    }
+}
+
+/**
+ * Measures the speed up of skipping the idle cycles. Run with --gtest_also_run_disabled_tests,
+ * times are reported as test properties.
+ */
+TEST_F(ApuTest, DISABLED_IdleSkippingBenchmark)
+{
+    for (bool audioEnabled : { true, false }) {
+        for (bool idleSkipping : { false, true }) {
+            const auto start = std::chrono::steady_clock::now();
+            runRandomWrites(audioEnabled, idleSkipping, 1, 10000);
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            RecordProperty(std::string(idleSkipping ? "Skipped" : "Stepped") + (audioEnabled ? "AudioOnMs" : "AudioOffMs"),
+                std::to_string(elapsed.count()));
+        }
+    }
+}
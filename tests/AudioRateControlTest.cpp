@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "../src/core/Apu.hpp"
+#include "../src/core/apu/AudioRateControl.hpp"
+
+/**
+ * Runs APU against a simulated audio device, whose clock differs from the nominal sample rate.
+ * Device takes samples in blocks, like SDL does.
+ */
+class AudioRateControlTest : public ::testing::Test
+{
+    protected:
+        static constexpr const unsigned BLOCK_SAMPLES = 512;
+        static constexpr const unsigned TARGET_SAMPLES = BLOCK_SAMPLES * 3 / 2;
+        // Clocks of real devices are usually off by less than 0.05 %
+        static constexpr const double DRIFT = 0.001;
+
+        AudioRateControlTest() = default;
+
+        ~AudioRateControlTest() = default;
+
+        void SetUp() override
+        {
+            apu = std::make_unique<Apu>();
+            block.resize(BLOCK_SAMPLES);
+            // Device takes the first block as soon as it starts
+            deviceSamples = BLOCK_SAMPLES;
+        }
+
+        void TearDown() override
+        {
+        }
+
+        /**
+         * Fills the audio buffer, so that its average level is the target level once the device starts taking blocks.
+         */
+        void prefill()
+        {
+            while (apu->getAudioBuffer().getSize() < TARGET_SAMPLES + BLOCK_SAMPLES / 2) {
+                apu->tick();
+            }
+        }
+
+        /**
+         * Runs the APU for the given amount of seconds with the device running faster by the given fraction.
+         * Returns the highest level of the audio buffer.
+         */
+        unsigned run(double seconds, double deviceDrift)
+        {
+            const double deviceSamplesPerCycle = Apu::DEFAULT_SAMPLE_RATE * (1.0 + deviceDrift) / Apu::CPU_CLOCK_RATE;
+            const auto cycles = static_cast<u64>(seconds * Apu::CPU_CLOCK_RATE);
+            unsigned highestLevel = 0;
+            for (u64 cycle = 0; cycle < cycles; cycle++) {
+                apu->tick();
+                deviceSamples += deviceSamplesPerCycle;
+                if (deviceSamples >= BLOCK_SAMPLES) {
+                    deviceSamples -= BLOCK_SAMPLES;
+                    highestLevel = std::max(highestLevel, apu->getAudioBuffer().getSize());
+                    apu->getAudioBuffer().read(block.data(), BLOCK_SAMPLES);
+                }
+            }
+            return highestLevel;
+        }
+
+        std::unique_ptr<Apu> apu;
+        std::vector<float> block;
+        double deviceSamples;
+};
+
+TEST_F(AudioRateControlTest, RatioFollowsBufferLevel)
+{
+    AudioRateControl rateControl;
+    EXPECT_DOUBLE_EQ(1.0, rateControl.update(0));
+    rateControl.setTargetLevel(TARGET_SAMPLES);
+    EXPECT_DOUBLE_EQ(1.0, rateControl.update(TARGET_SAMPLES));
+    for (unsigned i = 0; i < 100; i++) {
+        rateControl.update(0);
+    }
+    EXPECT_GT(rateControl.getRatio(), 1.0);
+    EXPECT_LE(rateControl.getRatio(), 1.0 + AudioRateControl::DEFAULT_MAX_DEVIATION);
+    for (unsigned i = 0; i < 100; i++) {
+        rateControl.update(10 * TARGET_SAMPLES);
+    }
+    EXPECT_DOUBLE_EQ(1.0 - AudioRateControl::DEFAULT_MAX_DEVIATION, rateControl.getRatio());
+}
+
+TEST_F(AudioRateControlTest, FixedRateDrifts)
+{
+    prefill();
+    const auto initialLevel = run(1.0, -DRIFT);
+    const auto highestLevel = run(20.0, -DRIFT);
+    // Buffer grows by the difference of the rates
+    EXPECT_GT(highestLevel, initialLevel + 0.8 * 20.0 * DRIFT * Apu::DEFAULT_SAMPLE_RATE);
+}
+
+TEST_F(AudioRateControlTest, FasterDeviceIsFollowed)
+{
+    apu->setAudioBufferTarget(TARGET_SAMPLES);
+    prefill();
+    run(10.0, DRIFT);
+    EXPECT_EQ(0, apu->getAudioBuffer().getUnderrunCount());
+    EXPECT_GT(apu->getAudioRateRatio(), 1.0);
+}
+
+TEST_F(AudioRateControlTest, SlowerDeviceIsFollowed)
+{
+    apu->setAudioBufferTarget(TARGET_SAMPLES);
+    prefill();
+    // Latency stays below 40 ms, including the block queued in the device
+    const auto highestLevel = run(10.0, -DRIFT);
+    EXPECT_EQ(0, apu->getAudioBuffer().getUnderrunCount());
+    EXPECT_EQ(0, apu->getAudioBuffer().getOverrunCount());
+    EXPECT_LT(highestLevel + BLOCK_SAMPLES, Apu::DEFAULT_SAMPLE_RATE * 40 / 1000);
+    EXPECT_LT(apu->getAudioRateRatio(), 1.0);
+}
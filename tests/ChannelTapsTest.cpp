@@ -0,0 +1,69 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "../src/core/apu/ChannelTaps.hpp"
+
+/**
+ * Checks that the levels of the channels are averaged over the periods of tap samples.
+ */
+class ChannelTapsTest : public ::testing::Test
+{
+    protected:
+        static constexpr const double CLOCK_RATE = 1000.0;
+        static constexpr const double TAP_RATE = 100.0;
+        static constexpr const unsigned CAPACITY = 1024;
+
+        ChannelTapsTest()
+            : taps(CLOCK_RATE, TAP_RATE, CAPACITY)
+        {
+        }
+
+        ~ChannelTapsTest() = default;
+
+        std::vector<float> read(unsigned channel)
+        {
+            auto& buffer = taps.getBuffer(channel);
+            std::vector<float> samples(buffer.getSize());
+            buffer.read(samples.data(), samples.size());
+            return samples;
+        }
+
+        ChannelTaps taps;
+};
+
+TEST_F(ChannelTapsTest, LevelsAreNormalized)
+{
+    taps.add({ 15, 0, 3, 15, 127 }, 10);
+    EXPECT_EQ(std::vector<float>({ 1.0f }), read(0));
+    EXPECT_EQ(std::vector<float>({ 0.0f }), read(1));
+    EXPECT_FLOAT_EQ(0.2f, read(2)[0]);
+    EXPECT_EQ(std::vector<float>({ 1.0f }), read(3));
+    EXPECT_EQ(std::vector<float>({ 1.0f }), read(4));
+}
+
+TEST_F(ChannelTapsTest, LevelsAreAveraged)
+{
+    // Pulse wave with the duty of 30 %, its period is the period of a tap sample
+    for (unsigned i = 0; i < 50; i++) {
+        taps.add({ 15, 0, 0, 0, 0 }, 3);
+        taps.add({ 0, 0, 0, 0, 0 }, 7);
+    }
+    const auto samples = read(0);
+    ASSERT_EQ(50, samples.size());
+    for (auto sample : samples) {
+        EXPECT_FLOAT_EQ(0.3f, sample);
+    }
+}
+
+TEST_F(ChannelTapsTest, LongRunsAreSplit)
+{
+    taps.add({ 15, 15, 15, 15, 127 }, 5);
+    taps.add({ 0, 0, 0, 0, 0 }, 1000);
+    const auto samples = read(0);
+    ASSERT_EQ(100, samples.size());
+    EXPECT_FLOAT_EQ(0.5f, samples[0]);
+    for (unsigned i = 1; i < samples.size(); i++) {
+        EXPECT_EQ(0.0f, samples[i]);
+    }
+}
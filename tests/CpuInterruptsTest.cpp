@@ -27,7 +27,6 @@ TEST_F(CpuInterruptsTest, BranchDelaysIrq)
 
 TEST_F(CpuInterruptsTest, CliLatency)
 {
-    GTEST_SKIP() << "Needs attention (APU should generate IRQ when $4017 = $00)";
     auto result = run("resources/cpu_interrupts_v2/cli_latency.nes");
     ASSERT_EQ(0, result) << (result == 0x100 ? "Failed to load ROM" : readMessage());
 }
@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <numbers>
+#include <vector>
+
+#include "../src/core/Apu.hpp"
+#include "../src/core/apu/Decimator.hpp"
+
+/**
+ * Feeds the decimator with sines at the native rate of the APU and measures what comes out at the output rate.
+ */
+class DecimatorTest : public ::testing::Test
+{
+    protected:
+        static constexpr const double INPUT_RATE = Apu::CPU_CLOCK_RATE / 2.0;
+        static constexpr const double OUTPUT_RATE = 44100.0;
+        static constexpr const double AMPLITUDE = 0.5;
+        // Filters and the high-pass settle within the first blocks, they are left out of the measurement
+        static constexpr const unsigned SETTLING_BLOCKS = 8;
+        static constexpr const unsigned MEASURED_BLOCKS = 64;
+
+        DecimatorTest()
+            : decimator(INPUT_RATE, OUTPUT_RATE)
+            , input(Decimator::BLOCK_SIZE)
+            , output(decimator.getMaxOutputSize())
+            , inputSampleCount(0)
+        {
+        }
+
+        ~DecimatorTest() = default;
+
+        /**
+         * Processes the given amount of blocks of a sine with the given frequency, returns the produced samples.
+         */
+        std::vector<float> process(double frequency, unsigned blocks)
+        {
+            std::vector<float> result;
+            for (unsigned block = 0; block < blocks; block++) {
+                for (auto& sample : input) {
+                    sample = static_cast<float>(AMPLITUDE * std::sin(2.0 * std::numbers::pi * frequency * inputSampleCount++ / INPUT_RATE));
+                }
+                const auto count = decimator.process(input.data(), output.data());
+                EXPECT_LE(count, output.size());
+                result.insert(result.end(), output.begin(), output.begin() + count);
+            }
+            return result;
+        }
+
+        /**
+         * Amplitude of the sine that remains in the output after the filters settle.
+         */
+        double measureAmplitude(double frequency)
+        {
+            process(frequency, SETTLING_BLOCKS);
+            const auto samples = process(frequency, MEASURED_BLOCKS);
+            double sum = 0.0;
+            for (auto sample : samples) {
+                sum += double(sample) * sample;
+            }
+            return std::sqrt(2.0 * sum / samples.size());
+        }
+
+        Decimator decimator;
+        std::vector<float> input;
+        std::vector<float> output;
+        u64 inputSampleCount;
+};
+
+TEST_F(DecimatorTest, PassbandIsKept)
+{
+    for (auto frequency : { 440.0, 1000.0, 5000.0, 12000.0, 16000.0 }) {
+        decimator.clear();
+        EXPECT_NEAR(AMPLITUDE, measureAmplitude(frequency), AMPLITUDE * 0.02) << frequency << " Hz";
+    }
+}
+
+TEST_F(DecimatorTest, AliasesAreRemoved)
+{
+    // Each of these folds into the audible band at one of the stages or at the output rate
+    for (auto frequency : { 30000.0, 42000.0, 100000.0, 210000.0, 440000.0 }) {
+        decimator.clear();
+        EXPECT_LT(measureAmplitude(frequency), AMPLITUDE * 0.001) << frequency << " Hz";
+    }
+}
+
+TEST_F(DecimatorTest, OutputCountFollowsRate)
+{
+    const auto samples = process(1000.0, MEASURED_BLOCKS);
+    const auto expected = MEASURED_BLOCKS * Decimator::BLOCK_SIZE * OUTPUT_RATE / INPUT_RATE;
+    // Output starts once the kernel of the resampler is covered by samples, it is less than 64 samples late
+    EXPECT_NEAR(expected - 32, samples.size(), 32);
+
+    decimator.setOutputRate(OUTPUT_RATE * 1.005);
+    const auto faster = process(1000.0, MEASURED_BLOCKS);
+    EXPECT_NEAR(expected * 1.005, faster.size(), 2.0);
+}
+
+TEST_F(DecimatorTest, ReportsBlockTime)
+{
+    process(1000.0, MEASURED_BLOCKS);
+    EXPECT_GT(decimator.getLastBlockTime(), 0.0);
+    EXPECT_GT(decimator.getAverageBlockTime(), 0.0);
+    RecordProperty("AverageBlockTimeMs", std::to_string(decimator.getAverageBlockTime()));
+}
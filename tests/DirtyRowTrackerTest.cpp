@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+
+#include "../src/video/DirtyRowTracker.hpp"
+
+class DirtyRowTrackerTest : public ::testing::Test
+{
+    protected:
+        DirtyRowTracker tracker;
+        DirtyRowTracker::RowHashes rowHashes;
+
+        DirtyRowTrackerTest()
+            : tracker()
+            , rowHashes()
+        {
+            for (unsigned row = 0; row < DirtyRowTracker::ROW_COUNT; row++) {
+                rowHashes[row] = row * 0x9E3779B9u;
+            }
+        }
+
+        ~DirtyRowTrackerTest() = default;
+
+        static void expectRange(const std::optional<DirtyRowTracker::RowRange>& range, unsigned first, unsigned count)
+        {
+            ASSERT_TRUE(range.has_value());
+            EXPECT_EQ(first, range->first);
+            EXPECT_EQ(count, range->count);
+        }
+};
+
+TEST_F(DirtyRowTrackerTest, UnchangedFrameIsSkipped)
+{
+    // First frame is always uploaded whole
+    expectRange(tracker.update(rowHashes), 0, DirtyRowTracker::ROW_COUNT);
+    EXPECT_FALSE(tracker.update(rowHashes).has_value());
+    EXPECT_FALSE(tracker.update(rowHashes, 2).has_value());
+    EXPECT_EQ(2, tracker.getSkippedFrameCount());
+}
+
+TEST_F(DirtyRowTrackerTest, SingleChangedRow)
+{
+    tracker.update(rowHashes);
+    rowHashes[100]++;
+    expectRange(tracker.update(rowHashes), 100, 1);
+    // Changed row was uploaded, so it isn't dirty anymore
+    EXPECT_FALSE(tracker.update(rowHashes).has_value());
+
+    // Rows between the changed ones are uploaded as well
+    rowHashes[10]++;
+    rowHashes[20]++;
+    expectRange(tracker.update(rowHashes), 10, 11);
+    EXPECT_EQ(1, tracker.getSkippedFrameCount());
+}
+
+TEST_F(DirtyRowTrackerTest, MarginExpansion)
+{
+    tracker.update(rowHashes);
+    rowHashes[100]++;
+    expectRange(tracker.update(rowHashes, 2), 98, 5);
+    // Range is clamped at the edges of the frame
+    rowHashes[1]++;
+    expectRange(tracker.update(rowHashes, 2), 0, 4);
+    rowHashes[DirtyRowTracker::ROW_COUNT - 1]++;
+    expectRange(tracker.update(rowHashes, 3), DirtyRowTracker::ROW_COUNT - 4, 4);
+}
+
+TEST_F(DirtyRowTrackerTest, PeriodicFullUpload)
+{
+    tracker.update(rowHashes);
+    for (unsigned frame = 1; frame < DirtyRowTracker::FULL_UPLOAD_INTERVAL; frame++) {
+        ASSERT_FALSE(tracker.update(rowHashes).has_value()) << "frame " << frame;
+    }
+    expectRange(tracker.update(rowHashes), 0, DirtyRowTracker::ROW_COUNT);
+    EXPECT_FALSE(tracker.update(rowHashes).has_value());
+    EXPECT_EQ(DirtyRowTracker::FULL_UPLOAD_INTERVAL, tracker.getSkippedFrameCount());
+
+    // Any upload in between doesn't postpone the full one
+    for (unsigned frame = 2; frame < DirtyRowTracker::FULL_UPLOAD_INTERVAL; frame++) {
+        rowHashes[50]++;
+        const auto range = tracker.update(rowHashes);
+        ASSERT_TRUE(range.has_value()) << "frame " << frame;
+        ASSERT_EQ(1, range->count) << "frame " << frame;
+    }
+    expectRange(tracker.update(rowHashes), 0, DirtyRowTracker::ROW_COUNT);
+}
+
+TEST_F(DirtyRowTrackerTest, Invalidate)
+{
+    tracker.update(rowHashes);
+    tracker.invalidate();
+    expectRange(tracker.update(rowHashes, 1), 0, DirtyRowTracker::ROW_COUNT);
+    EXPECT_FALSE(tracker.update(rowHashes).has_value());
+}
@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#include "util/SystemUnderTest.hpp"
+#include "../src/core/FrameDeltaEncoder.hpp"
+#include "../src/core/FrameDeltaDecoder.hpp"
+
+class FrameDeltaEncoderTest : public ::testing::Test
+{
+    protected:
+        static constexpr const unsigned FRAME_SIZE = FrameDeltaEncoder::WIDTH * FrameDeltaEncoder::HEIGHT;
+
+        FrameDeltaEncoderTest() = default;
+
+        ~FrameDeltaEncoderTest() = default;
+
+        void SetUp() override
+        {
+            frame.assign(FRAME_SIZE, 0x0F);
+        }
+
+        void TearDown() override
+        {
+        }
+
+        bool roundTrip(FrameDeltaEncoder& encoder, FrameDeltaDecoder& decoder, const u8* pixels)
+        {
+            const auto& packet = encoder.encode(pixels);
+            return decoder.decode(packet.data(), packet.size())
+                && std::memcmp(decoder.getFrame(), pixels, FRAME_SIZE) == 0;
+        }
+
+        std::vector<u8> frame;
+};
+
+TEST_F(FrameDeltaEncoderTest, FirstFrameIsKeyframe)
+{
+    FrameDeltaEncoder encoder;
+    FrameDeltaDecoder decoder;
+    frame[1000] = 0x30;
+    const auto& packet = encoder.encode(frame.data());
+    EXPECT_EQ(FrameDeltaEncoder::KEYFRAME, packet[0]);
+    EXPECT_EQ(FrameDeltaEncoder::TILE_COUNT, encoder.getChangedTileCount());
+    EXPECT_TRUE(decoder.decode(packet.data(), packet.size()));
+    EXPECT_EQ(0, std::memcmp(decoder.getFrame(), frame.data(), FRAME_SIZE));
+}
+
+TEST_F(FrameDeltaEncoderTest, OnlyChangedTilesAreSent)
+{
+    FrameDeltaEncoder encoder;
+    FrameDeltaDecoder decoder;
+    ASSERT_TRUE(roundTrip(encoder, decoder, frame.data()));
+
+    // Unchanged frame consists only of the header
+    ASSERT_TRUE(roundTrip(encoder, decoder, frame.data()));
+    EXPECT_EQ(0, encoder.getChangedTileCount());
+    EXPECT_EQ(3, encoder.getLastPacketSize());
+
+    // Pixels in the last tile of the first row and in the first tile of the second row
+    frame[255] = 0x21;
+    frame[8 * FrameDeltaEncoder::WIDTH + 7 * FrameDeltaEncoder::WIDTH] = 0x16;
+    ASSERT_TRUE(roundTrip(encoder, decoder, frame.data()));
+    EXPECT_EQ(2, encoder.getChangedTileCount());
+}
+
+TEST_F(FrameDeltaEncoderTest, KeyframesArePeriodic)
+{
+    FrameDeltaEncoder encoder(4);
+    std::vector<u8> types;
+    for (unsigned i = 0; i < 9; i++) {
+        types.push_back(encoder.encode(frame.data())[0]);
+    }
+    encoder.requestKeyframe();
+    types.push_back(encoder.encode(frame.data())[0]);
+    std::vector<u8> expected = { 1, 0, 0, 0, 1, 0, 0, 0, 1, 1 };
+    EXPECT_EQ(expected, types);
+}
+
+TEST_F(FrameDeltaEncoderTest, DeltaFrameRequiresKeyframe)
+{
+    FrameDeltaEncoder encoder;
+    FrameDeltaDecoder decoder;
+    encoder.encode(frame.data());
+    const auto packet = encoder.encode(frame.data());
+    EXPECT_FALSE(decoder.decode(packet.data(), packet.size()));
+    EXPECT_FALSE(decoder.hasFrame());
+}
+
+TEST_F(FrameDeltaEncoderTest, MalformedPacketIsRejected)
+{
+    FrameDeltaEncoder encoder;
+    FrameDeltaDecoder decoder;
+    auto packet = encoder.encode(frame.data());
+    packet.pop_back();
+    EXPECT_FALSE(decoder.decode(packet.data(), packet.size()));
+}
+
+TEST_F(FrameDeltaEncoderTest, RomFramesRoundTrip)
+{
+    SystemUnderTest systemUnderTest;
+    auto ppu = systemUnderTest.getPpu();
+    ppu->setRenderMode(PpuRenderMode::Full);
+    ppu->setOutputFormat(PpuOutputFormat::Indexed8);
+    ASSERT_TRUE(systemUnderTest.getCartridge()->loadFromFile(
+        std::ifstream("resources/ppu_sprite_hit/basics.nes", std::ios::binary)));
+    systemUnderTest.getCpu()->reset();
+
+    FrameDeltaEncoder encoder;
+    FrameDeltaDecoder decoder;
+    unsigned frames = 0;
+    std::size_t totalSize = 0;
+    while (frames < 120) {
+        systemUnderTest.getCpu()->step();
+        if (!ppu->hasNewFrame()) {
+            continue;
+        }
+        const auto& pixels = ppu->getFrame().pixels;
+        ASSERT_TRUE(roundTrip(encoder, decoder, pixels.data())) << "Frame " << frames;
+        totalSize += encoder.getLastPacketSize();
+        frames++;
+    }
+    // Mostly static text screen is far smaller than the raw frames
+    EXPECT_LT(totalSize, frames * FRAME_SIZE / 10);
+}
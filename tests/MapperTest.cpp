@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "../src/core/mapper/Mapper1.hpp"
+#include "../src/core/mapper/Mapper3.hpp"
+
+/**
+ * CHR memory is filled with the number of its 1KB page, so that every read shows which page is mapped.
+ */
+class MapperTest : public ::testing::Test
+{
+    protected:
+        static constexpr const unsigned PRG_ROM_SIZE = 0x8000;
+
+        MapperTest() = default;
+
+        ~MapperTest() = default;
+
+        static std::vector<u8> createChr(unsigned size)
+        {
+            std::vector<u8> chr(size);
+            for (unsigned addr = 0; addr < size; addr++) {
+                chr[addr] = static_cast<u8>(addr / Mapper::CHR_PAGE_SIZE);
+            }
+            return chr;
+        }
+
+        /**
+         * Returns the CHR page mapped into each page of the pattern table address space.
+         */
+        static std::vector<u8> mappedPages(const Mapper& mapper)
+        {
+            std::vector<u8> pages;
+            for (unsigned page = 0; page < Mapper::CHR_PAGE_COUNT; page++) {
+                pages.push_back(mapper.readChr(page * Mapper::CHR_PAGE_SIZE + 0x123));
+            }
+            return pages;
+        }
+
+        /**
+         * Writes a value into MMC1 register through its serial port, a bit at a time.
+         */
+        static void writeMapper1Register(Mapper1& mapper, u16 addr, u8 value)
+        {
+            for (unsigned bit = 0; bit < 5; bit++) {
+                mapper.write(addr, (value >> bit) & 1);
+            }
+        }
+};
+
+TEST_F(MapperTest, Mapper1ChrBanks)
+{
+    Mapper1 mapper(std::vector<u8>(PRG_ROM_SIZE), createChr(0x8000), MirroringType::Horizontal);
+    // 8KB mode, lowest bit of the bank number is ignored
+    EXPECT_EQ(std::vector<u8>({ 0, 1, 2, 3, 4, 5, 6, 7 }), mappedPages(mapper));
+    writeMapper1Register(mapper, 0xA000, 3);
+    EXPECT_EQ(std::vector<u8>({ 8, 9, 10, 11, 12, 13, 14, 15 }), mappedPages(mapper));
+    writeMapper1Register(mapper, 0xC000, 6);
+    EXPECT_EQ(std::vector<u8>({ 8, 9, 10, 11, 12, 13, 14, 15 }), mappedPages(mapper));
+
+    // 4KB mode, both halves are switched independently
+    writeMapper1Register(mapper, 0x8000, 0x10);
+    EXPECT_EQ(std::vector<u8>({ 12, 13, 14, 15, 24, 25, 26, 27 }), mappedPages(mapper));
+    writeMapper1Register(mapper, 0xA000, 1);
+    EXPECT_EQ(std::vector<u8>({ 4, 5, 6, 7, 24, 25, 26, 27 }), mappedPages(mapper));
+    writeMapper1Register(mapper, 0xC000, 0);
+    EXPECT_EQ(std::vector<u8>({ 4, 5, 6, 7, 0, 1, 2, 3 }), mappedPages(mapper));
+}
+
+TEST_F(MapperTest, Mapper1ChrBanksWrapAround)
+{
+    Mapper1 mapper(std::vector<u8>(PRG_ROM_SIZE), createChr(0x2000), MirroringType::Horizontal);
+    // Banks past the end of the 8KB CHR are mirrored
+    writeMapper1Register(mapper, 0xA000, 4);
+    EXPECT_EQ(std::vector<u8>({ 0, 1, 2, 3, 4, 5, 6, 7 }), mappedPages(mapper));
+    writeMapper1Register(mapper, 0x8000, 0x10);
+    writeMapper1Register(mapper, 0xA000, 3);
+    writeMapper1Register(mapper, 0xC000, 0x1E);
+    EXPECT_EQ(std::vector<u8>({ 4, 5, 6, 7, 0, 1, 2, 3 }), mappedPages(mapper));
+}
+
+TEST_F(MapperTest, Mapper3ChrBanks)
+{
+    Mapper3 mapper(std::vector<u8>(PRG_ROM_SIZE), createChr(0x8000), MirroringType::Vertical);
+    EXPECT_EQ(std::vector<u8>({ 0, 1, 2, 3, 4, 5, 6, 7 }), mappedPages(mapper));
+    mapper.write(0x8000, 2);
+    EXPECT_EQ(std::vector<u8>({ 16, 17, 18, 19, 20, 21, 22, 23 }), mappedPages(mapper));
+    // Only the two lowest bits select the bank
+    mapper.write(0xFFFF, 0xFD);
+    EXPECT_EQ(std::vector<u8>({ 8, 9, 10, 11, 12, 13, 14, 15 }), mappedPages(mapper));
+}
+
+TEST_F(MapperTest, ChrRamIsWritable)
+{
+    Mapper3 mapper(std::vector<u8>(PRG_ROM_SIZE), std::vector<u8>(), MirroringType::Vertical);
+    mapper.writeChr(0x0000, 0x12);
+    mapper.writeChr(0x1FFF, 0x34);
+    EXPECT_EQ(0x12, mapper.readChr(0x0000));
+    EXPECT_EQ(0x34, mapper.readChr(0x1FFF));
+
+    // Both 4KB halves pointing to the same part of the CHR-RAM see the same data
+    Mapper1 mapper1(std::vector<u8>(PRG_ROM_SIZE), std::vector<u8>(), MirroringType::Vertical);
+    writeMapper1Register(mapper1, 0x8000, 0x10);
+    mapper1.writeChr(0x1456, 0x78);
+    EXPECT_EQ(0x78, mapper1.readChr(0x0456));
+}
+
+TEST_F(MapperTest, ChrRomWritesAreIgnored)
+{
+    Mapper3 mapper(std::vector<u8>(PRG_ROM_SIZE), createChr(0x2000), MirroringType::Vertical);
+    mapper.writeChr(0x0000, 0x12);
+    mapper.writeChr(0x1FFF, 0x34);
+    EXPECT_EQ(0, mapper.readChr(0x0000));
+    EXPECT_EQ(7, mapper.readChr(0x1FFF));
+}
+
+TEST_F(MapperTest, ChrGeneration)
+{
+    Mapper3 mapper3(std::vector<u8>(PRG_ROM_SIZE), createChr(0x8000), MirroringType::Vertical);
+    const auto initial = mapper3.getChrGeneration();
+    // Same bank selected again, or writes into PRG-RAM
+    mapper3.write(0x8000, 0);
+    mapper3.write(0x8000, 4);
+    mapper3.write(0x6000, 1);
+    EXPECT_EQ(initial, mapper3.getChrGeneration());
+    mapper3.write(0x8000, 1);
+    EXPECT_EQ(initial + 1, mapper3.getChrGeneration());
+    mapper3.write(0x8000, 1);
+    EXPECT_EQ(initial + 1, mapper3.getChrGeneration());
+
+    Mapper1 mapper1(std::vector<u8>(PRG_ROM_SIZE), createChr(0x8000), MirroringType::Horizontal);
+    const auto initial1 = mapper1.getChrGeneration();
+    // Bank numbers differing only in the ignored bit, the other bank in 8KB mode, and PRG bank
+    writeMapper1Register(mapper1, 0xA000, 1);
+    writeMapper1Register(mapper1, 0xC000, 3);
+    writeMapper1Register(mapper1, 0xE000, 1);
+    EXPECT_EQ(initial1, mapper1.getChrGeneration());
+    writeMapper1Register(mapper1, 0xA000, 2);
+    EXPECT_EQ(initial1 + 1, mapper1.getChrGeneration());
+    // 4KB banks 2 and 3 are the same memory as the 8KB bank 1, only the mode changes, or only the mirroring
+    writeMapper1Register(mapper1, 0x8000, 0x10);
+    writeMapper1Register(mapper1, 0x8000, 0x13);
+    EXPECT_EQ(initial1 + 1, mapper1.getChrGeneration());
+    writeMapper1Register(mapper1, 0xC000, 4);
+    EXPECT_EQ(initial1 + 2, mapper1.getChrGeneration());
+}
@@ -0,0 +1,161 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstring>
+#include <numbers>
+#include <vector>
+
+#include "../src/video/NtscFilter.hpp"
+#include "../src/core/Ppu.hpp"
+
+/**
+ * Compares the filter, which sums precomputed kernels (with SIMD where available),
+ * with a plain decoder of the composite signal written from the scratch.
+ */
+class NtscFilterTest : public ::testing::Test
+{
+    protected:
+        static constexpr const int SAMPLES_PER_CYCLE = 12;
+        static constexpr const int SAMPLES_PER_PIXEL = 8;
+        // Rounding of the accumulated floats differs between the kernel sum and the reference
+        static constexpr const int TOLERANCE = 2;
+
+        NtscFilterTest() = default;
+
+        ~NtscFilterTest() = default;
+
+        static bool inColorPhase(int color, int phase)
+        {
+            return (color + phase) % SAMPLES_PER_CYCLE < 6;
+        }
+
+        static float signalLevel(unsigned entry, int phase)
+        {
+            static constexpr const float LEVELS[8] = { 0.350f, 0.518f, 0.962f, 1.550f, 1.094f, 1.506f, 1.962f, 1.962f };
+            const int color = entry & 0x0F;
+            const int level = color > 13 ? 1 : (entry >> 4) & 3;
+            const int emphasis = entry >> 6;
+            float low = LEVELS[level];
+            float high = LEVELS[4 + level];
+            if (color == 0) {
+                low = high;
+            }
+            if (color > 12) {
+                high = low;
+            }
+            float signal = inColorPhase(color, phase) ? high : low;
+            if (((emphasis & 1) && inColorPhase(0, phase))
+                || ((emphasis & 2) && inColorPhase(4, phase))
+                || ((emphasis & 4) && inColorPhase(8, phase))) {
+                signal *= 0.746f;
+            }
+            return (signal - 0.518f) / (1.962f - 0.518f);
+        }
+
+        /**
+         * Decodes every output pixel from the 12 samples of the whole scanline around its center.
+         */
+        static std::vector<u32> referenceRow(const std::vector<u16>& entries, unsigned row)
+        {
+            const int phaseShift = (row % 3) * 4;
+            std::vector<u32> output(NtscFilter::OUTPUT_WIDTH);
+            for (unsigned x = 0; x < NtscFilter::OUTPUT_WIDTH; x++) {
+                const int center = static_cast<int>(std::floor(x * 24.0f / 7));
+                float y = 0.0f;
+                float i = 0.0f;
+                float q = 0.0f;
+                for (int sample = center - SAMPLES_PER_CYCLE / 2; sample < center + SAMPLES_PER_CYCLE / 2; sample++) {
+                    if (sample < 0 || sample >= int(NtscFilter::INPUT_WIDTH) * SAMPLES_PER_PIXEL) {
+                        continue;
+                    }
+                    const int phase = sample + phaseShift;
+                    const float level = signalLevel(entries[sample / SAMPLES_PER_PIXEL], phase) / SAMPLES_PER_CYCLE;
+                    const float angle = std::numbers::pi_v<float> * (phase + 3.9f) / 6.0f;
+                    y += level;
+                    i += level * std::cos(angle);
+                    q += level * std::sin(angle);
+                }
+                const float channels[3] = {
+                    255.0f * (y + 0.946882f * i + 0.623557f * q),
+                    255.0f * (y - 0.274788f * i - 0.635691f * q),
+                    255.0f * (y - 1.108545f * i + 1.709007f * q)
+                };
+                u32 rgba = 0xFF000000u;
+                for (unsigned channel = 0; channel < 3; channel++) {
+                    rgba |= static_cast<u32>(std::lround(std::fmin(std::fmax(channels[channel], 0.0f), 255.0f))) << (channel * 8);
+                }
+                output[x] = rgba;
+            }
+            return output;
+        }
+
+        static std::vector<u32> filterRow(const NtscFilter& filter, const std::vector<u16>& entries, unsigned row)
+        {
+            std::vector<u8> frame(Ppu::BUFFER_SIZE * sizeof(u16));
+            std::memcpy(frame.data() + row * NtscFilter::INPUT_WIDTH * sizeof(u16), entries.data(), NtscFilter::INPUT_WIDTH * sizeof(u16));
+            std::vector<u32> output(NtscFilter::OUTPUT_WIDTH);
+            filter.apply(frame.data(), row, 1, output.data());
+            return output;
+        }
+
+        static void expectNear(const std::vector<u32>& expected, const std::vector<u32>& actual)
+        {
+            ASSERT_EQ(expected.size(), actual.size());
+            for (unsigned x = 0; x < expected.size(); x++) {
+                for (unsigned channel = 0; channel < 4; channel++) {
+                    const int expectedChannel = expected[x] >> (channel * 8) & 0xFF;
+                    const int actualChannel = actual[x] >> (channel * 8) & 0xFF;
+                    ASSERT_NEAR(expectedChannel, actualChannel, TOLERANCE) << "pixel " << x << ", channel " << channel;
+                }
+            }
+        }
+};
+
+TEST_F(NtscFilterTest, MatchesReferenceDecoder)
+{
+    NtscFilter filter;
+    std::vector<u16> entries(NtscFilter::INPUT_WIDTH);
+    for (unsigned x = 0; x < entries.size(); x++) {
+        // Runs of colors of varying length, emphasis bits change every 64 pixels
+        entries[x] = static_cast<u16>((x * 7 / 5 + x / 11) % 64 | (x / 64 % 8) << 6);
+    }
+    entries[100] = 0x1FD;
+    for (unsigned row : { 0u, 1u, 2u, 100u }) {
+        expectNear(referenceRow(entries, row), filterRow(filter, entries, row));
+    }
+}
+
+TEST_F(NtscFilterTest, FlatColors)
+{
+    NtscFilter filter;
+    const auto flatRow = [&](u16 entry) {
+        return filterRow(filter, std::vector<u16>(NtscFilter::INPUT_WIDTH, entry), 0)[NtscFilter::OUTPUT_WIDTH / 2];
+    };
+    EXPECT_EQ(0xFF000000u, flatRow(0x0F));
+    EXPECT_EQ(0xFFFFFFFFu, flatRow(0x20));
+    // Emphasizing all colors darkens the whole signal
+    const auto emphasized = flatRow(0x1C0 | 0x20);
+    for (unsigned channel = 0; channel < 3; channel++) {
+        EXPECT_LT(emphasized >> (channel * 8) & 0xFF, 0xF0u) << "channel " << channel;
+    }
+    for (u16 entry : { 0x16, 0x2A, 0x1F0, 0x0D }) {
+        expectNear(referenceRow(std::vector<u16>(NtscFilter::INPUT_WIDTH, entry), 0),
+            filterRow(filter, std::vector<u16>(NtscFilter::INPUT_WIDTH, entry), 0));
+    }
+}
+
+TEST_F(NtscFilterTest, RowRange)
+{
+    NtscFilter filter;
+    std::vector<u8> frame(Ppu::BUFFER_SIZE * sizeof(u16));
+    for (unsigned i = 0; i < Ppu::BUFFER_SIZE; i++) {
+        const u16 entry = static_cast<u16>(i * 37 % 0x200);
+        std::memcpy(frame.data() + i * sizeof(u16), &entry, sizeof(u16));
+    }
+    std::vector<u32> whole(NtscFilter::OUTPUT_WIDTH * Ppu::SCREEN_HEIGHT);
+    filter.apply(frame.data(), 0, Ppu::SCREEN_HEIGHT, whole.data());
+    // Rows keep the phase of their position in the frame, no matter where the range starts
+    std::vector<u32> range(NtscFilter::OUTPUT_WIDTH * 5);
+    filter.apply(frame.data(), 101, 5, range.data());
+    EXPECT_TRUE(std::equal(range.begin(), range.end(), whole.begin() + 101 * NtscFilter::OUTPUT_WIDTH));
+}
@@ -0,0 +1,179 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <fstream>
+
+#include "../src/core/Ppu.hpp"
+#include "../src/core/Cartridge.hpp"
+
+/**
+ * Renders frames with PPU driven directly through its registers.
+ * Cartridge is only used for its CHR-RAM, so that the test can upload its own patterns.
+ */
+class PpuConfigTest : public ::testing::Test
+{
+    protected:
+        static constexpr const u8 BACKDROP_COLOR = 0x21;
+        static constexpr const u8 SPRITE_COLOR = 0x16;
+        static constexpr const unsigned SPRITE_COUNT = 16;
+        static constexpr const u8 SPRITE_Y = 49;
+
+        PpuConfigTest() = default;
+
+        ~PpuConfigTest() = default;
+
+        void SetUp() override
+        {
+            cartridge = std::make_shared<Cartridge>();
+            ASSERT_TRUE(cartridge->loadFromFile(std::ifstream("resources/ppu_tests/palette_ram.nes", std::ios::binary)));
+            ppu = std::make_unique<Ppu>(cartridge, []() {}, []() {});
+        }
+
+        void TearDown() override
+        {
+        }
+
+        void writeVram(u16 addr, u8 value)
+        {
+            ppu->write(6, addr >> 8);
+            ppu->write(6, addr & 0xFF);
+            ppu->write(7, value);
+        }
+
+        /**
+         * Places 16 opaque sprites next to each other on the same rows.
+         */
+        void setUpScene()
+        {
+            // Tile 1 of the first pattern table is fully opaque
+            for (u16 row = 0; row < 8; row++) {
+                writeVram(0x10 + row, 0xFF);
+            }
+            writeVram(0x3F00, BACKDROP_COLOR);
+            writeVram(0x3F11, SPRITE_COLOR);
+            ppu->write(3, 0);
+            for (unsigned sprite = 0; sprite < 64; sprite++) {
+                const bool visible = sprite < SPRITE_COUNT;
+                ppu->write(4, visible ? SPRITE_Y : 0xFF);
+                ppu->write(4, visible ? 1 : 0);
+                ppu->write(4, 0);
+                ppu->write(4, visible ? sprite * 16 : 0);
+            }
+            ppu->write(6, 0);
+            ppu->write(6, 0);
+            ppu->write(5, 0);
+            ppu->write(5, 0);
+            ppu->write(0, 0);
+            // Background and sprites are enabled, including the left column
+            ppu->write(1, 0x1E);
+        }
+
+        const Ppu::Framebuffer& renderFrame()
+        {
+            while (!ppu->hasNewFrame()) {
+                ppu->tick();
+            }
+            return ppu->getFramebuffer();
+        }
+
+        unsigned countSpritePixels(const Ppu::Framebuffer& framebuffer, unsigned row)
+        {
+            const auto* pixels = framebuffer.data() + row * Ppu::SCREEN_WIDTH;
+            return static_cast<unsigned>(std::count(pixels, pixels + Ppu::SCREEN_WIDTH, SPRITE_COLOR));
+        }
+
+        bool spriteOverflow()
+        {
+            return ppu->read(2) & 0x20;
+        }
+
+        std::shared_ptr<Cartridge> cartridge;
+        std::unique_ptr<Ppu> ppu;
+};
+
+TEST_F(PpuConfigTest, HardwareSpriteLimit)
+{
+    setUpScene();
+    const auto& framebuffer = renderFrame();
+    EXPECT_EQ(64, countSpritePixels(framebuffer, SPRITE_Y + 1));
+    EXPECT_EQ(0, countSpritePixels(framebuffer, SPRITE_Y));
+    EXPECT_TRUE(spriteOverflow());
+}
+
+TEST_F(PpuConfigTest, ExtendedSpriteLimit)
+{
+    ppu->setConfig(PpuConfig { .spriteLimit = 12 });
+    setUpScene();
+    const auto& framebuffer = renderFrame();
+    for (unsigned row = SPRITE_Y + 1; row < SPRITE_Y + 9u; row++) {
+        EXPECT_EQ(12 * 8, countSpritePixels(framebuffer, row)) << "row " << row;
+    }
+    // Games still see that there are more than 8 sprites on a scanline
+    EXPECT_TRUE(spriteOverflow());
+}
+
+TEST_F(PpuConfigTest, SpriteLimitIsClamped)
+{
+    ppu->setConfig(PpuConfig { .spriteLimit = 1000 });
+    EXPECT_EQ(Ppu::MAX_SPRITES_PER_SCANLINE, ppu->getConfig().spriteLimit);
+    ppu->setConfig(PpuConfig { .spriteLimit = 0 });
+    EXPECT_EQ(Ppu::HARDWARE_SPRITE_LIMIT, ppu->getConfig().spriteLimit);
+    setUpScene();
+    EXPECT_EQ(64, countSpritePixels(renderFrame(), SPRITE_Y + 1));
+}
+
+TEST_F(PpuConfigTest, CroppedRowsAreNotRendered)
+{
+    setUpScene();
+    // All three frames of the triple buffer are rendered with the full window first
+    for (unsigned i = 0; i < 3; i++) {
+        renderFrame();
+    }
+    ppu->setConfig(PpuConfig { .firstVisibleRow = 8, .visibleRowCount = 224 });
+    // Frame held by the presenter is left alone, the frames are cleared as they are rendered again
+    EXPECT_EQ(BACKDROP_COLOR, ppu->getFrame().pixels[Ppu::SCREEN_WIDTH - 1]);
+    for (unsigned i = 0; i < 4; i++) {
+        renderFrame();
+        const auto& frame = ppu->getFrame();
+        for (unsigned row = 0; row < Ppu::SCREEN_HEIGHT; row++) {
+            const bool visible = row >= 8 && row < 232;
+            const auto* pixels = frame.pixels.data() + row * Ppu::SCREEN_WIDTH;
+            EXPECT_EQ(visible ? BACKDROP_COLOR : 0, pixels[Ppu::SCREEN_WIDTH - 1]) << "frame " << i << ", row " << row;
+            if (!visible) {
+                EXPECT_TRUE(std::all_of(pixels, pixels + Ppu::SCREEN_WIDTH, [](u8 pixel) { return pixel == 0; }))
+                    << "frame " << i << ", row " << row;
+                EXPECT_EQ(frame.rowHashes[0], frame.rowHashes[row]) << "frame " << i << ", row " << row;
+            }
+        }
+        EXPECT_NE(frame.rowHashes[0], frame.rowHashes[8]) << "frame " << i;
+        EXPECT_EQ(64, countSpritePixels(frame.pixels, SPRITE_Y + 1)) << "frame " << i;
+    }
+}
+
+TEST_F(PpuConfigTest, CroppedRowsAreClearedWhenFormatChanges)
+{
+    ppu->setConfig(PpuConfig { .firstVisibleRow = 8, .visibleRowCount = 224 });
+    ppu->setOutputFormat(PpuOutputFormat::Rgba32);
+    setUpScene();
+    for (unsigned i = 0; i < 3; i++) {
+        renderFrame();
+    }
+    // Rows cropped in the narrower format lie where visible rows of the wider format were
+    ppu->setOutputFormat(PpuOutputFormat::Indexed9);
+    const auto rowSize = Ppu::SCREEN_WIDTH * 2;
+    for (unsigned i = 0; i < 3; i++) {
+        renderFrame();
+        const auto& frame = ppu->getFrame();
+        ASSERT_EQ(PpuOutputFormat::Indexed9, frame.format);
+        for (unsigned row = 0; row < Ppu::SCREEN_HEIGHT; row++) {
+            const bool visible = row >= 8 && row < 232;
+            const auto* pixels = frame.pixels.data() + row * rowSize;
+            if (!visible) {
+                EXPECT_TRUE(std::all_of(pixels, pixels + rowSize, [](u8 pixel) { return pixel == 0; }))
+                    << "frame " << i << ", row " << row;
+                EXPECT_EQ(frame.rowHashes[0], frame.rowHashes[row]) << "frame " << i << ", row " << row;
+            }
+        }
+        EXPECT_NE(frame.rowHashes[0], frame.rowHashes[8]) << "frame " << i;
+    }
+}
@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <vector>
+
+#include "../src/core/Ppu.hpp"
+#include "../src/core/PpuObservation.hpp"
+#include "../src/core/PpuPalette.hpp"
+#include "../src/core/Cartridge.hpp"
+
+class PpuObservationTest : public ::testing::Test
+{
+    protected:
+        static constexpr const unsigned PICTURE_WIDTH = 256;
+        static constexpr const unsigned PICTURE_HEIGHT = 240;
+
+        PpuObservationTest() = default;
+
+        ~PpuObservationTest() = default;
+
+        static void feedFrame(PpuObservation& observation, const std::function<u8(unsigned, unsigned)>& luma)
+        {
+            for (unsigned y = 0; y < PICTURE_HEIGHT; y++) {
+                for (unsigned x = 0; x < PICTURE_WIDTH; x++) {
+                    observation.addPixel(x, y, luma(x, y));
+                }
+            }
+            observation.finishFrame();
+        }
+
+        /**
+         * Renders a single frame of backdrop color only, with the observation attached.
+         */
+        static void renderBackdrop(PpuRenderMode renderMode, const std::shared_ptr<PpuObservation>& observation, u8 color)
+        {
+            auto cartridge = std::make_shared<Cartridge>();
+            ASSERT_TRUE(cartridge->loadFromFile(std::ifstream("resources/ppu_tests/palette_ram.nes", std::ios::binary)));
+            bool vblank = false;
+            Ppu ppu(cartridge, []() {}, [&]() { vblank = true; });
+            ppu.setRenderMode(renderMode);
+            ppu.setObservation(observation);
+            ppu.write(6, 0x3F);
+            ppu.write(6, 0x00);
+            ppu.write(7, color);
+            ppu.write(6, 0);
+            ppu.write(6, 0);
+            ppu.write(1, 0x0A);
+            while (!vblank) {
+                ppu.tick();
+            }
+        }
+};
+
+TEST_F(PpuObservationTest, Size)
+{
+    std::vector<u8> buffer(84 * 84);
+    PpuObservation observation(buffer.data(), 84, 84);
+    EXPECT_EQ(84, observation.getWidth());
+    EXPECT_EQ(84, observation.getHeight());
+    feedFrame(observation, [](unsigned, unsigned) { return 77; });
+    EXPECT_TRUE(std::all_of(buffer.begin(), buffer.end(), [](u8 value) { return value == 77; }));
+    // Observation can't be larger than the picture or empty
+    std::vector<u8> largeBuffer(PICTURE_WIDTH * PICTURE_HEIGHT);
+    PpuObservation large(largeBuffer.data(), 1000, 0);
+    EXPECT_EQ(PICTURE_WIDTH, large.getWidth());
+    EXPECT_EQ(1, large.getHeight());
+}
+
+TEST_F(PpuObservationTest, AreaAverage)
+{
+    std::vector<u8> buffer(2 * 2);
+    PpuObservation observation(buffer.data(), 2, 2);
+    // Left half black, right half at 200, except of the lower right quarter, which is striped
+    feedFrame(observation, [](unsigned x, unsigned y) -> u8 {
+        if (x < 128) {
+            return 0;
+        }
+        return y < 120 ? 200 : (x % 2 ? 100 : 50);
+    });
+    EXPECT_EQ(std::vector<u8>({ 0, 200, 0, 75 }), buffer);
+
+    // 84 columns don't divide the picture evenly, each observation pixel averages the pixels it covers
+    std::vector<u8> buffer84(84 * 84);
+    PpuObservation observation84(buffer84.data(), 84, 84);
+    feedFrame(observation84, [](unsigned x, unsigned) { return static_cast<u8>(x); });
+    for (unsigned column = 0; column < 84; column++) {
+        unsigned sum = 0;
+        unsigned count = 0;
+        for (unsigned x = 0; x < PICTURE_WIDTH; x++) {
+            if (x * 84 / PICTURE_WIDTH == column) {
+                sum += x;
+                count++;
+            }
+        }
+        EXPECT_EQ(sum / count, buffer84[column]) << "column " << column;
+        EXPECT_EQ(sum / count, buffer84[83 * 84 + column]) << "column " << column;
+    }
+}
+
+TEST_F(PpuObservationTest, Strided)
+{
+    std::vector<u8> buffer(84 * 84);
+    PpuObservation observation(buffer.data(), 84, 84, PpuObservationMode::Strided);
+    feedFrame(observation, [](unsigned x, unsigned y) { return static_cast<u8>(x ^ y); });
+    // Each observation pixel is the picture pixel in the middle of the area it covers
+    for (unsigned row = 0; row < 84; row++) {
+        for (unsigned column = 0; column < 84; column++) {
+            const auto x = (2 * column + 1) * PICTURE_WIDTH / (2 * 84);
+            const auto y = (2 * row + 1) * PICTURE_HEIGHT / (2 * 84);
+            ASSERT_EQ(static_cast<u8>(x ^ y), buffer[row * 84 + column]) << "row " << row << ", column " << column;
+        }
+    }
+}
+
+TEST_F(PpuObservationTest, MaxPooling)
+{
+    std::vector<u8> buffer(4 * 4);
+    PpuObservation observation(buffer.data(), 4, 4, PpuObservationMode::AreaAverage, true);
+    // Object drawn every other frame, in one half of the picture
+    feedFrame(observation, [](unsigned x, unsigned) { return x < 128 ? 180 : 10; });
+    EXPECT_EQ(180, buffer[0]);
+    EXPECT_EQ(10, buffer[3]);
+    feedFrame(observation, [](unsigned x, unsigned) { return x < 128 ? 10 : 90; });
+    for (unsigned row = 0; row < 4; row++) {
+        EXPECT_EQ(180, buffer[row * 4]);
+        EXPECT_EQ(90, buffer[row * 4 + 3]);
+    }
+    // Only the two last frames are taken into account
+    feedFrame(observation, [](unsigned, unsigned) { return 0; });
+    EXPECT_EQ(10, buffer[0]);
+    EXPECT_EQ(90, buffer[3]);
+}
+
+TEST_F(PpuObservationTest, FedInEveryRenderMode)
+{
+    static constexpr const u8 BACKDROP_COLOR = 0x21;
+    const u8 expected = PpuPalette::luma()[BACKDROP_COLOR];
+    for (auto renderMode : { PpuRenderMode::Full, PpuRenderMode::TimingOnly }) {
+        std::vector<u8> buffer(84 * 84, 0);
+        renderBackdrop(renderMode, std::make_shared<PpuObservation>(buffer.data(), 84, 84), BACKDROP_COLOR);
+        EXPECT_TRUE(std::all_of(buffer.begin(), buffer.end(), [&](u8 value) { return value == expected; }))
+            << "render mode " << static_cast<int>(renderMode);
+    }
+}
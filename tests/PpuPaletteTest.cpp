@@ -0,0 +1,128 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <fstream>
+
+#include "../src/core/Ppu.hpp"
+#include "../src/core/PpuPalette.hpp"
+#include "../src/core/Cartridge.hpp"
+
+namespace
+{
+    constexpr const unsigned ATTENUATION = 209;
+
+    u8 channel(u32 rgba, unsigned index)
+    {
+        return static_cast<u8>(rgba >> (index * 8));
+    }
+
+    u8 attenuate(u8 value)
+    {
+        return static_cast<u8>(value * ATTENUATION >> 8);
+    }
+}
+
+TEST(PpuPaletteTest, BaseColors)
+{
+    const auto& rgba32 = PpuPalette::rgba32();
+    EXPECT_EQ(0xFF666666, rgba32[0x00]);
+    EXPECT_EQ(0xFF882A00, rgba32[0x01]);
+    EXPECT_EQ(0xFFFFFEFF, rgba32[0x30]);
+    EXPECT_EQ(0xFF000000, rgba32[0x0F]);
+}
+
+TEST(PpuPaletteTest, Emphasis)
+{
+    const auto& rgba32 = PpuPalette::rgba32();
+    for (u8 color : { 0x00, 0x16, 0x2A, 0x30 }) {
+        const auto base = rgba32[color];
+        // Each emphasis bit darkens both channels that it doesn't emphasize
+        const auto red = rgba32[0x40 | color];
+        EXPECT_EQ(channel(base, 0), channel(red, 0));
+        EXPECT_EQ(attenuate(channel(base, 1)), channel(red, 1));
+        EXPECT_EQ(attenuate(channel(base, 2)), channel(red, 2));
+        const auto green = rgba32[0x80 | color];
+        EXPECT_EQ(attenuate(channel(base, 0)), channel(green, 0));
+        EXPECT_EQ(channel(base, 1), channel(green, 1));
+        EXPECT_EQ(attenuate(channel(base, 2)), channel(green, 2));
+        // Attenuation is applied once per bit that darkens the channel
+        const auto redBlue = rgba32[0x140 | color];
+        EXPECT_EQ(attenuate(channel(base, 0)), channel(redBlue, 0));
+        EXPECT_EQ(attenuate(attenuate(channel(base, 1))), channel(redBlue, 1));
+        EXPECT_EQ(attenuate(channel(base, 2)), channel(redBlue, 2));
+        const auto all = rgba32[0x1C0 | color];
+        for (unsigned i = 0; i < 3; i++) {
+            EXPECT_EQ(attenuate(attenuate(channel(base, i))), channel(all, i));
+        }
+        EXPECT_EQ(0xFF, channel(all, 3));
+    }
+}
+
+TEST(PpuPaletteTest, Rgb565Packing)
+{
+    const auto& rgba32 = PpuPalette::rgba32();
+    const auto& rgb565 = PpuPalette::rgb565();
+    for (unsigned i = 0; i < PpuPalette::COLOR_COUNT; i++) {
+        const auto rgba = rgba32[i];
+        const u16 expected = static_cast<u16>((channel(rgba, 0) >> 3) << 11 | (channel(rgba, 1) >> 2) << 5 | channel(rgba, 2) >> 3);
+        ASSERT_EQ(expected, rgb565[i]) << "color " << i;
+    }
+    EXPECT_EQ(0xFFFF, rgb565[0x30]);
+    EXPECT_EQ(0x0000, rgb565[0x0F]);
+}
+
+TEST(PpuPaletteTest, Luma)
+{
+    const auto& rgba32 = PpuPalette::rgba32();
+    const auto& luma = PpuPalette::luma();
+    for (unsigned i : { 0x00u, 0x16u, 0x30u, 0x1EAu }) {
+        const auto rgba = rgba32[i];
+        EXPECT_EQ((299 * channel(rgba, 0) + 587 * channel(rgba, 1) + 114 * channel(rgba, 2) + 500) / 1000, luma[i]);
+    }
+}
+
+TEST(PpuPaletteTest, OutputColor)
+{
+    using enum PpuOutputFormat;
+    // Greyscale keeps only the row of the palette, emphasis bits are placed above the color index
+    EXPECT_EQ(0x16, PpuPalette::outputColor(0x16, 0x00, Indexed9));
+    EXPECT_EQ(0x10, PpuPalette::outputColor(0x16, 0x01, Indexed9));
+    EXPECT_EQ(0x1D6, PpuPalette::outputColor(0x16, 0xE0, Indexed9));
+    EXPECT_EQ(0x150, PpuPalette::outputColor(0x16, 0xA1, Indexed9));
+    EXPECT_EQ(0x10, PpuPalette::outputColor(0x16, 0xA1, Indexed8));
+    EXPECT_EQ(PpuPalette::rgba32()[0x150], PpuPalette::outputColor(0x16, 0xA1, Rgba32));
+    EXPECT_EQ(PpuPalette::rgb565()[0x150], PpuPalette::outputColor(0x16, 0xA1, Rgb565));
+}
+
+/**
+ * Renders a frame with the backdrop color only, greyscale and emphasis enabled, in each of the output formats.
+ */
+TEST(PpuPaletteTest, FramebufferFormats)
+{
+    auto cartridge = std::make_shared<Cartridge>();
+    ASSERT_TRUE(cartridge->loadFromFile(std::ifstream("resources/ppu_tests/palette_ram.nes", std::ios::binary)));
+    static constexpr const u8 BACKDROP_COLOR = 0x27;
+    static constexpr const u8 PPU_MASK = 0x0B | 0xA0;
+    for (auto format : { PpuOutputFormat::Indexed8, PpuOutputFormat::Indexed9, PpuOutputFormat::Rgba32, PpuOutputFormat::Rgb565 }) {
+        Ppu ppu(cartridge, []() {}, []() {});
+        ppu.setOutputFormat(format);
+        ppu.write(6, 0x3F);
+        ppu.write(6, 0x00);
+        ppu.write(7, BACKDROP_COLOR);
+        ppu.write(6, 0);
+        ppu.write(6, 0);
+        ppu.write(1, PPU_MASK);
+        while (!ppu.hasNewFrame()) {
+            ppu.tick();
+        }
+        const auto& frame = ppu.getFrame();
+        EXPECT_EQ(format, frame.format);
+        const auto bytesPerPixel = Ppu::getBytesPerPixel(format);
+        const auto expected = PpuPalette::outputColor(BACKDROP_COLOR, PPU_MASK, format);
+        for (unsigned position : { 0u, 1000u, Ppu::BUFFER_SIZE - 1 }) {
+            u32 pixel = 0;
+            std::memcpy(&pixel, frame.pixels.data() + position * bytesPerPixel, bytesPerPixel);
+            EXPECT_EQ(expected, pixel) << "format " << static_cast<int>(format) << ", pixel " << position;
+        }
+    }
+}
@@ -0,0 +1,73 @@
+#include "util/BlarggRomTest.hpp"
+
+/**
+ * Runs the blargg PPU test ROMs with prediction check enabled.
+ * Every sprite 0 hit and VBlank has to happen exactly at the dot that was predicted last.
+ */
+class PpuPredictionTest : public BlarggRomTest
+{
+    protected:
+        PpuPredictionTest() = default;
+
+        ~PpuPredictionTest() = default;
+
+        void check(const std::string& romFileName)
+        {
+            auto ppu = systemUnderTest->getPpu();
+            ppu->setPredictionCheck(true);
+            auto result = run(romFileName);
+            ASSERT_EQ(0, result) << (result == 0x100 ? "Failed to load ROM" : readMessage());
+            EXPECT_GT(ppu->getPredictionCheckCount(), 0);
+            EXPECT_EQ(0, ppu->getPredictionMismatchCount());
+        }
+};
+
+TEST_F(PpuPredictionTest, Alignment)
+{
+    check("resources/ppu_sprite_hit/alignment.nes");
+}
+
+TEST_F(PpuPredictionTest, Basics)
+{
+    check("resources/ppu_sprite_hit/basics.nes");
+}
+
+TEST_F(PpuPredictionTest, Corners)
+{
+    check("resources/ppu_sprite_hit/corners.nes");
+}
+
+TEST_F(PpuPredictionTest, DoubleHeight)
+{
+    check("resources/ppu_sprite_hit/double_height.nes");
+}
+
+TEST_F(PpuPredictionTest, Flip)
+{
+    check("resources/ppu_sprite_hit/flip.nes");
+}
+
+TEST_F(PpuPredictionTest, LeftClip)
+{
+    check("resources/ppu_sprite_hit/left_clip.nes");
+}
+
+TEST_F(PpuPredictionTest, RightEdge)
+{
+    check("resources/ppu_sprite_hit/right_edge.nes");
+}
+
+TEST_F(PpuPredictionTest, ScreenBottom)
+{
+    check("resources/ppu_sprite_hit/screen_bottom.nes");
+}
+
+TEST_F(PpuPredictionTest, EvenOddFrames)
+{
+    check("resources/ppu_vbl_nmi/even_odd_frames.nes");
+}
+
+TEST_F(PpuPredictionTest, VblankBasics)
+{
+    check("resources/ppu_vbl_nmi/vbl_basics.nes");
+}
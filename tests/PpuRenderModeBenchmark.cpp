@@ -0,0 +1,85 @@
+#include "util/BlarggRomTest.hpp"
+
+#include <chrono>
+
+/**
+ * Compares how long it takes to run the blargg PPU test ROMs in each of the PPU render modes.
+ * ROM has to pass in every mode, times are reported as test properties.
+ * Benchmarks are disabled, they are run with --gtest_also_run_disabled_tests.
+ */
+class PpuRenderModeBenchmark : public BlarggRomTest
+{
+    protected:
+        PpuRenderModeBenchmark() = default;
+
+        ~PpuRenderModeBenchmark() = default;
+
+        double measure(const std::string& romFileName, PpuRenderMode renderMode)
+        {
+            // Every run starts with a freshly created system
+            systemUnderTest = std::make_unique<SystemUnderTest>();
+            auto start = std::chrono::steady_clock::now();
+            auto result = run(romFileName, renderMode);
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            EXPECT_EQ(0, result) << "render mode " << static_cast<int>(renderMode) << ": "
+                << (result == 0x100 ? "Failed to load ROM" : readMessage());
+            return elapsed.count();
+        }
+
+        void benchmark(const std::string& romFileName)
+        {
+            RecordProperty("FullMs", std::to_string(measure(romFileName, PpuRenderMode::Full)));
+            RecordProperty("TimingOnlyMs", std::to_string(measure(romFileName, PpuRenderMode::TimingOnly)));
+            RecordProperty("DeferredMs", std::to_string(measure(romFileName, PpuRenderMode::Deferred)));
+        }
+};
+
+TEST_F(PpuRenderModeBenchmark, DISABLED_Alignment)
+{
+    benchmark("resources/ppu_sprite_hit/alignment.nes");
+}
+
+TEST_F(PpuRenderModeBenchmark, DISABLED_Basics)
+{
+    benchmark("resources/ppu_sprite_hit/basics.nes");
+}
+
+TEST_F(PpuRenderModeBenchmark, DISABLED_Corners)
+{
+    benchmark("resources/ppu_sprite_hit/corners.nes");
+}
+
+TEST_F(PpuRenderModeBenchmark, DISABLED_DoubleHeight)
+{
+    benchmark("resources/ppu_sprite_hit/double_height.nes");
+}
+
+TEST_F(PpuRenderModeBenchmark, DISABLED_Flip)
+{
+    benchmark("resources/ppu_sprite_hit/flip.nes");
+}
+
+TEST_F(PpuRenderModeBenchmark, DISABLED_LeftClip)
+{
+    benchmark("resources/ppu_sprite_hit/left_clip.nes");
+}
+
+TEST_F(PpuRenderModeBenchmark, DISABLED_RightEdge)
+{
+    benchmark("resources/ppu_sprite_hit/right_edge.nes");
+}
+
+TEST_F(PpuRenderModeBenchmark, DISABLED_ScreenBottom)
+{
+    benchmark("resources/ppu_sprite_hit/screen_bottom.nes");
+}
+
+TEST_F(PpuRenderModeBenchmark, DISABLED_EvenOddFrames)
+{
+    benchmark("resources/ppu_vbl_nmi/even_odd_frames.nes");
+}
+
+TEST_F(PpuRenderModeBenchmark, DISABLED_VblankBasics)
+{
+    benchmark("resources/ppu_vbl_nmi/vbl_basics.nes");
+}
@@ -0,0 +1,229 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <fstream>
+#include <functional>
+#include <numeric>
+#include <vector>
+
+#include "util/PpuScene.hpp"
+#include "util/SystemUnderTest.hpp"
+#include "../src/core/ThreadSupport.hpp"
+
+/**
+ * Renders the shared scene with the PPU driven directly through its registers.
+ */
+class PpuRenderModeTest : public ::testing::Test
+{
+    protected:
+        static constexpr const unsigned TICKS_PER_FRAME = 341 * 262;
+
+        /**
+         * Published frames, concatenated.
+         */
+        struct RenderedFrames
+        {
+            std::vector<u8> pixels;
+            std::vector<u32> rowHashes;
+            std::vector<u64> hitTicks;
+            unsigned frameCount = 0;
+
+            void add(const Ppu::Frame& frame)
+            {
+                pixels.insert(pixels.end(), frame.pixels.begin(), frame.pixels.end());
+                rowHashes.insert(rowHashes.end(), frame.rowHashes.begin(), frame.rowHashes.end());
+                frameCount++;
+            }
+        };
+
+        PpuRenderModeTest() = default;
+
+        ~PpuRenderModeTest() = default;
+
+        /**
+         * Deferred frames are rendered on the emulation thread, and on worker threads when they are available.
+         */
+        static std::vector<unsigned> renderThreadCounts()
+        {
+            if (!WASM_NES_THREADS) {
+                return { 0 };
+            }
+            return { 0, 3 };
+        }
+
+        static void startRendering(PpuScene& scene, PpuRenderMode renderMode)
+        {
+            scene.setUp();
+            scene.getPpu().setRenderMode(renderMode);
+            // Background and sprites are enabled, including the left column
+            scene.getPpu().write(1, 0x1E);
+        }
+};
+
+/**
+ * Nothing is rendered nor presented in the timing only mode,
+ * but the program has to see sprite 0 hit at the same time as with the full rendering.
+ */
+TEST_F(PpuRenderModeTest, TimingOnlyKeepsSpriteZeroHit)
+{
+    static constexpr const std::array<PpuRenderMode, 2> RENDER_MODES = { PpuRenderMode::Full, PpuRenderMode::TimingOnly };
+    std::array<std::vector<u64>, 2> hitTicks;
+    std::array<unsigned, 2> presentedFrameCounts = {};
+    for (unsigned i = 0; i < RENDER_MODES.size(); i++) {
+        PpuScene scene;
+        auto& ppu = scene.getPpu();
+        startRendering(scene, RENDER_MODES[i]);
+        bool hit = false;
+        for (u64 tick = 0; tick < 4 * TICKS_PER_FRAME; tick++) {
+            ppu.tick();
+            const bool spriteZeroHit = ppu.read(2) & 0x40;
+            if (spriteZeroHit && !hit) {
+                hitTicks[i].push_back(tick);
+            }
+            hit = spriteZeroHit;
+            if (ppu.hasNewFrame()) {
+                ppu.getFrame();
+                presentedFrameCounts[i]++;
+            }
+        }
+    }
+    EXPECT_GE(hitTicks[0].size(), 3);
+    EXPECT_EQ(hitTicks[0], hitTicks[1]);
+    EXPECT_GE(presentedFrameCounts[0], 3);
+    EXPECT_EQ(0, presentedFrameCounts[1]);
+}
+
+/**
+ * Scanline callback has to see every row of the frame in order, with the same pixels that are published afterwards.
+ */
+TEST_F(PpuRenderModeTest, ScanlineCallback)
+{
+    PpuScene scene;
+    auto& ppu = scene.getPpu();
+    ppu.setOutputFormat(PpuOutputFormat::Rgba32);
+    const auto rowSize = Ppu::SCREEN_WIDTH * Ppu::getBytesPerPixel(PpuOutputFormat::Rgba32);
+    std::vector<unsigned> scanlines;
+    std::vector<u8> pixels;
+    ppu.setScanlineCallback([&](unsigned scanline, const u8* row) {
+        scanlines.push_back(scanline);
+        pixels.insert(pixels.end(), row, row + rowSize);
+    });
+    startRendering(scene, PpuRenderMode::Full);
+
+    std::vector<unsigned> expectedScanlines(Ppu::SCREEN_HEIGHT);
+    std::iota(expectedScanlines.begin(), expectedScanlines.end(), 0);
+    for (unsigned frameNumber = 0; frameNumber < 3; frameNumber++) {
+        while (!ppu.hasNewFrame()) {
+            ppu.tick();
+        }
+        const auto& frame = ppu.getFrame();
+        ASSERT_EQ(expectedScanlines, scanlines) << "frame " << frameNumber;
+        EXPECT_TRUE(std::equal(pixels.begin(), pixels.end(), frame.pixels.begin())) << "frame " << frameNumber;
+        scanlines.clear();
+        pixels.clear();
+    }
+}
+
+/**
+ * Deferred frames are rendered in bands from the log of the accesses, 
+ * so they have to be identical to the frames rendered dot by dot, raster effects included.
+ * Bands are rendered both on the emulation thread and on the workers, when threads are available.
+ */
+TEST_F(PpuRenderModeTest, DeferredMatchesFull)
+{
+    // Accesses done in every frame, at the given tick since the start of the frame.
+    // Ticks are counted the same way in all modes, so the accesses happen at the same dots.
+    struct Access
+    {
+        unsigned tick;
+        std::function<void(Ppu&)> perform;
+    };
+    static constexpr auto dot = [](unsigned scanline, unsigned dot) {
+        return scanline * 341 + dot;
+    };
+    const std::vector<Access> accesses = {
+        // Scroll changes, the one in the middle of the scanline only affects the next one
+        { dot(37, 100), [](Ppu& ppu) { ppu.read(2); ppu.write(5, 0x23); ppu.write(5, 0x10); } },
+        // Split through PPUADDR in horizontal blank
+        { dot(61, 258), [](Ppu& ppu) { ppu.write(6, 0x21); ppu.write(6, 0x48); } },
+        { dot(95, 20), [](Ppu& ppu) { ppu.write(1, 0x1A); } },
+        { dot(130, 300), [](Ppu& ppu) { ppu.write(1, 0x1E); } },
+        // Palette write in the middle of the frame, it also corrupts the scroll
+        { dot(150, 270), [](Ppu& ppu) { ppu.write(6, 0x3F); ppu.write(6, 0x01); ppu.write(7, 0x2A); } },
+        { dot(170, 5), [](Ppu& ppu) { ppu.read(7); } },
+        { dot(200, 270), [](Ppu& ppu) { ppu.write(0, 0x18); } },
+        { dot(220, 10), [](Ppu& ppu) { ppu.write(3, 0x0D); ppu.write(4, 0x07); } },
+        // Pattern write during rendering, only lands in CHR-RAM when address happens to point there
+        { dot(229, 280), [](Ppu& ppu) { ppu.write(6, 0x00); ppu.write(6, 0x12); ppu.write(7, 0xFF); } },
+        // Usual setup done during vertical blank
+        { dot(245, 0), [](Ppu& ppu) { ppu.write(0, 0x00); ppu.write(5, 0x00); ppu.write(5, 0x00); } }
+    };
+
+    const auto render = [&accesses](PpuRenderMode renderMode, unsigned threadCount) {
+        PpuScene scene;
+        auto& ppu = scene.getPpu();
+        ppu.setRenderThreadCount(threadCount);
+        ppu.setOutputFormat(PpuOutputFormat::Rgba32);
+        startRendering(scene, renderMode);
+        RenderedFrames rendered;
+        bool hit = false;
+        for (u64 tick = 0; tick < 5 * TICKS_PER_FRAME; tick++) {
+            for (const auto& access : accesses) {
+                if (tick % TICKS_PER_FRAME == access.tick) {
+                    access.perform(ppu);
+                }
+            }
+            ppu.tick();
+            const bool spriteZeroHit = ppu.read(2) & 0x40;
+            if (spriteZeroHit && !hit) {
+                rendered.hitTicks.push_back(tick);
+            }
+            hit = spriteZeroHit;
+            if (ppu.hasNewFrame()) {
+                rendered.add(ppu.getFrame());
+            }
+        }
+        return rendered;
+    };
+
+    const auto full = render(PpuRenderMode::Full, 0);
+    EXPECT_EQ(5 * sizeof(Ppu::Framebuffer), full.pixels.size());
+    EXPECT_FALSE(full.hitTicks.empty());
+    for (unsigned threadCount : renderThreadCounts()) {
+        const auto deferred = render(PpuRenderMode::Deferred, threadCount);
+        EXPECT_TRUE(full.pixels == deferred.pixels) << threadCount << " threads";
+        EXPECT_EQ(full.rowHashes, deferred.rowHashes) << threadCount << " threads";
+        EXPECT_EQ(full.hitTicks, deferred.hitTicks) << threadCount << " threads";
+    }
+}
+
+/**
+ * Same as above, with the CPU driving the PPU through a test ROM.
+ */
+TEST_F(PpuRenderModeTest, DeferredMatchesFullOnRom)
+{
+    const auto render = [](PpuRenderMode renderMode, unsigned threadCount) {
+        SystemUnderTest systemUnderTest;
+        auto ppu = systemUnderTest.getPpu();
+        ppu->setRenderThreadCount(threadCount);
+        ppu->setRenderMode(renderMode);
+        EXPECT_TRUE(systemUnderTest.getCartridge()->loadFromFile(
+            std::ifstream("resources/ppu_sprite_hit/flip.nes", std::ios::binary)));
+        systemUnderTest.getCpu()->reset();
+        RenderedFrames rendered;
+        while (rendered.frameCount < 60) {
+            systemUnderTest.getCpu()->step();
+            if (ppu->hasNewFrame()) {
+                rendered.add(ppu->getFrame());
+            }
+        }
+        return rendered;
+    };
+
+    const auto full = render(PpuRenderMode::Full, 0);
+    for (unsigned threadCount : renderThreadCounts()) {
+        const auto deferred = render(PpuRenderMode::Deferred, threadCount);
+        EXPECT_TRUE(full.pixels == deferred.pixels) << threadCount << " threads";
+        EXPECT_EQ(full.rowHashes, deferred.rowHashes) << threadCount << " threads";
+    }
+}
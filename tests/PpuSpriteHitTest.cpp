@@ -1,6 +1,9 @@
 #include "util/BlarggRomTest.hpp"
 
-class PpuSpriteHitTest : public BlarggRomTest
+/**
+ * ROMs are run in each of the PPU render modes that keep the timing visible behaviour.
+ */
+class PpuSpriteHitTest : public BlarggRomTest, public ::testing::WithParamInterface<PpuRenderMode>
 {
     protected:
         PpuSpriteHitTest() = default;
@@ -18,78 +21,83 @@ class PpuSpriteHitTest : public BlarggRomTest
         }
 };
 
-TEST_F(PpuSpriteHitTest, Alignment)
+TEST_P(PpuSpriteHitTest, Alignment)
 {
-    auto result = run("resources/ppu_sprite_hit/alignment.nes");
+    auto result = run("resources/ppu_sprite_hit/alignment.nes", GetParam());
     ASSERT_EQ(0, result) << (result == 0x100 ? "Failed to load ROM" : readMessage());
 }
 
-TEST_F(PpuSpriteHitTest, Basics)
+TEST_P(PpuSpriteHitTest, Basics)
 {
-    auto result = run("resources/ppu_sprite_hit/basics.nes");
+    auto result = run("resources/ppu_sprite_hit/basics.nes", GetParam());
     ASSERT_EQ(0, result) << (result == 0x100 ? "Failed to load ROM" : readMessage());
 }
 
-TEST_F(PpuSpriteHitTest, Corners)
+TEST_P(PpuSpriteHitTest, Corners)
 {
-    auto result = run("resources/ppu_sprite_hit/corners.nes");
+    auto result = run("resources/ppu_sprite_hit/corners.nes", GetParam());
     ASSERT_EQ(0, result) << (result == 0x100 ? "Failed to load ROM" : readMessage());
 }
 
-TEST_F(PpuSpriteHitTest, DoubleHeight)
+TEST_P(PpuSpriteHitTest, DoubleHeight)
 {
-    auto result = run("resources/ppu_sprite_hit/double_height.nes");
+    auto result = run("resources/ppu_sprite_hit/double_height.nes", GetParam());
     ASSERT_EQ(0, result) << (result == 0x100 ? "Failed to load ROM" : readMessage());
 }
 
-TEST_F(PpuSpriteHitTest, EdgeTiming)
+TEST_P(PpuSpriteHitTest, EdgeTiming)
 {
     GTEST_SKIP() << "Skipped due to freezing";
-    auto result = run("resources/ppu_sprite_hit/edge_timing.nes");
+    auto result = run("resources/ppu_sprite_hit/edge_timing.nes", GetParam());
     ASSERT_EQ(0, result) << (result == 0x100 ? "Failed to load ROM" : readMessage());
 }
 
-TEST_F(PpuSpriteHitTest, Flip)
+TEST_P(PpuSpriteHitTest, Flip)
 {
-    auto result = run("resources/ppu_sprite_hit/flip.nes");
+    auto result = run("resources/ppu_sprite_hit/flip.nes", GetParam());
     ASSERT_EQ(0, result) << (result == 0x100 ? "Failed to load ROM" : readMessage());
 }
 
-TEST_F(PpuSpriteHitTest, LeftClip)
+TEST_P(PpuSpriteHitTest, LeftClip)
 {
-    auto result = run("resources/ppu_sprite_hit/left_clip.nes");
+    auto result = run("resources/ppu_sprite_hit/left_clip.nes", GetParam());
     ASSERT_EQ(0, result) << (result == 0x100 ? "Failed to load ROM" : readMessage());
 }
 
-TEST_F(PpuSpriteHitTest, RightEdge)
+TEST_P(PpuSpriteHitTest, RightEdge)
 {
-    auto result = run("resources/ppu_sprite_hit/right_edge.nes");
+    auto result = run("resources/ppu_sprite_hit/right_edge.nes", GetParam());
     ASSERT_EQ(0, result) << (result == 0x100 ? "Failed to load ROM" : readMessage());
 }
 
-TEST_F(PpuSpriteHitTest, ScreenBottom)
+TEST_P(PpuSpriteHitTest, ScreenBottom)
 {
-    auto result = run("resources/ppu_sprite_hit/screen_bottom.nes");
+    auto result = run("resources/ppu_sprite_hit/screen_bottom.nes", GetParam());
     ASSERT_EQ(0, result) << (result == 0x100 ? "Failed to load ROM" : readMessage());
 }
 
-TEST_F(PpuSpriteHitTest, TimingBasics)
+TEST_P(PpuSpriteHitTest, TimingBasics)
 {
     GTEST_SKIP() << "Skipped due to freezing";
-    auto result = run("resources/ppu_sprite_hit/timing_basics.nes");
+    auto result = run("resources/ppu_sprite_hit/timing_basics.nes", GetParam());
     ASSERT_EQ(0, result) << (result == 0x100 ? "Failed to load ROM" : readMessage());
 }
 
-TEST_F(PpuSpriteHitTest, TimingOrder)
+TEST_P(PpuSpriteHitTest, TimingOrder)
 {
     GTEST_SKIP() << "Skipped (Hit time shouldn't be based on pixels at X=255)";
-    auto result = run("resources/ppu_sprite_hit/timing_order.nes");
+    auto result = run("resources/ppu_sprite_hit/timing_order.nes", GetParam());
     ASSERT_EQ(0, result) << (result == 0x100 ? "Failed to load ROM" : readMessage());
 }
 
-TEST_F(PpuSpriteHitTest, Timing)
+TEST_P(PpuSpriteHitTest, Timing)
 {
     GTEST_SKIP() << "Flag set too soon for upper-left corner";
-    auto result = run("resources/ppu_sprite_hit/timing.nes");
+    auto result = run("resources/ppu_sprite_hit/timing.nes", GetParam());
     ASSERT_EQ(0, result) << (result == 0x100 ? "Failed to load ROM" : readMessage());
-}
\ No newline at end of file
+}
+
+INSTANTIATE_TEST_SUITE_P(RenderModes, PpuSpriteHitTest, ::testing::Values(PpuRenderMode::Full, PpuRenderMode::TimingOnly),
+    [](const ::testing::TestParamInfo<PpuRenderMode>& info) {
+        return info.param == PpuRenderMode::Full ? "Full" : "TimingOnly";
+    });
@@ -0,0 +1,56 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "util/PpuScene.hpp"
+
+/**
+ * Checks behaviour of the PPU registers, that is only visible in the rendered picture.
+ */
+class PpuTest : public ::testing::Test
+{
+    protected:
+        PpuTest() = default;
+
+        ~PpuTest() = default;
+
+        /**
+         * Renders the shared scene with scroll set up by the given function, and returns the next complete frame.
+         */
+        template <typename ScrollSetup>
+        static std::vector<u8> renderScene(ScrollSetup scrollSetup)
+        {
+            PpuScene scene;
+            auto& ppu = scene.getPpu();
+            scene.setUp();
+            scrollSetup(scene);
+            // Background is enabled, including the left column
+            ppu.write(1, 0x0A);
+            while (!ppu.hasNewFrame()) {
+                ppu.tick();
+            }
+            const auto& frame = ppu.getFrame();
+            return std::vector<u8>(frame.pixels.begin(), frame.pixels.begin() + Ppu::BUFFER_SIZE);
+        }
+};
+
+/**
+ * Fine X is a separate register on the hardware, second write to PPUADDR copies T into V, but leaves fine X alone.
+ */
+TEST_F(PpuTest, FineXSurvivesSecondPpuAddrWrite)
+{
+    const auto unscrolled = renderScene([](PpuScene& scene) {
+        scene.setScroll(0x00, 0, 0);
+    });
+    const auto scrolled = renderScene([](PpuScene& scene) {
+        scene.setScroll(0x00, 5, 0);
+    });
+    // Coarse scroll is set back to 0 through PPUADDR, only fine X is left from PPUSCROLL
+    const auto scrolledThenAddressed = renderScene([](PpuScene& scene) {
+        scene.setScroll(0x00, 5, 0);
+        scene.getPpu().write(6, 0x00);
+        scene.getPpu().write(6, 0x00);
+    });
+    ASSERT_NE(unscrolled, scrolled);
+    EXPECT_EQ(scrolled, scrolledThenAddressed);
+}
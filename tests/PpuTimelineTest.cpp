@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+
+#include <fstream>
+
+#include "../src/core/PpuTimeline.hpp"
+#include "util/SystemUnderTest.hpp"
+
+TEST(PpuTimelineTest, EventsOfCompletedFrame)
+{
+    using enum PpuTimelineEventType;
+    PpuTimeline timeline;
+    timeline.record(RegisterWrite, 241, 10, 100, 0x2000, 0x80);
+    timeline.record(ChrBankSwitch, 30, 50, 200, 0x8000, 0x03);
+    timeline.record(MirroringChange, 100, 300, 300, 0xA000, 0x01);
+    // Frame in progress is not visible yet
+    EXPECT_TRUE(timeline.getEvents().empty());
+
+    timeline.finishFrame();
+    const auto events = timeline.getEvents();
+    ASSERT_EQ(3, events.size());
+    EXPECT_EQ(RegisterWrite, events[0].type);
+    EXPECT_EQ(241, events[0].scanline);
+    EXPECT_EQ(10, events[0].dot);
+    EXPECT_EQ(100, events[0].cpuCycle);
+    EXPECT_EQ(0x2000, events[0].address);
+    EXPECT_EQ(0x80, events[0].value);
+    EXPECT_EQ(ChrBankSwitch, events[1].type);
+    EXPECT_EQ(MirroringChange, events[2].type);
+    EXPECT_EQ(300, events[2].dot);
+    EXPECT_EQ(0, timeline.getDroppedEventCount());
+
+    // Next frame starts empty
+    timeline.finishFrame();
+    EXPECT_TRUE(timeline.getEvents().empty());
+    EXPECT_EQ(PpuTimeline::VISIBLE_SCANLINES, timeline.getStableScanlineCount());
+}
+
+TEST(PpuTimelineTest, DroppedEvents)
+{
+    PpuTimeline timeline(2);
+    for (unsigned scanline = 0; scanline < 5; scanline++) {
+        timeline.record(PpuTimelineEventType::RegisterWrite, scanline, 0, scanline, 0x2001, 0x1E);
+    }
+    timeline.finishFrame();
+    ASSERT_EQ(2, timeline.getEvents().size());
+    EXPECT_EQ(1, timeline.getEvents()[1].scanline);
+    EXPECT_EQ(3, timeline.getDroppedEventCount());
+    // Dropped events still make their scanlines unstable
+    for (unsigned scanline = 0; scanline < 5; scanline++) {
+        EXPECT_FALSE(timeline.isScanlineStable(scanline)) << "scanline " << scanline;
+    }
+    EXPECT_TRUE(timeline.isScanlineStable(5));
+
+    timeline.finishFrame();
+    EXPECT_EQ(0, timeline.getDroppedEventCount());
+}
+
+TEST(PpuTimelineTest, UnstableScanlines)
+{
+    using enum PpuTimelineEventType;
+    PpuTimeline timeline;
+    // Visible dots change the scanline in progress
+    timeline.record(RegisterWrite, 10, 0, 0, 0x2005, 0x00);
+    timeline.record(RegisterWrite, 20, 255, 0, 0x2001, 0x00);
+    // Later dots change the fetches of the next scanline
+    timeline.record(RegisterWrite, 30, 256, 0, 0x2006, 0x00);
+    timeline.record(ChrBankSwitch, 40, 340, 0, 0x8000, 0x00);
+    // Pre-render scanline is followed by scanline 0
+    timeline.record(RegisterWrite, 261, 320, 0, 0x2000, 0x00);
+    // Next scanline after the last visible one isn't visible
+    timeline.record(RegisterWrite, 239, 300, 0, 0x2001, 0x00);
+    timeline.record(RegisterWrite, 250, 100, 0, 0x2001, 0x00);
+    // Writes into PPUSTATUS have no effect
+    timeline.record(RegisterWrite, 100, 100, 0, 0x2002, 0x00);
+    timeline.finishFrame();
+
+    for (unsigned scanline : { 0u, 10u, 20u, 31u, 41u }) {
+        EXPECT_FALSE(timeline.isScanlineStable(scanline)) << "scanline " << scanline;
+    }
+    for (unsigned scanline : { 21u, 30u, 40u, 100u, 239u }) {
+        EXPECT_TRUE(timeline.isScanlineStable(scanline)) << "scanline " << scanline;
+    }
+    EXPECT_FALSE(timeline.isScanlineStable(240));
+    EXPECT_EQ(PpuTimeline::VISIBLE_SCANLINES - 5, timeline.getStableScanlineCount());
+}
+
+TEST(PpuTimelineTest, Json)
+{
+    PpuTimeline timeline(1);
+    EXPECT_EQ("{\"events\":[],\"droppedEvents\":0,\"unstableScanlines\":[]}", timeline.toJson());
+    timeline.record(PpuTimelineEventType::RegisterWrite, 12, 34, 5678, 0x2001, 0x1E);
+    timeline.record(PpuTimelineEventType::ChrBankSwitch, 100, 300, 5700, 0x8000, 0x02);
+    timeline.finishFrame();
+    EXPECT_EQ("{\"events\":["
+        "{\"type\":\"register\",\"scanline\":12,\"dot\":34,\"cpuCycle\":5678,\"address\":8193,\"value\":30}"
+        "],\"droppedEvents\":1,\"unstableScanlines\":[12,101]}", timeline.toJson());
+}
+
+/**
+ * Events written by the CPU are timestamped with the cycle counted by the bus, which ticks on every cycle of the CPU.
+ */
+TEST(PpuTimelineTest, CpuCycle)
+{
+    SystemUnderTest systemUnderTest;
+    ASSERT_TRUE(systemUnderTest.getCartridge()->loadFromFile(std::ifstream("resources/ppu_tests/palette_ram.nes", std::ios::binary)));
+    auto timeline = std::make_shared<PpuTimeline>();
+    systemUnderTest.getPpu()->setTimeline(timeline);
+    auto* mmu = systemUnderTest.getMmu();
+
+    for (unsigned i = 0; i < 1000; i++) {
+        mmu->readFromMemory(0);
+    }
+    mmu->writeIntoMemory(0x2001, 0x1E);
+    const auto firstCycle = mmu->getCycle();
+    mmu->readFromMemory(0);
+    mmu->writeIntoMemory(0x2005, 0x10);
+    const auto secondCycle = mmu->getCycle();
+    // Run until the VBlank, when the frame is complete
+    while (timeline->getEvents().empty()) {
+        mmu->readFromMemory(0);
+    }
+
+    const auto events = timeline->getEvents();
+    ASSERT_EQ(2, events.size());
+    EXPECT_EQ(firstCycle, events[0].cpuCycle);
+    EXPECT_EQ(0x2001, events[0].address);
+    EXPECT_EQ(secondCycle, events[1].cpuCycle);
+    EXPECT_EQ(firstCycle + 2, secondCycle);
+    // PPU runs 3 dots per CPU cycle
+    EXPECT_EQ(events[0].dot + 6, events[1].dot);
+}
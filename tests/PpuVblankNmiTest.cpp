@@ -1,6 +1,9 @@
 #include "util/BlarggRomTest.hpp"
 
-class PpuVblankNmiTest : public BlarggRomTest
+/**
+ * ROMs are run in each of the PPU render modes that keep the timing visible behaviour.
+ */
+class PpuVblankNmiTest : public BlarggRomTest, public ::testing::WithParamInterface<PpuRenderMode>
 {
     protected:
         PpuVblankNmiTest() = default;
@@ -18,70 +21,75 @@ class PpuVblankNmiTest : public BlarggRomTest
         }
 };
 
-TEST_F(PpuVblankNmiTest, EvenOddFrames)
+TEST_P(PpuVblankNmiTest, EvenOddFrames)
 {
-    auto result = run("resources/ppu_vbl_nmi/even_odd_frames.nes");
+    auto result = run("resources/ppu_vbl_nmi/even_odd_frames.nes", GetParam());
     ASSERT_EQ(0, result) << (result == 0x100 ? "Failed to load ROM" : readMessage());
 }
 
-TEST_F(PpuVblankNmiTest, EvenOddTiming)
+TEST_P(PpuVblankNmiTest, EvenOddTiming)
 {
     GTEST_SKIP() << "Needs attention (Clock is skipped too soon, relative to enabling BG)";
-    auto result = run("resources/ppu_vbl_nmi/even_odd_timing.nes");
+    auto result = run("resources/ppu_vbl_nmi/even_odd_timing.nes", GetParam());
     ASSERT_EQ(0, result) << (result == 0x100 ? "Failed to load ROM" : readMessage());
 }
 
-TEST_F(PpuVblankNmiTest, NmiControl)
+TEST_P(PpuVblankNmiTest, NmiControl)
 {
     GTEST_SKIP() << "Needs attention (Immediate occurence should be after NEXT instruction)";
-    auto result = run("resources/ppu_vbl_nmi/nmi_control.nes");
+    auto result = run("resources/ppu_vbl_nmi/nmi_control.nes", GetParam());
     ASSERT_EQ(0, result) << (result == 0x100 ? "Failed to load ROM" : readMessage());
 }
 
-TEST_F(PpuVblankNmiTest, NmiOffTiming)
+TEST_P(PpuVblankNmiTest, NmiOffTiming)
 {
     GTEST_SKIP() << "Needs attention";
-    auto result = run("resources/ppu_vbl_nmi/nmi_off_timing.nes");
+    auto result = run("resources/ppu_vbl_nmi/nmi_off_timing.nes", GetParam());
     ASSERT_EQ(0, result) << (result == 0x100 ? "Failed to load ROM" : readMessage());
 }
 
-TEST_F(PpuVblankNmiTest, NmiOnTiming)
+TEST_P(PpuVblankNmiTest, NmiOnTiming)
 {
     GTEST_SKIP() << "Needs attention";
-    auto result = run("resources/ppu_vbl_nmi/nmi_on_timing.nes");
+    auto result = run("resources/ppu_vbl_nmi/nmi_on_timing.nes", GetParam());
     ASSERT_EQ(0, result) << (result == 0x100 ? "Failed to load ROM" : readMessage());
 }
 
-TEST_F(PpuVblankNmiTest, NmiTiming)
+TEST_P(PpuVblankNmiTest, NmiTiming)
 {
     GTEST_SKIP() << "Needs attention";
-    auto result = run("resources/ppu_vbl_nmi/nmi_timing.nes");
+    auto result = run("resources/ppu_vbl_nmi/nmi_timing.nes", GetParam());
     ASSERT_EQ(0, result) << (result == 0x100 ? "Failed to load ROM" : readMessage());
 }
 
-TEST_F(PpuVblankNmiTest, Suppression)
+TEST_P(PpuVblankNmiTest, Suppression)
 {
     GTEST_SKIP() << "Needs attention";
-    auto result = run("resources/ppu_vbl_nmi/suppression.nes");
+    auto result = run("resources/ppu_vbl_nmi/suppression.nes", GetParam());
     ASSERT_EQ(0, result) << (result == 0x100 ? "Failed to load ROM" : readMessage());
 }
 
-TEST_F(PpuVblankNmiTest, VblankBasics)
+TEST_P(PpuVblankNmiTest, VblankBasics)
 {
-    auto result = run("resources/ppu_vbl_nmi/vbl_basics.nes");
+    auto result = run("resources/ppu_vbl_nmi/vbl_basics.nes", GetParam());
     ASSERT_EQ(0, result) << (result == 0x100 ? "Failed to load ROM" : readMessage());
 }
 
-TEST_F(PpuVblankNmiTest, VblankClearTime)
+TEST_P(PpuVblankNmiTest, VblankClearTime)
 {
     GTEST_SKIP() << "Needs attention";
-    auto result = run("resources/ppu_vbl_nmi/vbl_clear_time.nes");
+    auto result = run("resources/ppu_vbl_nmi/vbl_clear_time.nes", GetParam());
     ASSERT_EQ(0, result) << (result == 0x100 ? "Failed to load ROM" : readMessage());
 }
 
-TEST_F(PpuVblankNmiTest, VblankSetTime)
+TEST_P(PpuVblankNmiTest, VblankSetTime)
 {
     GTEST_SKIP() << "Needs attention";
-    auto result = run("resources/ppu_vbl_nmi/vbl_set_time.nes");
+    auto result = run("resources/ppu_vbl_nmi/vbl_set_time.nes", GetParam());
     ASSERT_EQ(0, result) << (result == 0x100 ? "Failed to load ROM" : readMessage());
-}
\ No newline at end of file
+}
+
+INSTANTIATE_TEST_SUITE_P(RenderModes, PpuVblankNmiTest, ::testing::Values(PpuRenderMode::Full, PpuRenderMode::TimingOnly),
+    [](const ::testing::TestParamInfo<PpuRenderMode>& info) {
+        return info.param == PpuRenderMode::Full ? "Full" : "TimingOnly";
+    });
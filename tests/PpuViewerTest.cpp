@@ -0,0 +1,126 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+
+#include "../src/core/PpuViewer.hpp"
+#include "util/PpuScene.hpp"
+
+/**
+ * Runs the viewer on the shared scene, which is modified between the refreshes.
+ */
+class PpuViewerTest : public ::testing::Test
+{
+    protected:
+        PpuScene scene;
+        Ppu& ppu;
+
+        PpuViewerTest()
+            : scene()
+            , ppu(scene.getPpu())
+        {
+        }
+
+        ~PpuViewerTest() = default;
+
+        static void expectSameViews(const PpuViewer& expected, const PpuViewer& actual)
+        {
+            const auto sameView = [](const u32* expectedView, const u32* actualView, unsigned width, unsigned height) {
+                return std::memcmp(expectedView, actualView, width * height * sizeof(u32)) == 0;
+            };
+            EXPECT_TRUE(sameView(expected.getPatternTables(), actual.getPatternTables(),
+                PpuViewer::PATTERN_TABLES_WIDTH, PpuViewer::PATTERN_TABLES_HEIGHT));
+            EXPECT_TRUE(sameView(expected.getNametables(), actual.getNametables(),
+                PpuViewer::NAMETABLES_WIDTH, PpuViewer::NAMETABLES_HEIGHT));
+            EXPECT_TRUE(sameView(expected.getSprites(), actual.getSprites(),
+                PpuViewer::SPRITES_WIDTH, PpuViewer::SPRITES_HEIGHT));
+            EXPECT_TRUE(sameView(expected.getPalette(), actual.getPalette(),
+                PpuViewer::PALETTE_WIDTH, PpuViewer::PALETTE_HEIGHT));
+        }
+};
+
+TEST_F(PpuViewerTest, RedrawsOnlyAffectedTiles)
+{
+    scene.setUp();
+    PpuViewer viewer(ppu);
+    viewer.refresh();
+    // Both pattern tables, four nametables and all of the 8x8 sprites
+    EXPECT_EQ(0x200 + 4 * 960 + 64, viewer.getRedrawnTileCount());
+    viewer.refresh();
+    EXPECT_EQ(0, viewer.getRedrawnTileCount());
+
+    // Pattern table, the marked entry in the nametable and its mirror, and the marked sprite
+    scene.writeVram(PpuScene::MARKED_TILE * 16 + 2, 0xA5);
+    scene.setScroll(0x00, 0, 0);
+    viewer.refresh();
+    EXPECT_EQ(1 + 2 + 1, viewer.getRedrawnTileCount());
+
+    // Only the entry in the nametable and its mirror
+    scene.writeVram(0x2000 + 10 * 32 + 12, 2);
+    scene.setScroll(0x00, 0, 0);
+    viewer.refresh();
+    EXPECT_EQ(2, viewer.getRedrawnTileCount());
+
+    // Attribute byte covers 4x4 tiles
+    scene.writeVram(0x23C0 + 1, 0xE4);
+    scene.setScroll(0x00, 0, 0);
+    viewer.refresh();
+    EXPECT_EQ(2 * 16, viewer.getRedrawnTileCount());
+
+    // Pattern of a tile that isn't used anywhere else
+    scene.writeVram(0x1000 + 0xF0 * 16, 0x81);
+    scene.setScroll(0x00, 0, 0);
+    viewer.refresh();
+    EXPECT_EQ(1, viewer.getRedrawnTileCount());
+}
+
+/**
+ * Views updated incrementally have to be the same as views drawn from the scratch.
+ * Scroll window outline moves around, so the pixels it covered have to be restored.
+ */
+TEST_F(PpuViewerTest, IncrementalRefreshMatchesFullRedraw)
+{
+    scene.setUp();
+    PpuViewer viewer(ppu);
+    viewer.refresh();
+
+    struct Step
+    {
+        u16 addr;
+        u8 value;
+        u8 ppuCtrl;
+        u8 scrollX;
+        u8 scrollY;
+    };
+    const Step steps[] = {
+        // Scroll window moves, covered tiles don't change
+        { 0x2000, 0, 0x00, 13, 37 },
+        // Tile under the previous outline changes, outline wraps around to the other nametables
+        { 0x2000 + 4 * 32 + 1, 3, 0x03, 200, 230 },
+        // Pattern of the tile used by the whole background changes
+        { 0x0004, 0xFF, 0x03, 201, 7 },
+        // Background and sprites switch pattern tables
+        { 0x2400 + 29 * 32 + 31, 7, 0x19, 0, 0 },
+        // 8x16 sprites
+        { 0x1002, 0x3C, 0x20, 255, 239 },
+        // Palette entry
+        { 0x3F01, 0x2A, 0x21, 64, 16 },
+        // Universal background color
+        { 0x3F00, 0x0F, 0x21, 64, 16 }
+    };
+    for (const auto& step : steps) {
+        scene.writeVram(step.addr, step.value);
+        scene.setScroll(step.ppuCtrl, step.scrollX, step.scrollY);
+        viewer.refresh();
+        PpuViewer fullRedraw(ppu);
+        fullRedraw.refresh();
+        SCOPED_TRACE(step.addr);
+        expectSameViews(fullRedraw, viewer);
+    }
+    // Pattern table palette is changed separately from the PPU state
+    viewer.setPatternTablePalette(6);
+    viewer.refresh();
+    PpuViewer fullRedraw(ppu);
+    fullRedraw.setPatternTablePalette(6);
+    fullRedraw.refresh();
+    expectSameViews(fullRedraw, viewer);
+}
@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+
+#include <numeric>
+#include <thread>
+#include <vector>
+
+#include "../src/core/RingBuffer.hpp"
+#include "../src/core/ThreadSupport.hpp"
+
+TEST(RingBufferTest, CapacityRoundedToPowerOfTwo)
+{
+    EXPECT_EQ(1, RingBuffer<int>(0).getCapacity());
+    EXPECT_EQ(1, RingBuffer<int>(1).getCapacity());
+    EXPECT_EQ(4, RingBuffer<int>(3).getCapacity());
+    EXPECT_EQ(64, RingBuffer<int>(64).getCapacity());
+    EXPECT_EQ(8192, RingBuffer<int>(4097).getCapacity());
+
+    // Whole rounded capacity can be used
+    RingBuffer<int> buffer(5);
+    const std::vector<int> values(8, 7);
+    EXPECT_EQ(8, buffer.write(values.data(), values.size()));
+    EXPECT_EQ(8, buffer.getSize());
+    EXPECT_EQ(0, buffer.getOverrunCount());
+}
+
+TEST(RingBufferTest, WrapAround)
+{
+    RingBuffer<int> buffer(8);
+    int next = 0;
+    int expected = 0;
+    // Chunks of sizes not dividing the capacity, so that writes and reads are split at the end of the buffer
+    for (unsigned round = 0; round < 50; round++) {
+        std::vector<int> input(5);
+        std::iota(input.begin(), input.end(), next);
+        ASSERT_EQ(5, buffer.write(input.data(), input.size()));
+        next += 5;
+        std::vector<int> output(round % 2 ? 3 : 7);
+        const auto read = buffer.read(output.data(), std::min<unsigned>(output.size(), buffer.getSize()));
+        for (unsigned i = 0; i < read; i++) {
+            ASSERT_EQ(expected++, output[i]) << "round " << round;
+        }
+        ASSERT_EQ(next - expected, buffer.getSize());
+    }
+    EXPECT_EQ(0, buffer.getOverrunCount());
+    EXPECT_EQ(0, buffer.getUnderrunCount());
+}
+
+TEST(RingBufferTest, OverrunAndUnderrun)
+{
+    RingBuffer<int> buffer(4);
+    const int input[6] = { 1, 2, 3, 4, 5, 6 };
+    // Values that don't fit are dropped, each short write is counted once
+    EXPECT_EQ(3, buffer.write(input, 3));
+    EXPECT_EQ(1, buffer.write(input + 3, 3));
+    EXPECT_EQ(1, buffer.getOverrunCount());
+    EXPECT_EQ(0, buffer.write(input, 1));
+    EXPECT_EQ(2, buffer.getOverrunCount());
+    EXPECT_EQ(4, buffer.getSize());
+
+    int output[6] = {};
+    EXPECT_EQ(2, buffer.read(output, 2));
+    EXPECT_EQ(0, buffer.getUnderrunCount());
+    EXPECT_EQ(2, buffer.read(output + 2, 4));
+    EXPECT_EQ(1, buffer.getUnderrunCount());
+    EXPECT_EQ(0, buffer.read(output, 1));
+    EXPECT_EQ(2, buffer.getUnderrunCount());
+    EXPECT_EQ(0, buffer.getSize());
+    EXPECT_EQ(1, output[0]);
+    EXPECT_EQ(4, output[3]);
+    // Nothing requested, nothing missing
+    EXPECT_EQ(0, buffer.read(output, 0));
+    EXPECT_EQ(2, buffer.getUnderrunCount());
+}
+
+/**
+ * Producer writes increasing numbers in chunks of varying size, retrying values that didn't fit.
+ * Consumer has to read every one of them exactly once and in order.
+ * Both threads yield when the buffer is full or empty, so that the test doesn't spin on a single core.
+ */
+TEST(RingBufferTest, ProducerAndConsumerThreads)
+{
+    if (!WASM_NES_THREADS) {
+        GTEST_SKIP() << "Threads are not supported in this build";
+    }
+    static constexpr const u32 VALUE_COUNT = 100000;
+    RingBuffer<u32> buffer(256);
+    std::thread producer([&buffer]() {
+        std::vector<u32> chunk(97);
+        u32 next = 0;
+        while (next < VALUE_COUNT) {
+            const auto size = std::min<u32>(next % chunk.size() + 1, VALUE_COUNT - next);
+            std::iota(chunk.begin(), chunk.begin() + size, next);
+            const auto written = buffer.write(chunk.data(), size);
+            if (written == 0) {
+                std::this_thread::yield();
+            }
+            next += written;
+        }
+    });
+    std::vector<u32> chunk(61);
+    u32 expected = 0;
+    u32 outOfOrder = 0;
+    while (expected < VALUE_COUNT) {
+        const auto read = buffer.read(chunk.data(), chunk.size());
+        if (read == 0) {
+            std::this_thread::yield();
+        }
+        for (unsigned i = 0; i < read; i++) {
+            outOfOrder += chunk[i] != expected++;
+        }
+    }
+    producer.join();
+    EXPECT_EQ(0, outOfOrder);
+    EXPECT_EQ(0, buffer.getSize());
+}
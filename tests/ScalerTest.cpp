@@ -0,0 +1,345 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "../src/video/Scaler.hpp"
+
+/**
+ * Checks the filters of the software scaler against straightforward per-pixel implementations of their rules.
+ * Images are wide enough for the SIMD loops, with widths that leave a few pixels for the scalar tails.
+ */
+class ScalerTest : public ::testing::Test
+{
+    protected:
+        static constexpr const u32 BLACK = 0xFF000000;
+        static constexpr const u32 WHITE = 0xFFFFFFFF;
+        static constexpr const u32 SENTINEL = 0x12345678;
+
+        ScalerTest() = default;
+
+        ~ScalerTest() = default;
+
+        /**
+         * Image with only a few colors, so that the neighbours often match.
+         */
+        static std::vector<u32> patternImage(unsigned width, unsigned height)
+        {
+            static constexpr const u32 COLORS[3] = { BLACK, WHITE, 0xFF2060C0 };
+            std::vector<u32> image(width * height);
+            for (unsigned i = 0; i < image.size(); i++) {
+                image[i] = COLORS[(i * 2654435761u >> 13) % 3];
+            }
+            return image;
+        }
+
+        /**
+         * White diagonal line going from the upper left corner on a black background.
+         */
+        static std::vector<u32> diagonalImage(unsigned size)
+        {
+            std::vector<u32> image(size * size, BLACK);
+            for (unsigned i = 0; i < size; i++) {
+                image[i * size + i] = WHITE;
+            }
+            return image;
+        }
+
+        /**
+         * Lower left half of the image is white, upper right half is black, with a staircase edge along the diagonal.
+         */
+        static std::vector<u32> stepImage(unsigned size)
+        {
+            std::vector<u32> image(size * size, BLACK);
+            for (unsigned y = 0; y < size; y++) {
+                std::fill_n(image.begin() + y * size, y + 1, WHITE);
+            }
+            return image;
+        }
+
+        static std::vector<u32> scale(ScalerFilter filter, const std::vector<u32>& input, unsigned width, unsigned height)
+        {
+            Scaler scaler;
+            scaler.setFilter(filter);
+            const auto factor = scaler.getFactor();
+            std::vector<u32> output(width * height * factor * factor, SENTINEL);
+            scaler.scale(input.data(), width, height, output.data());
+            return output;
+        }
+
+        /**
+         * Pixel of the input with coordinates clamped to the image, edges are extended.
+         */
+        static u32 at(const std::vector<u32>& input, unsigned width, unsigned height, int x, int y)
+        {
+            x = std::clamp(x, 0, int(width) - 1);
+            y = std::clamp(y, 0, int(height) - 1);
+            return input[y * width + x];
+        }
+
+        static std::vector<u32> referenceScale2x(const std::vector<u32>& input, unsigned width, unsigned height)
+        {
+            std::vector<u32> output(width * height * 4);
+            for (int y = 0; y < int(height); y++) {
+                for (int x = 0; x < int(width); x++) {
+                    const auto b = at(input, width, height, x, y - 1);
+                    const auto d = at(input, width, height, x - 1, y);
+                    const auto e = at(input, width, height, x, y);
+                    const auto f = at(input, width, height, x + 1, y);
+                    const auto h = at(input, width, height, x, y + 1);
+                    u32 out[4] = { e, e, e, e };
+                    if (b != h && d != f) {
+                        out[0] = d == b ? d : e;
+                        out[1] = b == f ? f : e;
+                        out[2] = d == h ? d : e;
+                        out[3] = h == f ? f : e;
+                    }
+                    for (unsigned i = 0; i < 4; i++) {
+                        output[(2 * y + i / 2) * 2 * width + 2 * x + i % 2] = out[i];
+                    }
+                }
+            }
+            return output;
+        }
+
+        static std::vector<u32> referenceScale3x(const std::vector<u32>& input, unsigned width, unsigned height)
+        {
+            std::vector<u32> output(width * height * 9);
+            for (int y = 0; y < int(height); y++) {
+                for (int x = 0; x < int(width); x++) {
+                    const auto a = at(input, width, height, x - 1, y - 1);
+                    const auto b = at(input, width, height, x, y - 1);
+                    const auto c = at(input, width, height, x + 1, y - 1);
+                    const auto d = at(input, width, height, x - 1, y);
+                    const auto e = at(input, width, height, x, y);
+                    const auto f = at(input, width, height, x + 1, y);
+                    const auto g = at(input, width, height, x - 1, y + 1);
+                    const auto h = at(input, width, height, x, y + 1);
+                    const auto i = at(input, width, height, x + 1, y + 1);
+                    u32 out[9] = { e, e, e, e, e, e, e, e, e };
+                    if (b != h && d != f) {
+                        out[0] = d == b ? d : e;
+                        out[1] = (d == b && e != c) || (b == f && e != a) ? b : e;
+                        out[2] = b == f ? f : e;
+                        out[3] = (d == b && e != g) || (d == h && e != a) ? d : e;
+                        out[5] = (b == f && e != i) || (h == f && e != c) ? f : e;
+                        out[6] = d == h ? d : e;
+                        out[7] = (d == h && e != i) || (h == f && e != g) ? h : e;
+                        out[8] = h == f ? f : e;
+                    }
+                    for (unsigned k = 0; k < 9; k++) {
+                        output[(3 * y + k / 3) * 3 * width + 3 * x + k % 3] = out[k];
+                    }
+                }
+            }
+            return output;
+        }
+};
+
+TEST_F(ScalerTest, Scale2xDiagonal)
+{
+    static constexpr const unsigned SIZE = 12;
+    const auto output = scale(ScalerFilter::Scale2x, diagonalImage(SIZE), SIZE, SIZE);
+    // Steps of the line are filled in, pixels next to the line get the corner that touches it.
+    // Ends of the line see the extended image edge, so they are not checked.
+    for (unsigned y = 2; y < 2 * (SIZE - 1); y++) {
+        for (unsigned x = 2; x < 2 * (SIZE - 1); x++) {
+            const auto sourceX = x / 2;
+            const auto sourceY = y / 2;
+            const bool white = sourceX == sourceY
+                || (sourceX == sourceY + 1 && x % 2 == 0 && y % 2 == 1)
+                || (sourceY == sourceX + 1 && x % 2 == 1 && y % 2 == 0);
+            ASSERT_EQ(white ? WHITE : BLACK, output[y * 2 * SIZE + x]) << "x " << x << ", y " << y;
+        }
+    }
+}
+
+TEST_F(ScalerTest, Scale3xDiagonal)
+{
+    static constexpr const unsigned SIZE = 12;
+    const auto output = scale(ScalerFilter::Scale3x, diagonalImage(SIZE), SIZE, SIZE);
+    // Only the outer corner touching the line is filled. Pixels on the image edges see the extended edge instead.
+    for (unsigned y = 3; y < 3 * (SIZE - 1); y++) {
+        for (unsigned x = 3; x < 3 * (SIZE - 1); x++) {
+            const auto sourceX = x / 3;
+            const auto sourceY = y / 3;
+            const bool white = sourceX == sourceY
+                || (sourceX == sourceY + 1 && x % 3 == 0 && y % 3 == 2)
+                || (sourceY == sourceX + 1 && x % 3 == 2 && y % 3 == 0);
+            ASSERT_EQ(white ? WHITE : BLACK, output[y * 3 * SIZE + x]) << "x " << x << ", y " << y;
+        }
+    }
+}
+
+TEST_F(ScalerTest, Xbr2xStepEdge)
+{
+    static constexpr const unsigned SIZE = 12;
+    // Both colors blended half and half, the alpha stays opaque
+    static constexpr const u32 HALF = 0xFF7F7F7F;
+    const auto output = scale(ScalerFilter::Xbr2x, stepImage(SIZE), SIZE, SIZE);
+    // Edge at 45 degrees is smoothed by blending the corners that touch it on both sides of the edge.
+    // Ends of the edge see the extended image edge, so they are not checked.
+    for (unsigned y = 2; y < 2 * (SIZE - 1); y++) {
+        for (unsigned x = 2; x < 2 * (SIZE - 1); x++) {
+            const auto sourceX = x / 2;
+            const auto sourceY = y / 2;
+            const bool blended = (sourceX == sourceY && x % 2 == 1 && y % 2 == 0)
+                || (sourceX == sourceY + 1 && x % 2 == 0 && y % 2 == 1);
+            const auto expected = blended ? HALF : sourceX <= sourceY ? WHITE : BLACK;
+            ASSERT_EQ(expected, output[y * 2 * SIZE + x]) << "x " << x << ", y " << y;
+        }
+    }
+}
+
+TEST_F(ScalerTest, MatchesReferenceRules)
+{
+    for (unsigned width : { 7u, 18u, 37u }) {
+        const unsigned height = 9;
+        const auto input = patternImage(width, height);
+        EXPECT_EQ(referenceScale2x(input, width, height), scale(ScalerFilter::Scale2x, input, width, height)) << "width " << width;
+        EXPECT_EQ(referenceScale3x(input, width, height), scale(ScalerFilter::Scale3x, input, width, height)) << "width " << width;
+    }
+}
+
+TEST_F(ScalerTest, Nearest)
+{
+    const auto input = patternImage(13, 5);
+    for (unsigned factor : { 1u, 2u, 3u }) {
+        Scaler scaler;
+        scaler.setFilter(ScalerFilter::Nearest, factor);
+        std::vector<u32> output(13 * 5 * factor * factor);
+        scaler.scale(input.data(), 13, 5, output.data());
+        for (unsigned y = 0; y < 5 * factor; y++) {
+            for (unsigned x = 0; x < 13 * factor; x++) {
+                ASSERT_EQ(input[y / factor * 13 + x / factor], output[y * 13 * factor + x]) << "factor " << factor;
+            }
+        }
+    }
+}
+
+/**
+ * Filter and factor come from the frontend, so values out of range must not reach the scaler.
+ */
+TEST_F(ScalerTest, InvalidSettings)
+{
+    Scaler scaler;
+    EXPECT_TRUE(scaler.setFilter(ScalerFilter::Scale3x));
+    EXPECT_FALSE(scaler.setFilter(static_cast<ScalerFilter>(4)));
+    EXPECT_FALSE(scaler.setFilter(static_cast<ScalerFilter>(-1)));
+    EXPECT_EQ(ScalerFilter::Scale3x, scaler.getFilter());
+    EXPECT_EQ(3, scaler.getFactor());
+
+    EXPECT_TRUE(scaler.setFilter(ScalerFilter::Nearest, 0));
+    EXPECT_EQ(1, scaler.getFactor());
+    EXPECT_TRUE(scaler.setFilter(ScalerFilter::Nearest, 100000));
+    EXPECT_EQ(Scaler::MAX_NEAREST_FACTOR, scaler.getFactor());
+}
+
+TEST_F(ScalerTest, FlatImageStaysFlat)
+{
+    const std::vector<u32> input(16 * 16, 0xFF336699);
+    for (auto filter : { ScalerFilter::Scale2x, ScalerFilter::Scale3x, ScalerFilter::Xbr2x }) {
+        const auto output = scale(filter, input, 16, 16);
+        EXPECT_TRUE(std::all_of(output.begin(), output.end(), [](u32 pixel) { return pixel == 0xFF336699; }));
+    }
+}
+
+/**
+ * Presenter only scales the rows that changed, extended by the margin of the filter.
+ * Such rows have to be the same as if the whole frame was scaled, rows outside of the range are left untouched.
+ */
+TEST_F(ScalerTest, RowRangeMatchesWholeFrame)
+{
+    static constexpr const unsigned WIDTH = 40;
+    static constexpr const unsigned HEIGHT = 30;
+    const auto input = patternImage(WIDTH, HEIGHT);
+    for (auto filter : { ScalerFilter::Nearest, ScalerFilter::Scale2x, ScalerFilter::Scale3x, ScalerFilter::Xbr2x }) {
+        const auto whole = scale(filter, input, WIDTH, HEIGHT);
+        Scaler scaler;
+        scaler.setFilter(filter);
+        const auto factor = scaler.getFactor();
+        const auto outputRowSize = WIDTH * factor * factor;
+        for (auto [firstRow, rowCount] : { std::pair { 0u, 3u }, std::pair { 11u, 5u }, std::pair { 27u, 3u } }) {
+            std::vector<u32> output(whole.size(), SENTINEL);
+            scaler.scale(input.data(), WIDTH, HEIGHT, firstRow, rowCount, output.data());
+            for (unsigned row = 0; row < HEIGHT; row++) {
+                const auto begin = row * outputRowSize;
+                const bool inRange = row >= firstRow && row < firstRow + rowCount;
+                if (inRange) {
+                    EXPECT_TRUE(std::equal(whole.begin() + begin, whole.begin() + begin + outputRowSize, output.begin() + begin))
+                        << "filter " << static_cast<int>(filter) << ", row " << row;
+                } else {
+                    EXPECT_TRUE(std::all_of(output.begin() + begin, output.begin() + begin + outputRowSize,
+                        [](u32 pixel) { return pixel == SENTINEL; }))
+                        << "filter " << static_cast<int>(filter) << ", row " << row;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * xBR weights are computed 4 pixels at a time, except for the pixels close to the edges of the row.
+ * The same picture has to be scaled the same way, regardless of the lane or the edge loop it ends up in.
+ */
+TEST_F(ScalerTest, Xbr2xDoesNotDependOnPosition)
+{
+    static constexpr const unsigned WIDTH = 23;
+    static constexpr const unsigned HEIGHT = 12;
+    static constexpr const unsigned PICTURE_SIZE = 8;
+    const auto picture = patternImage(PICTURE_SIZE, PICTURE_SIZE);
+    std::vector<u32> expected;
+    // Picture is surrounded by at least 2 pixels of black, so that the extended edges are never seen
+    for (unsigned offset = 2; offset + PICTURE_SIZE + 2 <= WIDTH; offset++) {
+        std::vector<u32> input(WIDTH * HEIGHT, BLACK);
+        for (unsigned y = 0; y < PICTURE_SIZE; y++) {
+            std::copy_n(picture.begin() + y * PICTURE_SIZE, PICTURE_SIZE, input.begin() + (y + 2) * WIDTH + offset);
+        }
+        const auto output = scale(ScalerFilter::Xbr2x, input, WIDTH, HEIGHT);
+        std::vector<u32> scaled;
+        for (unsigned y = 0; y < 2 * (PICTURE_SIZE + 2); y++) {
+            const auto row = output.begin() + (y + 2) * 2 * WIDTH + 2 * (offset - 1);
+            scaled.insert(scaled.end(), row, row + 2 * (PICTURE_SIZE + 2));
+        }
+        if (expected.empty()) {
+            expected = scaled;
+        }
+        EXPECT_EQ(expected, scaled) << "offset " << offset;
+    }
+}
+
+/**
+ * Bands scaled by the workers have to meet without gaps or overlaps, whatever the amount of threads is.
+ */
+TEST_F(ScalerTest, ThreadsMatchSingleThread)
+{
+    static constexpr const unsigned WIDTH = 64;
+    static constexpr const unsigned HEIGHT = 100;
+    const auto input = patternImage(WIDTH, HEIGHT);
+    for (auto filter : { ScalerFilter::Nearest, ScalerFilter::Scale2x, ScalerFilter::Scale3x, ScalerFilter::Xbr2x }) {
+        Scaler single(0);
+        single.setFilter(filter);
+        const auto factor = single.getFactor();
+        std::vector<u32> expected(WIDTH * HEIGHT * factor * factor, SENTINEL);
+        single.scale(input.data(), WIDTH, HEIGHT, expected.data());
+        for (unsigned threadCount = 1; threadCount <= Scaler::MAX_THREAD_COUNT; threadCount++) {
+            Scaler scaler(threadCount);
+            scaler.setFilter(filter);
+            EXPECT_EQ(threadCount, scaler.getThreadCount());
+            for (auto [firstRow, rowCount] : { std::pair { 0u, HEIGHT }, std::pair { 7u, 61u }, std::pair { 90u, 20u } }) {
+                std::vector<u32> output(expected.size(), SENTINEL);
+                scaler.scale(input.data(), WIDTH, HEIGHT, firstRow, rowCount, output.data());
+                const auto outputRowSize = WIDTH * factor * factor;
+                for (unsigned row = 0; row < HEIGHT; row++) {
+                    const auto begin = row * outputRowSize;
+                    const bool inRange = row >= firstRow && row < firstRow + rowCount;
+                    ASSERT_TRUE(inRange
+                        ? std::equal(output.begin() + begin, output.begin() + begin + outputRowSize, expected.begin() + begin)
+                        : std::all_of(output.begin() + begin, output.begin() + begin + outputRowSize,
+                            [](u32 pixel) { return pixel == SENTINEL; }))
+                        << "filter " << static_cast<int>(filter) << ", threads " << threadCount << ", row " << row;
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include "../src/core/TripleBuffer.hpp"
+#include "../src/core/ThreadSupport.hpp"
+
+TEST(TripleBufferTest, AcquireNeverReturnsBackBuffer)
+{
+    TripleBuffer<int> buffer;
+    EXPECT_FALSE(buffer.hasFresh());
+    EXPECT_NE(&buffer.back(), &buffer.acquire());
+    for (int i = 1; i <= 10; i++) {
+        buffer.back() = i;
+        buffer.publish();
+        EXPECT_TRUE(buffer.hasFresh());
+        const auto& front = buffer.acquire();
+        EXPECT_FALSE(buffer.hasFresh());
+        EXPECT_EQ(i, front);
+        EXPECT_NE(&buffer.back(), &front);
+    }
+}
+
+TEST(TripleBufferTest, PublishReplacesStaleFreshBuffer)
+{
+    TripleBuffer<int> buffer;
+    buffer.back() = 1;
+    buffer.publish();
+    buffer.back() = 2;
+    buffer.publish();
+    // Producer gets the buffer of the frame that was never acquired
+    buffer.back() = 3;
+    EXPECT_TRUE(buffer.hasFresh());
+    EXPECT_EQ(2, buffer.acquire());
+}
+
+TEST(TripleBufferTest, AcquireWithoutPublishReturnsSameBuffer)
+{
+    TripleBuffer<int> buffer;
+    buffer.back() = 1;
+    buffer.publish();
+    const auto* first = &buffer.acquire();
+    buffer.back() = 2;
+    EXPECT_FALSE(buffer.hasFresh());
+    EXPECT_EQ(first, &buffer.acquire());
+    EXPECT_EQ(1, *first);
+}
+
+/**
+ * Producer fills each buffer with the number of the frame before publishing it,
+ * consumer must only ever see complete frames, in increasing order.
+ */
+TEST(TripleBufferTest, ProducerAndConsumerThreads)
+{
+    if (!WASM_NES_THREADS) {
+        GTEST_SKIP() << "Threads are not supported in this build";
+    }
+    static constexpr const unsigned FRAME_COUNT = 100000;
+    TripleBuffer<std::array<unsigned, 64>> buffer;
+    std::thread producer([&buffer]() {
+        for (unsigned frame = 1; frame <= FRAME_COUNT; frame++) {
+            buffer.back().fill(frame);
+            buffer.publish();
+        }
+    });
+    unsigned lastFrame = 0;
+    unsigned tornFrames = 0;
+    while (lastFrame < FRAME_COUNT) {
+        const auto& front = buffer.acquire();
+        const auto frame = front[0];
+        for (auto value : front) {
+            tornFrames += value != frame;
+        }
+        ASSERT_GE(frame, lastFrame);
+        if (frame == lastFrame) {
+            // Nothing new was published, give the producer a chance to run
+            std::this_thread::yield();
+        }
+        lastFrame = frame;
+    }
+    producer.join();
+    EXPECT_EQ(0, tornFrames);
+}
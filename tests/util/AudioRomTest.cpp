@@ -0,0 +1,77 @@
+#include "AudioRomTest.hpp"
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+
+#include "../../src/core/apu/FileAudioSink.hpp"
+
+namespace
+{
+    /**
+     * Passes the samples to the fingerprint and optionally also to a file.
+     */
+    class SplitAudioSink : public AudioSink
+    {
+        public:
+            SplitAudioSink(AudioSink& first, AudioSink* second)
+                : first(first)
+                , second(second)
+            {
+            }
+
+            void write(const float* samples, unsigned count) override
+            {
+                first.write(samples, count);
+                if (second) {
+                    second->write(samples, count);
+                }
+            }
+
+        private:
+            AudioSink& first;
+            AudioSink* second;
+    };
+}
+
+void AudioRomTest::SetUp()
+{
+    systemUnderTest = std::make_unique<SystemUnderTest>();
+}
+
+void AudioRomTest::TearDown()
+{
+}
+
+/**
+ * Runs the rom for the given amount of frames and returns the fingerprint of the produced audio.
+ * Samples are taken from the audio buffer after every instruction, so it never overflows.
+ */
+AudioFingerprint AudioRomTest::render(const std::string& romFileName, unsigned frames)
+{
+    auto cartridge = systemUnderTest->getCartridge();
+    auto cpu = systemUnderTest->getCpu();
+    auto apu = systemUnderTest->getApu();
+    systemUnderTest->getPpu()->setRenderMode(PpuRenderMode::TimingOnly);
+    if (!cartridge->loadFromFile(std::ifstream(romFileName, std::ios::binary))) {
+        ADD_FAILURE() << "Failed to load ROM " << romFileName;
+        return {};
+    }
+
+    FingerprintAudioSink fingerprintSink;
+    std::unique_ptr<FileAudioSink> fileSink;
+    if (const char* dumpDirectory = std::getenv("AUDIO_DUMP_DIRECTORY")) {
+        const auto filename = std::filesystem::path(dumpDirectory) / std::filesystem::path(romFileName).stem();
+        fileSink = std::make_unique<FileAudioSink>(filename.string() + ".wav", AudioFileFormat::Wav, apu->getSampleRate());
+    }
+
+    SplitAudioSink sink(fingerprintSink, fileSink.get());
+
+    cpu->reset();
+    const auto cycles = static_cast<u64>(frames * CPU_CYCLES_PER_FRAME);
+    for (u64 elapsedCycles = 0; elapsedCycles < cycles;) {
+        elapsedCycles += cpu->step();
+        apu->writeAudio(sink);
+    }
+    return fingerprintSink.getFingerprint();
+}
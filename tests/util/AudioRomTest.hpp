@@ -0,0 +1,33 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include "SystemUnderTest.hpp"
+#include "FingerprintAudioSink.hpp"
+
+/**
+ * Test that renders the audio of a rom and compares its fingerprint with the stored one.
+ * Fingerprint is made of a few statistics of the samples, which are compared with a tolerance,
+ * as the last bits of the floating point math differ between the native and the Emscripten builds.
+ *
+ * When the AUDIO_DUMP_DIRECTORY environment variable is set, rendered audio is also written there as WAV files,
+ * so that it can be listened to.
+ */
+class AudioRomTest : public ::testing::Test
+{
+    public:
+        // NTSC frame lasts 341 * 262 - 0.5 PPU dots, 3 of them per CPU cycle
+        static constexpr const double CPU_CYCLES_PER_FRAME = 29780.5;
+
+        std::unique_ptr<SystemUnderTest> systemUnderTest;
+
+        AudioRomTest() = default;
+
+        virtual ~AudioRomTest() = default;
+
+        virtual void SetUp() override;
+
+        virtual void TearDown() override;
+
+        AudioFingerprint render(const std::string& romFileName, unsigned frames);
+};
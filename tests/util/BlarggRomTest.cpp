@@ -11,11 +11,13 @@ void BlarggRomTest::TearDown()
 {
 }
 
-unsigned BlarggRomTest::run(std::string romFileName)
+unsigned BlarggRomTest::run(std::string romFileName, PpuRenderMode renderMode)
 {
     auto cartridge = systemUnderTest->getCartridge();
     auto cpu = systemUnderTest->getCpu();
     auto mmu = systemUnderTest->getMmu();
+    // ROMs render in full by default, so that they cover sprite 0 hit and clipping of the pixel path as well
+    systemUnderTest->getPpu()->setRenderMode(renderMode);
     if(!cartridge->loadFromFile(std::ifstream(romFileName, std::ios::binary))) {
         return 0x100;
     }
@@ -25,7 +25,7 @@ class BlarggRomTest : public ::testing::Test
 
         virtual void TearDown() override;
 
-        unsigned run(std::string romFileName);
+        unsigned run(std::string romFileName, PpuRenderMode renderMode = PpuRenderMode::Full);
 
         std::string readMessage();
 };
\ No newline at end of file
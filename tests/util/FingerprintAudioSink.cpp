@@ -0,0 +1,43 @@
+#include "FingerprintAudioSink.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+FingerprintAudioSink::FingerprintAudioSink()
+    : sampleCount(0)
+    , previousSample(0.0f)
+    , sumOfSquares(0.0)
+    , sumOfDifferenceSquares(0.0)
+    , blockSumOfSquares(0.0)
+    , envelope()
+{
+}
+
+void FingerprintAudioSink::write(const float* samples, unsigned count)
+{
+    for (unsigned i = 0; i < count; i++) {
+        const auto sample = std::clamp(samples[i], -1.0f, 1.0f);
+        const double difference = sample - previousSample;
+        sumOfSquares += double(sample) * sample;
+        sumOfDifferenceSquares += difference * difference;
+        blockSumOfSquares += double(sample) * sample;
+        previousSample = sample;
+        if (++sampleCount % ENVELOPE_BLOCK_SIZE == 0) {
+            envelope.push_back(std::sqrt(blockSumOfSquares / ENVELOPE_BLOCK_SIZE));
+            blockSumOfSquares = 0.0;
+        }
+    }
+}
+
+/**
+ * Last block of the envelope is left out when it is not complete.
+ */
+AudioFingerprint FingerprintAudioSink::getFingerprint() const
+{
+    return AudioFingerprint {
+        .sampleCount = sampleCount,
+        .rms = sampleCount > 0 ? std::sqrt(sumOfSquares / sampleCount) : 0.0,
+        .differenceRms = sampleCount > 0 ? std::sqrt(sumOfDifferenceSquares / sampleCount) : 0.0,
+        .envelope = envelope
+    };
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <vector>
+
+#include "../../src/core/apu/AudioSink.hpp"
+#include "../../src/core/Types.hpp"
+
+/**
+ * Summary of the rendered audio. RMS tells the loudness, RMS of the differences between consecutive samples
+ * tells how much of it is in the high frequencies, and the envelope made of RMS of consecutive blocks
+ * tells when the sound is played. None of them depends on the last bits of the floating point math,
+ * so they can be compared with a small tolerance.
+ */
+struct AudioFingerprint
+{
+    u64 sampleCount;
+    double rms;
+    double differenceRms;
+    std::vector<double> envelope;
+};
+
+/**
+ * Computes the fingerprint of the samples without storing them.
+ */
+class FingerprintAudioSink : public AudioSink
+{
+    public:
+        static constexpr const unsigned ENVELOPE_BLOCK_SIZE = 32768;
+
+        FingerprintAudioSink();
+
+        ~FingerprintAudioSink() override = default;
+
+        void write(const float* samples, unsigned count) override;
+
+        AudioFingerprint getFingerprint() const;
+
+    private:
+        u64 sampleCount;
+        float previousSample;
+        double sumOfSquares;
+        double sumOfDifferenceSquares;
+        double blockSumOfSquares;
+        std::vector<double> envelope;
+};
@@ -0,0 +1,60 @@
+#include "PpuScene.hpp"
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+
+PpuScene::PpuScene(const std::function<void()>& vblankCallback)
+    : cartridge(std::make_shared<Cartridge>())
+    , ppu(cartridge, []() {}, vblankCallback)
+{
+    EXPECT_TRUE(cartridge->loadFromFile(std::ifstream("resources/ppu_tests/palette_ram.nes", std::ios::binary)));
+}
+
+Ppu& PpuScene::getPpu()
+{
+    return ppu;
+}
+
+void PpuScene::setUp()
+{
+    for (u16 addr = 0; addr < 0x100; addr++) {
+        writeVram(addr, static_cast<u8>(addr * 0x35 ^ (addr >> 3)));
+        writeVram(0x1000 + addr, static_cast<u8>(addr * 0x17 + 1));
+    }
+    // Both nametables of the horizontal mirroring
+    for (u16 addr = 0x2000; addr < 0x2800; addr += 0x400) {
+        for (u16 offset = 0; offset < 0x3C0; offset++) {
+            writeVram(addr + offset, 0);
+        }
+        for (u16 offset = 0x3C0; offset < 0x400; offset++) {
+            writeVram(addr + offset, static_cast<u8>(offset * 0x1B));
+        }
+    }
+    writeVram(MARKED_NAMETABLE_ENTRY, MARKED_TILE);
+    for (u16 index = 0; index < 32; index++) {
+        writeVram(0x3F00 + index, static_cast<u8>((index * 5 + 1) & 0x3F));
+    }
+    ppu.write(3, 0);
+    for (unsigned sprite = 0; sprite < 64; sprite++) {
+        ppu.write(4, static_cast<u8>(sprite * 3));
+        ppu.write(4, sprite == MARKED_SPRITE ? MARKED_TILE : 1);
+        ppu.write(4, static_cast<u8>((sprite & 3) | ((sprite & 0x0C) << 4)));
+        ppu.write(4, static_cast<u8>(sprite * 4));
+    }
+    setScroll(0x00, 0, 0);
+}
+
+void PpuScene::writeVram(u16 addr, u8 value)
+{
+    ppu.write(6, addr >> 8);
+    ppu.write(6, addr & 0xFF);
+    ppu.write(7, value);
+}
+
+void PpuScene::setScroll(u8 ppuCtrl, u8 x, u8 y)
+{
+    ppu.write(0, ppuCtrl);
+    ppu.write(5, x);
+    ppu.write(5, y);
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+
+#include "../../src/core/Ppu.hpp"
+#include "../../src/core/Cartridge.hpp"
+
+/**
+ * PPU with CHR RAM, which is written directly through the PPU registers.
+ * Scene fills the first 16 tiles of both pattern tables and the palette, nametables only use tile 0
+ * except of the marked entry, sprites only use tile 1 except of the marked sprite.
+ * Rendering is left disabled, so that the memory can be written at any time.
+ */
+class PpuScene
+{
+    public:
+        // Tile drawn in a single place of the nametable and used by a single sprite
+        static constexpr const u8 MARKED_TILE = 5;
+        static constexpr const u16 MARKED_NAMETABLE_ENTRY = 0x2000 + 3 * 32 + 7;
+        static constexpr const unsigned MARKED_SPRITE = 3;
+
+        explicit PpuScene(const std::function<void()>& vblankCallback = []() {});
+
+        ~PpuScene() = default;
+
+        Ppu& getPpu();
+
+        void setUp();
+
+        void writeVram(u16 addr, u8 value);
+
+        void setScroll(u8 ppuCtrl, u8 x, u8 y);
+
+    private:
+        std::shared_ptr<Cartridge> cartridge;
+        Ppu ppu;
+};
@@ -1,7 +1,7 @@
 #include "SystemUnderTest.hpp"
 
 SystemUnderTest::SystemUnderTest()
-    : apu(std::make_shared<Apu>([&](){ cpu->interrupt(InterruptType::IRQ); }))
+    : apu(std::make_shared<Apu>())
     , controllers(std::make_shared<Controllers>())
     , cartridge(std::make_shared<Cartridge>())
     , ppu(std::make_shared<Ppu>(cartridge, [&](){ cpu->interrupt(InterruptType::NMI); }, [](){}))